@@ -37,23 +37,41 @@
 #endif
 
 #include <QAbstractItemModel>
+#include <QDateTime>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <QIODevice>
 #include <QLabel>
 #include <QModelIndex>
+#include <QtEndian>
 #include <QTextEdit>
 #include <QtPlugin>
 #include <QVBoxLayout>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 namespace {
 
 const char mimeEncryptedData[] = "application/x-copyq-encrypted";
 
 const char dataFileHeader[] = "CopyQ_encrypted_tab";
 const char dataFileHeaderV2[] = "CopyQ_encrypted_tab v2";
+const char dataFileHeaderV3[] = "CopyQ_encrypted_tab v3";
 
 const int maxItemCount = 10000;
 
+// Each chunk in tab data needs to be decrypted separately when loading the tab.
+const int maxChunkCount = 8;
+
+struct ItemPosition {
+    quint32 chunk;
+    quint32 index;
+};
+
 struct KeyPairPaths {
     KeyPairPaths()
     {
@@ -149,11 +167,18 @@ QString importGpgKey()
 {
     KeyPairPaths keys;
 
+    // Import the key only once unless it changes.
+    static QDateTime importedKeyTime;
+    const QDateTime keyTime = QFileInfo(keys.sec).lastModified();
+    if ( keyTime.isValid() && keyTime == importedKeyTime )
+        return QString();
+
     QProcess p;
     p.start(gpgExecutable(), getDefaultEncryptCommandArguments(keys.pub) << "--import" << keys.sec);
     if ( !verifyProcess(&p) )
         return "Failed to import private key (see log).";
 
+    importedKeyTime = keyTime;
     return QString();
 }
 
@@ -184,14 +209,14 @@ QString exportGpgKey()
     return QString();
 }
 
-QByteArray readGpgOutput(const QStringList &args, const QByteArray &input = QByteArray())
+QByteArray readGpgOutput(const QStringList &args, const QByteArray &input = QByteArray(), int timeoutMs = 30000)
 {
     QProcess p;
     startGpgProcess(&p, args, QIODevice::ReadWrite);
     p.write(input);
     p.closeWriteChannel();
-    p.waitForFinished();
-    verifyProcess(&p);
+    p.waitForFinished(timeoutMs);
+    verifyProcess(&p, timeoutMs);
     return p.readAllStandardOutput();
 }
 
@@ -200,6 +225,529 @@ bool keysExist()
     return !readGpgOutput( QStringList("--list-keys") ).isEmpty();
 }
 
+QString readDataFileHeader(QIODevice *file)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    QString header;
+    stream >> header;
+
+    return stream.status() == QDataStream::Ok ? header : QString();
+}
+
+quint64 itemKey(quint32 chunkIndex, quint32 itemIndex)
+{
+    return (static_cast<quint64>(chunkIndex) << 32) | itemIndex;
+}
+
+/// Returns number of items from the chunk which are still in model.
+int liveItemCount(const EncryptedChunk &chunk)
+{
+    return static_cast<int>( std::count_if(
+        std::begin(chunk.rows), std::end(chunk.rows),
+        [](const QPersistentModelIndex &index) { return index.isValid(); }) );
+}
+
+/**
+ * Returns true if rows with items from the chunk did not change.
+ *
+ * Items removed from model (usually the oldest ones) are kept in the chunk
+ * and ignored when loading, unless they take most of the chunk.
+ */
+bool isChunkReusable(const EncryptedChunk &chunk)
+{
+    return !chunk.changed && 2 * liveItemCount(chunk) >= chunk.itemCount;
+}
+
+/// Forgets rows with items removed from model.
+void removeInvalidRows(EncryptedChunk *chunk)
+{
+    for (int i = chunk->rows.size() - 1; i >= 0; --i) {
+        if ( !chunk->rows[i].isValid() ) {
+            chunk->rows.remove(i);
+            chunk->rowItems.remove(i);
+        }
+    }
+}
+
+/**
+ * Finds offsets of chunks in tab file.
+ *
+ * Returns false if the file does not contain the expected chunks
+ * (e.g. the last save failed or the file was replaced).
+ */
+bool findChunks(QIODevice *file, const EncryptedChunks &chunks, QVector<qint64> *offsets)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    QString header;
+    quint32 chunkCount;
+    stream >> header >> chunkCount;
+    if ( stream.status() != QDataStream::Ok || header != dataFileHeaderV3
+         || chunkCount != static_cast<quint32>(chunks.size()) )
+    {
+        return false;
+    }
+
+    for (const auto &chunk : chunks) {
+        offsets->append( file->pos() );
+        quint32 size;
+        stream >> size;
+        if ( stream.status() != QDataStream::Ok || size != chunk.size
+             || stream.skipRawData(static_cast<int>(size)) != static_cast<int>(size) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Copies encrypted chunk (with its size) from previous tab file.
+bool copyChunk(QIODevice *from, qint64 offset, quint32 size, QIODevice *to)
+{
+    if ( !from->seek(offset) )
+        return false;
+
+    char buffer[4096];
+    qint64 remaining = static_cast<qint64>(size) + 4;
+    while (remaining > 0) {
+        const qint64 bytesRead = from->read( buffer, qMin(remaining, static_cast<qint64>(sizeof(buffer))) );
+        if ( bytesRead <= 0 || to->write(buffer, bytesRead) != bytesRead )
+            return false;
+        remaining -= bytesRead;
+    }
+
+    return true;
+}
+
+template <typename T>
+QByteArray serializeValue(const T &value)
+{
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream << value;
+    return bytes;
+}
+
+/**
+ * Writes available output of gpg process to file.
+ *
+ * Adds number of written bytes to @a size.
+ */
+bool writeGpgOutput(QProcess *p, QIODevice *output, quint32 *size)
+{
+    const QByteArray bytes = p->readAllStandardOutput();
+    if ( bytes.isEmpty() )
+        return true;
+
+    if ( static_cast<quint64>(*size) + static_cast<quint64>(bytes.size()) >= 0xFFFFFFFF )
+        return false;
+
+    *size += static_cast<quint32>(bytes.size());
+    return output->write(bytes) == bytes.size();
+}
+
+/**
+ * Writes input for gpg process and writes available output to file.
+ *
+ * Waits until the input is consumed so data can be passed to gpg
+ * in small parts without buffering all of it in memory.
+ */
+bool writeGpgInput(QProcess *p, const QByteArray &input, QIODevice *output, quint32 *outputSize)
+{
+    p->write(input);
+
+    while ( p->bytesToWrite() > 0 ) {
+        if ( !p->waitForBytesWritten() || !writeGpgOutput(p, output, outputSize) )
+            return false;
+    }
+
+    return writeGpgOutput(p, output, outputSize);
+}
+
+/**
+ * Passes encrypted data from part of a file to gpg process.
+ *
+ * Only a small part of the data is buffered at a time.
+ */
+class GpgFileInput final {
+public:
+    GpgFileInput(QProcess *process, QIODevice *file, qint64 offset, qint64 size)
+        : m_process(process)
+        , m_file(file)
+        , m_pos(offset)
+        , m_remaining(size)
+        , m_closed(false)
+    {
+    }
+
+    /// Writes more data if the process consumed most of the previous ones.
+    bool write()
+    {
+        const qint64 blockSize = 64 * 1024;
+        while ( m_remaining > 0 && m_process->bytesToWrite() < blockSize ) {
+            if ( !m_file->seek(m_pos) )
+                return false;
+
+            const QByteArray bytes = m_file->read( qMin(m_remaining, blockSize) );
+            if ( bytes.isEmpty() )
+                return false;
+
+            m_process->write(bytes);
+            m_pos += bytes.size();
+            m_remaining -= bytes.size();
+        }
+
+        if ( m_remaining == 0 && !m_closed ) {
+            m_process->closeWriteChannel();
+            m_closed = true;
+        }
+
+        return true;
+    }
+
+    bool atEnd() const { return m_remaining == 0; }
+
+private:
+    QProcess *m_process;
+    QIODevice *m_file;
+    qint64 m_pos;
+    qint64 m_remaining;
+    bool m_closed;
+};
+
+/**
+ * Passes encrypted data from file to gpg and reads decrypted data as they arrive.
+ *
+ * Waits for password entry dialog (no timeout).
+ */
+template <typename AddOutput>
+bool decryptFromFile(QProcess *p, GpgFileInput *input, AddOutput addOutput)
+{
+    for (;;) {
+        if ( !input->write() )
+            return false;
+
+        const bool ready = p->bytesToWrite() > 0
+                ? p->waitForBytesWritten(-1)
+                : p->waitForReadyRead(-1);
+
+        if ( !addOutput(p->readAllStandardOutput()) )
+            return false;
+
+        if (!ready)
+            break;
+    }
+
+    // Process finished or failed before reading all data.
+    if ( !input->atEnd() ) {
+        p->kill();
+        p->waitForFinished();
+        return false;
+    }
+
+    return addOutput( p->readAllStandardOutput() ) && verifyProcess(p, -1);
+}
+
+/**
+ * Parses decrypted chunk data as it arrives from gpg.
+ *
+ * Chunk data contains order of all items in tab (valid only in the last chunk)
+ * followed by items stored in the chunk.
+ */
+class DecryptedChunkParser final {
+public:
+    DecryptedChunkParser()
+        : m_state(ReadRowCount)
+        , m_failed(false)
+        , m_rowCount(0)
+        , m_itemCount(0)
+        , m_parsedItemCount(0)
+    {
+    }
+
+    /// Parses complete records and keeps the rest for later; returns false if data are corrupted.
+    bool addData(const QByteArray &bytes)
+    {
+        m_buffer.append(bytes);
+
+        int pos = 0;
+        while ( !m_failed && parseNext(&pos) ) {}
+        m_buffer.remove(0, pos);
+
+        return !m_failed;
+    }
+
+    bool isComplete() const { return m_state == Done && m_buffer.isEmpty(); }
+
+    bool hasOrder() const { return m_state == ReadItemCount || m_state == ReadItems || m_state == Done; }
+
+    const QVector<ItemPosition> &order() const { return m_order; }
+
+    /// Returns items parsed since last call.
+    QVector<QVariantMap> takeItems()
+    {
+        QVector<QVariantMap> items;
+        items.swap(m_items);
+        return items;
+    }
+
+    int itemCount() const { return m_parsedItemCount; }
+
+private:
+    enum State {
+        ReadRowCount,
+        ReadPositions,
+        ReadItemCount,
+        ReadItems,
+        Done
+    };
+
+    bool readUInt32(int *pos, quint32 *value) const
+    {
+        if (m_buffer.size() - *pos < 4)
+            return false;
+        *value = qFromBigEndian<quint32>( reinterpret_cast<const uchar *>(m_buffer.constData() + *pos) );
+        *pos += 4;
+        return true;
+    }
+
+    bool parseNext(int *pos)
+    {
+        quint32 value;
+
+        switch (m_state) {
+        case ReadRowCount:
+            if ( !readUInt32(pos, &m_rowCount) )
+                return false;
+            m_order.reserve( static_cast<int>(qMin(m_rowCount, static_cast<quint32>(maxItemCount))) );
+            m_state = m_rowCount == 0 ? ReadItemCount : ReadPositions;
+            return true;
+
+        case ReadPositions: {
+            if (m_buffer.size() - *pos < 8)
+                return false;
+            ItemPosition position;
+            readUInt32(pos, &position.chunk);
+            readUInt32(pos, &position.index);
+            m_order.append(position);
+            if ( static_cast<quint32>(m_order.size()) == m_rowCount )
+                m_state = ReadItemCount;
+            return true;
+        }
+
+        case ReadItemCount:
+            if ( !readUInt32(pos, &m_itemCount) )
+                return false;
+            m_state = m_itemCount == 0 ? Done : ReadItems;
+            return true;
+
+        case ReadItems: {
+            int itemPos = *pos;
+            if ( !readUInt32(&itemPos, &value) )
+                return false;
+
+            // Size 0xFFFFFFFF is used for null byte array.
+            const qint64 size = value == 0xFFFFFFFF ? 0 : static_cast<qint64>(value);
+            if (m_buffer.size() - itemPos < size)
+                return false;
+
+            const QByteArray itemBytes = m_buffer.mid( itemPos, static_cast<int>(size) );
+            *pos = itemPos + static_cast<int>(size);
+
+            QVariantMap dataMap;
+            if ( !deserializeData(&dataMap, itemBytes) ) {
+                m_failed = true;
+                return false;
+            }
+
+            m_items.append(dataMap);
+            ++m_parsedItemCount;
+            if ( static_cast<quint32>(m_parsedItemCount) == m_itemCount )
+                m_state = Done;
+            return true;
+        }
+
+        case Done:
+            return false;
+        }
+
+        return false;
+    }
+
+    State m_state;
+    bool m_failed;
+    QByteArray m_buffer;
+    quint32 m_rowCount;
+    quint32 m_itemCount;
+    QVector<ItemPosition> m_order;
+    QVector<QVariantMap> m_items;
+    int m_parsedItemCount;
+};
+
+/**
+ * Fills model with items from decrypted chunks.
+ *
+ * The last chunk of the tab must be decrypted first since it contains order of items.
+ */
+class EncryptedTabReader final {
+public:
+    EncryptedTabReader(QAbstractItemModel *model, int chunkCount, int maxItems)
+        : m_model(model)
+        , m_chunkCount(chunkCount)
+        , m_maxItems(maxItems)
+        , m_rowsInserted(false)
+        , m_insertedRowCount(0)
+    {
+    }
+
+    ~EncryptedTabReader()
+    {
+        for (auto &p : m_processes) {
+            if ( p->state() != QProcess::NotRunning ) {
+                p->kill();
+                p->waitForFinished();
+            }
+        }
+    }
+
+    /**
+     * Starts gpg for all chunks at once.
+     *
+     * Encrypted data are read from tab file and passed to each process
+     * in small parts, so startup of the processes overlaps and only
+     * the first one waits for password.
+     */
+    bool startDecrypting(QIODevice *file, const QVector<qint64> &offsets, const EncryptedChunks &chunks)
+    {
+        for (int i = 0; i < chunks.size(); ++i) {
+            std::unique_ptr<QProcess> p(new QProcess);
+            startGpgProcess( p.get(), QStringList("--decrypt"), QIODevice::ReadWrite );
+            std::unique_ptr<GpgFileInput> input(
+                new GpgFileInput(p.get(), file, offsets[i], chunks[i].size) );
+            if ( !input->write() )
+                return false;
+            m_processes.push_back( std::move(p) );
+            m_inputs.push_back( std::move(input) );
+        }
+
+        return true;
+    }
+
+    bool readChunk(int chunkIndex, EncryptedChunk *chunk)
+    {
+        const auto i = static_cast<size_t>(chunkIndex);
+
+        DecryptedChunkParser parser;
+        int itemIndex = 0;
+
+        const auto addOutput = [&](const QByteArray &bytes) {
+            return addDecryptedData(chunkIndex, &parser, bytes, &itemIndex);
+        };
+        if ( !decryptFromFile(m_processes[i].get(), m_inputs[i].get(), addOutput)
+             || !parser.isComplete() )
+        {
+            return false;
+        }
+
+        chunk->itemCount = parser.itemCount();
+        return true;
+    }
+
+    /// Removes rows added to model so partially decrypted tab is not shown or saved.
+    void rollback()
+    {
+        if (m_insertedRowCount > 0)
+            m_model->removeRows(0, m_insertedRowCount);
+        m_insertedRowCount = 0;
+    }
+
+    /**
+     * Sets rows in model for items in chunks and returns position of item for each row.
+     *
+     * Returns false if some items are missing.
+     */
+    bool setChunkRows(EncryptedChunks *chunks, QVector<quint64> *order) const
+    {
+        order->reserve( m_order.size() );
+        for (int row = 0; row < m_order.size(); ++row) {
+            const ItemPosition &position = m_order[row];
+            auto &chunk = (*chunks)[static_cast<int>(position.chunk)];
+            if ( position.index >= static_cast<quint32>(chunk.itemCount) )
+                return false;
+            chunk.rows.append( QPersistentModelIndex(m_model->index(row, 0)) );
+            chunk.rowItems.append(position.index);
+            order->append( itemKey(position.chunk, position.index) );
+        }
+        return true;
+    }
+
+private:
+    bool addDecryptedData(int chunkIndex, DecryptedChunkParser *parser, const QByteArray &bytes, int *itemIndex)
+    {
+        if ( bytes.isEmpty() )
+            return true;
+
+        if ( !parser->addData(bytes) )
+            return false;
+
+        if ( !m_rowsInserted && parser->hasOrder() ) {
+            m_rowsInserted = true;
+            if ( !insertRows(parser->order()) )
+                return false;
+        }
+
+        for ( const auto &dataMap : parser->takeItems() ) {
+            const auto key = itemKey( static_cast<quint32>(chunkIndex), static_cast<quint32>(*itemIndex) );
+            ++*itemIndex;
+            for ( int row : m_rowsForItem.value(key) )
+                m_model->setData( m_model->index(row, 0), dataMap, contentType::data );
+        }
+
+        return true;
+    }
+
+    bool insertRows(const QVector<ItemPosition> &order)
+    {
+        const int length = qMin(order.size(), m_maxItems) - m_model->rowCount();
+        const int count = qMin(length, maxItemCount);
+        if (count <= 0)
+            return true;
+
+        if ( !m_model->insertRows(0, count) ) {
+            COPYQ_LOG("ItemEncrypt ERROR: Failed to insert items!");
+            return false;
+        }
+        m_insertedRowCount = count;
+
+        for (int row = 0; row < count; ++row) {
+            const ItemPosition &position = order[row];
+            if ( position.chunk >= static_cast<quint32>(m_chunkCount) ) {
+                COPYQ_LOG("ItemEncrypt ERROR: Failed to parse item order!");
+                return false;
+            }
+            m_rowsForItem[itemKey(position.chunk, position.index)].append(row);
+        }
+
+        m_order = order.mid(0, count);
+        return true;
+    }
+
+    QAbstractItemModel *m_model;
+    int m_chunkCount;
+    int m_maxItems;
+    bool m_rowsInserted;
+    int m_insertedRowCount;
+    QVector<ItemPosition> m_order;
+    QHash< quint64, QVector<int> > m_rowsForItem;
+    std::vector< std::unique_ptr<QProcess> > m_processes;
+    std::vector< std::unique_ptr<GpgFileInput> > m_inputs;
+};
+
 bool decryptMimeData(QVariantMap *data)
 {
     const QByteArray encryptedBytes = data->take(mimeEncryptedData).toByteArray();
@@ -285,48 +833,186 @@ ItemEncrypted::ItemEncrypted(QWidget *parent)
     layout->addWidget(iconWidget);
 }
 
+ItemEncryptedSaver::ItemEncryptedSaver(
+        QAbstractItemModel *model, const EncryptedChunks &chunks, const QVector<quint64> &order)
+    : m_chunks(chunks)
+    , m_order(order)
+{
+    connect( model, &QAbstractItemModel::dataChanged,
+             this, &ItemEncryptedSaver::onDataChanged );
+}
+
 bool ItemEncryptedSaver::saveItems(const QString &, const QAbstractItemModel &model, QIODevice *file)
 {
     const auto length = model.rowCount();
     if (length == 0)
         return false; // No need to encode empty tab.
 
-    QByteArray bytes;
-
-    {
-        QDataStream stream(&bytes, QIODevice::WriteOnly);
-        stream.setVersion(QDataStream::Qt_4_7);
-
-        stream << static_cast<quint64>(length);
-
-        for (int i = 0; i < length && stream.status() == QDataStream::Ok; ++i) {
-            QModelIndex index = model.index(i, 0);
-            const QVariantMap dataMap = index.data(contentType::data).toMap();
-            stream << dataMap;
+    // Unchanged chunks are copied from the tab file which is being replaced.
+    QFile oldFile;
+    QVector<qint64> offsets;
+    QVector<int> reusedChunks;
+    const auto tabFile = qobject_cast<QFileDevice*>(file);
+    if ( tabFile && !m_chunks.isEmpty() ) {
+        oldFile.setFileName( tabFile->fileName() );
+        if ( oldFile.open(QIODevice::ReadOnly) && findChunks(&oldFile, m_chunks, &offsets) ) {
+            for (int i = 0; i < m_chunks.size(); ++i) {
+                if ( isChunkReusable(m_chunks[i]) )
+                    reusedChunks.append(i);
+            }
+        } else {
+            COPYQ_LOG("ItemEncrypt: Encrypting all items since tab file changed");
         }
     }
 
-    bytes = readGpgOutput(QStringList("--encrypt"), bytes);
-    if ( bytes.isEmpty() ) {
-        emitEncryptFailed();
-        COPYQ_LOG("ItemEncrypt ERROR: Failed to read encrypted data");
-        return false;
+    const quint64 newItem = itemKey(0xFFFFFFFF, 0);
+    QVector<quint64> order;
+    const auto findItems = [&]() {
+        order.fill(newItem, length);
+        for (int i = 0; i < reusedChunks.size(); ++i) {
+            const auto &chunk = m_chunks[reusedChunks[i]];
+            for (int j = 0; j < chunk.rows.size(); ++j) {
+                if ( chunk.rows[j].isValid() )
+                    order[chunk.rows[j].row()] = itemKey( static_cast<quint32>(i), chunk.rowItems[j] );
+            }
+        }
+    };
+    findItems();
+
+    const bool unchanged = reusedChunks.size() == m_chunks.size() && order == m_order;
+
+    EncryptedChunk newChunk;
+    if (!unchanged) {
+        // Drop chunks which contain only old order of items. If there are
+        // too many chunks, items from the smallest ones are encrypted again.
+        QVector<int> chunksWithItems;
+        for (int chunkIndex : reusedChunks) {
+            if (m_chunks[chunkIndex].itemCount > 0)
+                chunksWithItems.append(chunkIndex);
+        }
+        while (chunksWithItems.size() >= maxChunkCount) {
+            const auto smallest = std::min_element(
+                std::begin(chunksWithItems), std::end(chunksWithItems),
+                [this](int lhs, int rhs) {
+                    return liveItemCount(m_chunks[lhs]) < liveItemCount(m_chunks[rhs]);
+                });
+            chunksWithItems.erase(smallest);
+        }
+        if (chunksWithItems != reusedChunks) {
+            reusedChunks = chunksWithItems;
+            findItems();
+        }
+
+        // New chunk contains new and changed items and order of all items.
+        const auto newChunkIndex = static_cast<quint32>(reusedChunks.size());
+        for (int row = 0; row < length; ++row) {
+            if (order[row] == newItem) {
+                const auto itemIndex = static_cast<quint32>(newChunk.rows.size());
+                order[row] = itemKey(newChunkIndex, itemIndex);
+                newChunk.rows.append( QPersistentModelIndex(model.index(row, 0)) );
+                newChunk.rowItems.append(itemIndex);
+            }
+        }
+        newChunk.itemCount = newChunk.rows.size();
     }
 
     QDataStream stream(file);
     stream.setVersion(QDataStream::Qt_4_7);
-    stream << QString(dataFileHeaderV2);
-    stream.writeRawData( bytes.data(), bytes.size() );
+    stream << QString(dataFileHeaderV3)
+           << static_cast<quint32>(reusedChunks.size() + (unchanged ? 0 : 1));
 
-    if ( stream.status() != QDataStream::Ok ) {
+    bool written = stream.status() == QDataStream::Ok;
+    for (int i = 0; written && i < reusedChunks.size(); ++i) {
+        const int chunkIndex = reusedChunks[i];
+        written = copyChunk(&oldFile, offsets[chunkIndex], m_chunks[chunkIndex].size, file);
+    }
+
+    if (!written) {
         emitEncryptFailed();
         COPYQ_LOG("ItemEncrypt ERROR: Failed to write encrypted data");
         return false;
     }
 
+    if (!unchanged) {
+        // Size of the new chunk is written after all data are encrypted.
+        const qint64 sizePos = file->pos();
+        stream << static_cast<quint32>(0);
+
+        // Pass data to gpg as they are serialized and write encrypted data
+        // to the tab file as they arrive.
+        QProcess p;
+        startGpgProcess( &p, QStringList("--encrypt"), QIODevice::ReadWrite );
+
+        QByteArray orderBytes = serializeValue( static_cast<quint32>(length) );
+        for (const auto position : order) {
+            orderBytes.append( serializeValue(static_cast<quint32>(position >> 32)) );
+            orderBytes.append( serializeValue(static_cast<quint32>(position)) );
+        }
+        orderBytes.append( serializeValue(static_cast<quint32>(newChunk.itemCount)) );
+
+        written = stream.status() == QDataStream::Ok
+            && writeGpgInput(&p, orderBytes, file, &newChunk.size);
+        for (int i = 0; written && i < newChunk.rows.size(); ++i) {
+            const QVariantMap dataMap = newChunk.rows[i].data(contentType::data).toMap();
+            written = writeGpgInput( &p, serializeValue(serializeData(dataMap)), file, &newChunk.size );
+        }
+
+        p.closeWriteChannel();
+        while ( written && p.state() != QProcess::NotRunning && p.waitForReadyRead() )
+            written = writeGpgOutput(&p, file, &newChunk.size);
+
+        const bool succeeded = verifyProcess(&p) && written
+                && writeGpgOutput(&p, file, &newChunk.size);
+
+        if ( !succeeded || newChunk.size == 0 ) {
+            emitEncryptFailed();
+            COPYQ_LOG("ItemEncrypt ERROR: Failed to encrypt data");
+            return false;
+        }
+
+        const qint64 endPos = file->pos();
+        if ( !file->seek(sizePos) ) {
+            emitEncryptFailed();
+            COPYQ_LOG("ItemEncrypt ERROR: Failed to write encrypted data");
+            return false;
+        }
+        stream << newChunk.size;
+        if ( stream.status() != QDataStream::Ok || !file->seek(endPos) ) {
+            emitEncryptFailed();
+            COPYQ_LOG("ItemEncrypt ERROR: Failed to write encrypted data");
+            return false;
+        }
+    }
+
+    EncryptedChunks chunks;
+    for (int chunkIndex : reusedChunks) {
+        chunks.append(m_chunks[chunkIndex]);
+        removeInvalidRows(&chunks.last());
+    }
+    if (!unchanged)
+        chunks.append(newChunk);
+
+    m_chunks = chunks;
+    m_order = order;
+
     return true;
 }
 
+void ItemEncryptedSaver::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    for (auto &chunk : m_chunks) {
+        if (chunk.changed)
+            continue;
+
+        for (const auto &index : chunk.rows) {
+            if ( index.row() >= topLeft.row() && index.row() <= bottomRight.row() ) {
+                chunk.changed = true;
+                break;
+            }
+        }
+    }
+}
+
 void ItemEncryptedSaver::emitEncryptFailed()
 {
     emit error( ItemEncryptedLoader::tr("Encryption failed!") );
@@ -408,11 +1094,12 @@ void ItemEncryptedScriptable::encryptItems()
         auto itemData = itemDataValue.toMap();
 
         QVariantMap itemDataToEncrypt;
+        QVariantMap patch;
         const auto formats = itemData.keys();
         for (const auto &format : formats) {
             if ( !format.startsWith(COPYQ_MIME_PREFIX) ) {
                 itemDataToEncrypt.insert(format, itemData[format]);
-                itemData.remove(format);
+                patch.insert(format, QVariant());
             }
         }
 
@@ -420,25 +1107,26 @@ void ItemEncryptedScriptable::encryptItems()
         const auto encryptedBytes = encrypt(bytes);
         if (encryptedBytes.isEmpty())
             return;
-        itemData.insert(mimeEncryptedData, encryptedBytes);
+        patch.insert(mimeEncryptedData, encryptedBytes);
 
-        dataList.append(itemData);
+        dataList.append(patch);
     }
 
-    call( "setSelectedItemsData", QVariantList() << QVariant(dataList) );
+    call( "patchSelectedItemsData", QVariantList() << QVariant(dataList) );
 }
 
 void ItemEncryptedScriptable::decryptItems()
 {
-    const auto dataValueList = call("selectedItemsData").toList();
+    const auto dataValueList = call("selectedItemsData", QVariantList() << mimeEncryptedData).toList();
 
     QVariantList dataList;
     for (const auto &itemDataValue : dataValueList) {
-        auto itemData = itemDataValue.toMap();
+        const auto itemData = itemDataValue.toMap();
 
+        QVariantMap patch;
         const auto encryptedBytes = itemData.value(mimeEncryptedData).toByteArray();
         if ( !encryptedBytes.isEmpty() ) {
-            itemData.remove(mimeEncryptedData);
+            patch.insert(mimeEncryptedData, QVariant());
 
             const auto decryptedBytes = decrypt(encryptedBytes);
             if (decryptedBytes.isEmpty())
@@ -446,18 +1134,19 @@ void ItemEncryptedScriptable::decryptItems()
 
             const auto decryptedItemData = call("unpack", QVariantList() << decryptedBytes).toMap();
             for (auto it = decryptedItemData.constBegin(); it != decryptedItemData.constEnd(); ++it)
-                itemData.insert(it.key(), it.value());
+                patch.insert(it.key(), it.value());
         }
 
-        dataList.append(itemData);
+        dataList.append(patch);
     }
 
-    call( "setSelectedItemsData", QVariantList() << QVariant(dataList) );
+    call( "patchSelectedItemsData", QVariantList() << QVariant(dataList) );
 }
 
 void ItemEncryptedScriptable::copyEncryptedItems()
 {
-    const auto dataValueList = call("selectedItemsData").toList();
+    const auto dataValueList = call(
+        "selectedItemsData", QVariantList() << mimeText << mimeEncryptedData).toList();
     QString text;
     for (const auto &dataValue : dataValueList) {
         if ( !text.isEmpty() )
@@ -623,14 +1312,10 @@ QWidget *ItemEncryptedLoader::createSettingsWidget(QWidget *parent)
 
 bool ItemEncryptedLoader::canLoadItems(QIODevice *file) const
 {
-    QDataStream stream(file);
-    stream.setVersion(QDataStream::Qt_4_7);
-
-    QString header;
-    stream >> header;
-
-    return stream.status() == QDataStream::Ok
-            && (header == dataFileHeader || header == dataFileHeaderV2);
+    const QString header = readDataFileHeader(file);
+    return header == dataFileHeader
+        || header == dataFileHeaderV2
+        || header == dataFileHeaderV3;
 }
 
 bool ItemEncryptedLoader::canSaveItems(const QString &tabName) const
@@ -663,7 +1348,8 @@ bool ItemEncryptedLoader::canSaveItems(const QString &tabName) const
 ItemSaverPtr ItemEncryptedLoader::loadItems(const QString &, QAbstractItemModel *model, QIODevice *file, int maxItems)
 {
     // This is needed to skip header.
-    if ( !canLoadItems(file) )
+    const QString header = readDataFileHeader(file);
+    if ( header != dataFileHeader && header != dataFileHeaderV2 && header != dataFileHeaderV3 )
         return nullptr;
 
     if (status() == GpgNotInstalled) {
@@ -673,33 +1359,25 @@ ItemSaverPtr ItemEncryptedLoader::loadItems(const QString &, QAbstractItemModel
 
     importGpgKey();
 
+    if (header == dataFileHeaderV3)
+        return loadItemsV3(model, file, maxItems);
+
     QProcess p;
     startGpgProcess( &p, QStringList("--decrypt"), QIODevice::ReadWrite );
 
-    char encryptedBytes[4096];
-
-    QDataStream stream(file);
-    while ( !stream.atEnd() ) {
-        const int bytesRead = stream.readRawData(encryptedBytes, 4096);
-        if (bytesRead == -1) {
-            emitDecryptFailed();
-            COPYQ_LOG("ItemEncrypted ERROR: Failed to read encrypted data");
-            return nullptr;
-        }
-        p.write(encryptedBytes, bytesRead);
-    }
-
-    p.closeWriteChannel();
-
-    // Wait for password entry dialog.
-    p.waitForFinished(-1);
-
-    if ( !verifyProcess(&p) ) {
+    // Items in older format can be parsed only after all are decrypted.
+    QByteArray bytes;
+    GpgFileInput input( &p, file, file->pos(), file->size() - file->pos() );
+    const auto addOutput = [&](const QByteArray &output) {
+        bytes.append(output);
+        return true;
+    };
+    if ( !decryptFromFile(&p, &input, addOutput) ) {
         emitDecryptFailed();
+        COPYQ_LOG("ItemEncrypted ERROR: Failed to decrypt data");
         return nullptr;
     }
 
-    const QByteArray bytes = p.readAllStandardOutput();
     if ( bytes.isEmpty() ) {
         emitDecryptFailed();
         COPYQ_LOG("ItemEncrypt ERROR: Failed to read encrypted data.");
@@ -736,15 +1414,76 @@ ItemSaverPtr ItemEncryptedLoader::loadItems(const QString &, QAbstractItemModel
         return nullptr;
     }
 
-    return createSaver();
+    return createSaver(model);
+}
+
+ItemSaverPtr ItemEncryptedLoader::loadItemsV3(QAbstractItemModel *model, QIODevice *file, int maxItems)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    quint32 chunkCount;
+    stream >> chunkCount;
+    if ( stream.status() != QDataStream::Ok || chunkCount == 0
+         || chunkCount > static_cast<quint32>(maxChunkCount) )
+    {
+        emitDecryptFailed();
+        COPYQ_LOG("ItemEncrypt ERROR: Failed to parse chunk count!");
+        return nullptr;
+    }
+
+    // Encrypted data are read from file only when passed to gpg.
+    EncryptedChunks chunks( static_cast<int>(chunkCount) );
+    QVector<qint64> offsets;
+    for (auto &chunk : chunks) {
+        stream >> chunk.size;
+        offsets.append( file->pos() );
+        if ( stream.status() != QDataStream::Ok
+             || chunk.size == 0xFFFFFFFF
+             || stream.skipRawData(static_cast<int>(chunk.size)) != static_cast<int>(chunk.size) )
+        {
+            emitDecryptFailed();
+            COPYQ_LOG("ItemEncrypted ERROR: Failed to read encrypted data");
+            return nullptr;
+        }
+    }
+
+    // Items are added to model as they are decrypted, starting with the
+    // last chunk which contains item order.
+    EncryptedTabReader reader( model, chunks.size(), maxItems );
+    if ( !reader.startDecrypting(file, offsets, chunks) ) {
+        emitDecryptFailed();
+        COPYQ_LOG("ItemEncrypted ERROR: Failed to read encrypted data");
+        return nullptr;
+    }
+
+    for (int i = 0; i < chunks.size(); ++i) {
+        const int chunkIndex = (i == 0) ? chunks.size() - 1 : i - 1;
+        if ( !reader.readChunk(chunkIndex, &chunks[chunkIndex]) ) {
+            reader.rollback();
+            emitDecryptFailed();
+            COPYQ_LOG("ItemEncrypt ERROR: Failed to decrypt items!");
+            return nullptr;
+        }
+    }
+
+    QVector<quint64> order;
+    if ( !reader.setChunkRows(&chunks, &order) ) {
+        reader.rollback();
+        emitDecryptFailed();
+        COPYQ_LOG("ItemEncrypt ERROR: Failed to parse item order!");
+        return nullptr;
+    }
+
+    return createSaver(model, chunks, order);
 }
 
-ItemSaverPtr ItemEncryptedLoader::initializeTab(const QString &, QAbstractItemModel *, int)
+ItemSaverPtr ItemEncryptedLoader::initializeTab(const QString &, QAbstractItemModel *model, int)
 {
     if (status() == GpgNotInstalled)
         return nullptr;
 
-    return createSaver();
+    return createSaver(model);
 }
 
 QObject *ItemEncryptedLoader::tests(const TestInterfacePtr &test) const
@@ -915,9 +1654,10 @@ void ItemEncryptedLoader::emitDecryptFailed()
     emit error( ItemEncryptedLoader::tr("Decryption failed!") );
 }
 
-ItemSaverPtr ItemEncryptedLoader::createSaver()
+ItemSaverPtr ItemEncryptedLoader::createSaver(
+        QAbstractItemModel *model, const EncryptedChunks &chunks, const QVector<quint64> &order)
 {
-    auto saver = std::make_shared<ItemEncryptedSaver>();
+    auto saver = std::make_shared<ItemEncryptedSaver>(model, chunks, order);
     connect( saver.get(), &ItemEncryptedSaver::error,
              this, &ItemEncryptedLoader::error );
     return saver;
@@ -23,7 +23,9 @@
 #include "item/itemwidget.h"
 #include "gui/icons.h"
 
+#include <QPersistentModelIndex>
 #include <QProcess>
+#include <QVector>
 #include <QWidget>
 
 #include <memory>
@@ -42,18 +44,57 @@ public:
     explicit ItemEncrypted(QWidget *parent);
 };
 
+/**
+ * Separately encrypted part of tab data in tab file.
+ *
+ * Chunks are copied from previous tab file when saving tab if none of their
+ * items changed, so only new and modified items need to be encrypted again.
+ * Removed items are kept in chunks until they take most of the chunk.
+ */
+struct EncryptedChunk {
+    /// Size of encrypted data in tab file.
+    quint32 size = 0;
+    /// Number of items stored in the chunk.
+    int itemCount = 0;
+    /// Rows with items from the chunk.
+    QVector<QPersistentModelIndex> rows;
+    /// Index of item in the chunk for each row.
+    QVector<quint32> rowItems;
+    /// True if data in any of the rows changed since the chunk was saved.
+    bool changed = false;
+};
+
+using EncryptedChunks = QVector<EncryptedChunk>;
+
 class ItemEncryptedSaver : public QObject, public ItemSaverInterface
 {
     Q_OBJECT
 
 public:
+    /**
+     * @param chunks  chunks in tab file (with rows already in model)
+     * @param order  item position for each row (chunk index in upper
+     *               and item index in lower 32 bits)
+     */
+    explicit ItemEncryptedSaver(
+            QAbstractItemModel *model,
+            const EncryptedChunks &chunks = EncryptedChunks(),
+            const QVector<quint64> &order = QVector<quint64>());
+
     bool saveItems(const QString &tabName, const QAbstractItemModel &model, QIODevice *file) override;
 
 signals:
     void error(const QString &);
 
 private:
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
     void emitEncryptFailed();
+
+    /// Chunks in last saved tab file.
+    EncryptedChunks m_chunks;
+    /// Chunk and item index for each row in last saved tab file.
+    QVector<quint64> m_order;
 };
 
 class ItemEncryptedScriptable : public ItemScriptable
@@ -148,7 +189,12 @@ private:
 
     void emitDecryptFailed();
 
-    ItemSaverPtr createSaver();
+    ItemSaverPtr loadItemsV3(QAbstractItemModel *model, QIODevice *file, int maxItems);
+
+    ItemSaverPtr createSaver(
+            QAbstractItemModel *model,
+            const EncryptedChunks &chunks = EncryptedChunks(),
+            const QVector<quint64> &order = QVector<quint64>());
 
     GpgProcessStatus status() const;
 
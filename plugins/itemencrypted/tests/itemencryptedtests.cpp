@@ -20,6 +20,89 @@
 #include "itemencryptedtests.h"
 
 #include "tests/test_utils.h"
+#include "common/contenttype.h"
+#include "common/mimetypes.h"
+#include "common/textdata.h"
+
+#include "../itemencrypted.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardItemModel>
+#include <QTemporaryDir>
+
+namespace {
+
+void setItemText(QAbstractItemModel *model, int row, const QString &text)
+{
+    model->setData( model->index(row, 0), createDataMap(mimeText, text), contentType::data );
+}
+
+void insertItem(QAbstractItemModel *model, int row, const QString &text)
+{
+    model->insertRow(row);
+    setItemText(model, row, text);
+}
+
+QString itemTexts(const QAbstractItemModel &model)
+{
+    QStringList texts;
+    for (int row = 0; row < model.rowCount(); ++row)
+        texts.append( getTextData(model.index(row, 0).data(contentType::data).toMap()) );
+    return texts.join(",");
+}
+
+QByteArray saveTab(const ItemSaverPtr &saver, const QAbstractItemModel &model, const QString &fileName)
+{
+    QSaveFile file(fileName);
+    if ( !file.open(QIODevice::WriteOnly) )
+        return "Failed to open tab file: " + file.errorString().toUtf8();
+
+    if ( !saver->saveItems("test", model, &file) ) {
+        file.cancelWriting();
+        return "Failed to save items";
+    }
+
+    if ( !file.commit() )
+        return "Failed to write tab file: " + file.errorString().toUtf8();
+
+    return QByteArray();
+}
+
+ItemSaverPtr loadTab(ItemEncryptedLoader *loader, QAbstractItemModel *model, const QString &fileName)
+{
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly) )
+        return nullptr;
+    return loader->loadItems("test", model, &file, 100);
+}
+
+/// Returns encrypted chunks in tab file.
+QVector<QByteArray> readChunks(const QString &fileName)
+{
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly) )
+        return QVector<QByteArray>();
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    QString header;
+    quint32 chunkCount;
+    stream >> header >> chunkCount;
+
+    QVector<QByteArray> chunks;
+    for (quint32 i = 0; i < chunkCount && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray chunk;
+        stream >> chunk;
+        chunks.append(chunk);
+    }
+
+    return chunks;
+}
+
+} // namespace
 
 ItemEncryptedTests::ItemEncryptedTests(const TestInterfacePtr &test, QObject *parent)
     : QObject(parent)
@@ -71,6 +154,162 @@ void ItemEncryptedTests::encryptDecryptData()
     QCOMPARE(stdoutActual, input);
 }
 
+void ItemEncryptedTests::saveAndLoadTab()
+{
+    if ( !isGpgInstalled() )
+        SKIP("gpg2 is required to run the test");
+
+    RUN("-e" << "plugins.itemencrypted.generateTestKeys()", "\n");
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString fileName = dir.path() + "/tab.dat";
+
+    ItemEncryptedLoader loader;
+    QStandardItemModel model;
+    for (const auto &text : {"C", "B", "A"})
+        insertItem(&model, 0, text);
+
+    const auto saver = loader.initializeTab("test", &model, 100);
+    QVERIFY( saver != nullptr );
+    TEST( saveTab(saver, model, fileName) );
+    const auto chunks = readChunks(fileName);
+    QCOMPARE( chunks.size(), 1 );
+
+    QStandardItemModel model2;
+    const auto saver2 = loadTab(&loader, &model2, fileName);
+    QVERIFY( saver2 != nullptr );
+    QCOMPARE( itemTexts(model2), QString("A,B,C") );
+
+    // Unchanged items are not encrypted again.
+    TEST( saveTab(saver2, model2, fileName) );
+    QCOMPARE( readChunks(fileName), chunks );
+
+    // All items are encrypted again if tab file is replaced.
+    QVERIFY( QFile::remove(fileName) );
+    TEST( saveTab(saver2, model2, fileName) );
+    const auto chunks2 = readChunks(fileName);
+    QCOMPARE( chunks2.size(), 1 );
+    QVERIFY( chunks2[0] != chunks[0] );
+
+    QStandardItemModel model3;
+    QVERIFY( loadTab(&loader, &model3, fileName) != nullptr );
+    QCOMPARE( itemTexts(model3), QString("A,B,C") );
+}
+
+void ItemEncryptedTests::reencryptChangedItems()
+{
+    if ( !isGpgInstalled() )
+        SKIP("gpg2 is required to run the test");
+
+    RUN("-e" << "plugins.itemencrypted.generateTestKeys()", "\n");
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString fileName = dir.path() + "/tab.dat";
+
+    ItemEncryptedLoader loader;
+    QStandardItemModel model;
+    for (const auto &text : {"C", "B", "A"})
+        insertItem(&model, 0, text);
+
+    const auto saver = loader.initializeTab("test", &model, 100);
+    QVERIFY( saver != nullptr );
+    TEST( saveTab(saver, model, fileName) );
+    const auto chunks1 = readChunks(fileName);
+    QCOMPARE( chunks1.size(), 1 );
+
+    // New item is encrypted in new chunk.
+    insertItem(&model, 0, "D");
+    TEST( saveTab(saver, model, fileName) );
+    const auto chunks2 = readChunks(fileName);
+    QCOMPARE( chunks2.size(), 2 );
+    QCOMPARE( chunks2[0], chunks1[0] );
+
+    // Changed item is encrypted again only with items in the same chunk.
+    setItemText(&model, 0, "E");
+    TEST( saveTab(saver, model, fileName) );
+    const auto chunks3 = readChunks(fileName);
+    QCOMPARE( chunks3.size(), 2 );
+    QCOMPARE( chunks3[0], chunks1[0] );
+    QVERIFY( chunks3[1] != chunks2[1] );
+
+    setItemText(&model, 1, "X");
+    TEST( saveTab(saver, model, fileName) );
+    const auto chunks4 = readChunks(fileName);
+    QCOMPARE( chunks4.size(), 2 );
+    QCOMPARE( chunks4[0], chunks3[1] );
+
+    // Chunk with removed item is not encrypted again,
+    // only new order of items is stored in new chunk.
+    model.removeRow(3);
+    TEST( saveTab(saver, model, fileName) );
+    const auto chunks5 = readChunks(fileName);
+    QCOMPARE( chunks5.size(), 3 );
+    QCOMPARE( chunks5[0], chunks4[0] );
+    QCOMPARE( chunks5[1], chunks4[1] );
+
+    // Chunks loaded from tab file are reused.
+    QStandardItemModel model2;
+    const auto saver2 = loadTab(&loader, &model2, fileName);
+    QVERIFY( saver2 != nullptr );
+    QCOMPARE( itemTexts(model2), QString("E,X,B") );
+
+    setItemText(&model2, 2, "Y");
+    TEST( saveTab(saver2, model2, fileName) );
+    const auto chunks6 = readChunks(fileName);
+    QCOMPARE( chunks6.size(), 2 );
+    QCOMPARE( chunks6[0], chunks5[0] );
+
+    QStandardItemModel model3;
+    QVERIFY( loadTab(&loader, &model3, fileName) != nullptr );
+    QCOMPARE( itemTexts(model3), QString("E,X,Y") );
+}
+
+void ItemEncryptedTests::reencryptOnlyNewItemsInFullTab()
+{
+    if ( !isGpgInstalled() )
+        SKIP("gpg2 is required to run the test");
+
+    RUN("-e" << "plugins.itemencrypted.generateTestKeys()", "\n");
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString fileName = dir.path() + "/tab.dat";
+
+    const int maxItems = 20;
+    ItemEncryptedLoader loader;
+    QStandardItemModel model;
+    for (int i = 0; i < maxItems; ++i)
+        insertItem(&model, 0, QString::number(i));
+
+    const auto saver = loader.initializeTab("test", &model, maxItems);
+    QVERIFY( saver != nullptr );
+    TEST( saveTab(saver, model, fileName) );
+    auto chunks = readChunks(fileName);
+    QCOMPARE( chunks.size(), 1 );
+
+    // Adding item to full tab removes the oldest one.
+    for (int i = maxItems; i < 2 * maxItems; ++i) {
+        insertItem(&model, 0, QString::number(i));
+        model.removeRow(maxItems);
+        TEST( saveTab(saver, model, fileName) );
+
+        // Only the new chunk is encrypted, others are copied from previous file.
+        const auto newChunks = readChunks(fileName);
+        QVERIFY( newChunks.size() > 1 );
+        QVERIFY( newChunks.size() <= 8 );
+        for (int j = 0; j < newChunks.size() - 1; ++j)
+            QVERIFY2( chunks.contains(newChunks[j]), QByteArray::number(i) );
+        QVERIFY( !chunks.contains(newChunks.last()) );
+        chunks = newChunks;
+    }
+
+    QStandardItemModel model2;
+    QVERIFY( loadTab(&loader, &model2, fileName) != nullptr );
+    QCOMPARE( itemTexts(model2), itemTexts(model) );
+}
+
 bool ItemEncryptedTests::isGpgInstalled() const
 {
     QByteArray actualStdout;
@@ -37,6 +37,9 @@ private slots:
     void cleanup();
 
     void encryptDecryptData();
+    void saveAndLoadTab();
+    void reencryptChangedItems();
+    void reencryptOnlyNewItemsInFullTab();
 
 private:
     bool isGpgInstalled() const;
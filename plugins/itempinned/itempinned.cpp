@@ -176,6 +176,10 @@ ItemPinnedSaver::ItemPinnedSaver(QAbstractItemModel *model, QVariantMap &setting
              this, &ItemPinnedSaver::onRowsMoved );
     connect( model, &QAbstractItemModel::dataChanged,
              this, &ItemPinnedSaver::onDataChanged );
+    connect( model, &QAbstractItemModel::layoutAboutToBeChanged,
+             this, &ItemPinnedSaver::onLayoutAboutToBeChanged );
+    connect( model, &QAbstractItemModel::layoutChanged,
+             this, &ItemPinnedSaver::onLayoutChanged );
 
     updateLastPinned( 0, m_model->rowCount() );
 }
@@ -230,11 +234,7 @@ void ItemPinnedSaver::onRowsInserted(const QModelIndex &, int start, int end)
 
     // Shift rows below inserted up.
     const int rowCount = end - start + 1;
-    for (int row = end + 1; row <= m_lastPinned + rowCount; ++row) {
-        const auto index = m_model->index(row, 0);
-        if ( isPinned(index) )
-            moveRow(row, row - rowCount);
-    }
+    movePinnedRows(end + 1, m_lastPinned + rowCount, -rowCount);
 
     connect( m_model.data(), &QAbstractItemModel::rowsMoved,
              this, &ItemPinnedSaver::onRowsMoved );
@@ -250,11 +250,7 @@ void ItemPinnedSaver::onRowsRemoved(const QModelIndex &, int start, int end)
 
     // Shift rows below removed down.
     const int rowCount = end - start + 1;
-    for (int row = m_lastPinned - rowCount; row >= start; --row) {
-        const auto index = m_model->index(row, 0);
-        if ( isPinned(index) )
-            moveRow(row, row + rowCount + 1);
-    }
+    movePinnedRows(start, m_lastPinned - rowCount, rowCount);
 
     connect( m_model.data(), &QAbstractItemModel::rowsMoved,
              this, &ItemPinnedSaver::onRowsMoved );
@@ -288,11 +284,7 @@ void ItemPinnedSaver::onRowsMoved(const QModelIndex &, int start, int end, const
                 this, &ItemPinnedSaver::onRowsMoved );
 
     // Shift rows below inserted up.
-    for (int row = destinationRow + rowCount; row <= std::min(m_lastPinned, end); ++row) {
-        const auto index = m_model->index(row, 0);
-        if ( isPinned(index) )
-            moveRow(row, row - rowCount);
-    }
+    movePinnedRows(destinationRow + rowCount, std::min(m_lastPinned, end), -rowCount);
 
     connect( m_model.data(), &QAbstractItemModel::rowsMoved,
              this, &ItemPinnedSaver::onRowsMoved );
@@ -306,9 +298,108 @@ void ItemPinnedSaver::onDataChanged(const QModelIndex &topLeft, const QModelInde
     updateLastPinned( topLeft.row(), bottomRight.row() );
 }
 
-void ItemPinnedSaver::moveRow(int from, int to)
+void ItemPinnedSaver::onLayoutAboutToBeChanged()
+{
+    m_pinnedIndexes.clear();
+    m_pinnedRows.clear();
+
+    if (!m_model)
+        return;
+
+    for (int row = 0; row <= m_lastPinned; ++row) {
+        const auto index = m_model->index(row, 0);
+        if ( isPinned(index) ) {
+            m_pinnedIndexes.append(index);
+            m_pinnedRows.append(row);
+        }
+    }
+}
+
+void ItemPinnedSaver::onLayoutChanged()
+{
+    if (!m_model)
+        return;
+
+    const auto pinnedIndexes = m_pinnedIndexes;
+    const auto pinnedRows = m_pinnedRows;
+    m_pinnedIndexes.clear();
+    m_pinnedRows.clear();
+
+    bool moved = false;
+    for (int i = 0; i < pinnedIndexes.size(); ++i) {
+        if ( pinnedIndexes[i].isValid() && pinnedIndexes[i].row() != pinnedRows[i] ) {
+            moved = true;
+            break;
+        }
+    }
+
+    if (moved) {
+        disconnect( m_model.data(), &QAbstractItemModel::rowsMoved,
+                    this, &ItemPinnedSaver::onRowsMoved );
+
+        // Restore pinned items to their rows (other items keep the new order).
+        // First gather pinned items at the top in order of their original rows
+        // so that moving them down to original rows in reverse order
+        // does not shift already placed items.
+        int top = 0;
+        for (const auto &index : pinnedIndexes) {
+            if ( !index.isValid() )
+                continue;
+            const int row = index.row();
+            if (row != top)
+                m_model->moveRows(QModelIndex(), row, 1, QModelIndex(), top);
+            ++top;
+        }
+
+        for (int i = pinnedIndexes.size() - 1; i >= 0; --i) {
+            const auto &index = pinnedIndexes[i];
+            if ( !index.isValid() )
+                continue;
+            const int row = index.row();
+            const int targetRow = std::min( pinnedRows[i], m_model->rowCount() - 1 );
+            if (row < targetRow)
+                m_model->moveRows(QModelIndex(), row, 1, QModelIndex(), targetRow + 1);
+        }
+
+        connect( m_model.data(), &QAbstractItemModel::rowsMoved,
+                 this, &ItemPinnedSaver::onRowsMoved );
+    }
+
+    m_lastPinned = -1;
+    updateLastPinned( 0, m_model->rowCount() );
+}
+
+void ItemPinnedSaver::movePinnedRows(int first, int last, int offset)
 {
-    m_model->moveRow(QModelIndex(), from, QModelIndex(), to);
+    const auto isPinnedRow = [this](int row) {
+        return isPinned( m_model->index(row, 0) );
+    };
+
+    if (offset < 0) {
+        for (int row = first; row <= last; ++row) {
+            if ( !isPinnedRow(row) )
+                continue;
+
+            int runEnd = row;
+            while ( runEnd < last && isPinnedRow(runEnd + 1) )
+                ++runEnd;
+
+            m_model->moveRows(QModelIndex(), row, runEnd - row + 1, QModelIndex(), row + offset);
+            row = runEnd;
+        }
+    } else {
+        for (int row = last; row >= first; --row) {
+            if ( !isPinnedRow(row) )
+                continue;
+
+            int runStart = row;
+            while ( runStart > first && isPinnedRow(runStart - 1) )
+                --runStart;
+
+            m_model->moveRows(QModelIndex(), runStart, row - runStart + 1, QModelIndex(), row + offset + 1);
+            row = runStart;
+        }
+    }
 }
 
 void ItemPinnedSaver::updateLastPinned(int from, int to)
@@ -23,6 +23,8 @@
 #include "gui/icons.h"
 #include "item/itemwidgetwrapper.h"
 
+#include <QPersistentModelIndex>
+#include <QVector>
 #include <QWidget>
 
 class ItemPinned : public QWidget, public ItemWidgetWrapper
@@ -73,8 +75,14 @@ private:
     void onRowsRemoved(const QModelIndex &parent, int start, int end);
     void onRowsMoved(const QModelIndex &, int start, int end, const QModelIndex &, int destinationRow);
     void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
-
-    void moveRow(int from, int to);
+    void onLayoutAboutToBeChanged();
+    void onLayoutChanged();
+
+    /**
+     * Moves pinned rows in range from @a first to @a last by @a offset.
+     * Consecutive pinned rows are moved at once.
+     */
+    void movePinnedRows(int first, int last, int offset);
     void updateLastPinned(int from, int to);
 
     QPointer<QAbstractItemModel> m_model;
@@ -83,6 +91,10 @@ private:
 
     // Last pinned row in list (improves performace of updates).
     int m_lastPinned = -1;
+
+    // Pinned items and their rows before layout change (e.g. sorting items).
+    QList<QPersistentModelIndex> m_pinnedIndexes;
+    QVector<int> m_pinnedRows;
 };
 
 class ItemPinnedLoader : public QObject, public ItemLoaderInterface
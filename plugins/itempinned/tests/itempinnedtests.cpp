@@ -150,6 +150,24 @@ void ItemPinnedTests::pinToRow()
     RUN(read << "0" << "1" << "2", "a b d");
 }
 
+void ItemPinnedTests::sortAndReverse()
+{
+    const auto read = Args() << "separator" << " " << "read";
+
+    RUN("add" << "5" << "2" << "4" << "1" << "3", "");
+    RUN("-e" << "plugins.itempinned.pin(1, 3)", "");
+    RUN(read << "0" << "1" << "2" << "3" << "4", "3 1 4 2 5");
+
+    // Pinned items stay in their rows, other items are reordered.
+    RUN("keys" << "CTRL+A" << "CTRL+SHIFT+R", "");
+    RUN(read << "0" << "1" << "2" << "3" << "4", "5 1 4 2 3");
+
+    RUN("keys" << "CTRL+A" << "CTRL+SHIFT+S", "");
+    RUN(read << "0" << "1" << "2" << "3" << "4", "3 1 4 2 5");
+
+    RUN("-e" << "plugins.itempinned.isPinned(1) && plugins.itempinned.isPinned(3)", "true\n");
+}
+
 void ItemPinnedTests::fullTab()
 {
     RUN("config" << "maxitems" << "3", "3\n");
@@ -45,6 +45,7 @@ private slots:
     void removePinnedThrows();
 
     void pinToRow();
+    void sortAndReverse();
 
     void fullTab();
 
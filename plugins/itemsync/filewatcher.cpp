@@ -25,10 +25,26 @@
 
 #include <QAbstractItemModel>
 #include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileSystemWatcher>
 #include <QMimeData>
+#include <QSocketNotifier>
 #include <QUrl>
 
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#   include <sys/stat.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#   include <cerrno>
+#   include <cstring>
+#   include <sys/inotify.h>
+#   include <unistd.h>
+#endif
+
 const char mimeExtensionMap[] = COPYQ_MIME_PREFIX_ITEMSYNC "mime-to-extension-map";
 const char mimeBaseName[] = COPYQ_MIME_PREFIX_ITEMSYNC "basename";
 const char mimeNoSave[] = COPYQ_MIME_PREFIX_ITEMSYNC "no-save";
@@ -63,6 +79,8 @@ const char dataFileSuffix[] = "_copyq.dat";
 const char noteFileSuffix[] = "_note.txt";
 
 const int updateItemsIntervalMs = 5000; // Interval to update items after a file has changed.
+const int updateChangedItemsIntervalMs = 200; // Interval to batch reported file changes.
+const int maxFileTimeResolutionMs = 2000; // FAT stores modification time in two seconds.
 
 const qint64 sizeLimit = 10 << 20;
 
@@ -240,6 +258,94 @@ BaseNameExtensionsList listFiles(const QStringList &files,
     return fileList;
 }
 
+/// List existing files for an item with given base name.
+BaseNameExtensions listFiles(const QDir &dir, const QString &baseName,
+                             const QList<FileFormat> &formatSettings)
+{
+    QStringList extensions;
+    extensions.append(QString());
+    extensions.append(dataFileSuffix);
+    for (const auto &ext : fileExtensionsAndFormats())
+        extensions.append(ext.extension);
+    for (const auto &format : formatSettings)
+        extensions.append(format.extensions);
+    extensions.removeDuplicates();
+
+    BaseNameExtensions baseNameWithExts(baseName);
+
+    for (const auto &extension : extensions) {
+        const QString filePath = dir.absoluteFilePath(baseName + extension);
+        QString fileBaseName;
+        Ext ext;
+        if ( QFile::exists(filePath)
+             && getBaseNameExtension(filePath, formatSettings, &fileBaseName, &ext)
+             && fileBaseName == baseName && ext.extension == extension )
+        {
+            baseNameWithExts.exts.append(ext);
+        }
+    }
+
+    return baseNameWithExts;
+}
+
+FileStat fileStat(const QString &filePath)
+{
+    FileStat result;
+
+#ifdef Q_OS_UNIX
+    // Inode helps to detect files replaced by other files with same size and time.
+    struct stat buf;
+    if ( ::stat(QFile::encodeName(filePath).constData(), &buf) != 0 )
+        return result;
+
+#   ifdef Q_OS_MAC
+    const auto &modified = buf.st_mtimespec;
+#   else
+    const auto &modified = buf.st_mtim;
+#   endif
+
+    result.inode = static_cast<qint64>(buf.st_ino);
+    result.size = static_cast<qint64>(buf.st_size);
+    result.modified = static_cast<qint64>(modified.tv_sec) * 1000 + modified.tv_nsec / 1000000;
+#else
+    const QFileInfo info(filePath);
+    if ( !info.exists() )
+        return result;
+
+    result.size = info.size();
+    result.modified = info.lastModified().toMSecsSinceEpoch();
+#endif
+
+    return result;
+}
+
+/// File with given content; the content is verified when file properties don't change.
+FileStat fileStat(const QString &filePath, const Hash &digest)
+{
+    FileStat result = fileStat(filePath);
+    result.digest = digest;
+    return result;
+}
+
+/**
+ * Returns true if file can be modified again without changing its modification time
+ * (some file systems store the time in seconds or even two seconds).
+ */
+bool isModifiedRecently(const FileStat &stat)
+{
+    return QDateTime::currentMSecsSinceEpoch() - stat.modified < maxFileTimeResolutionMs;
+}
+
+QDateTime lastModified(const QDir &dir, const BaseNameExtensions &baseNameWithExts)
+{
+    QDateTime time;
+    for (const auto &ext : baseNameWithExts.exts) {
+        const QFileInfo info( dir.absoluteFilePath(baseNameWithExts.baseName + ext.extension) );
+        time = qMax(time, info.lastModified());
+    }
+    return time;
+}
+
 /// Load hash of all existing files to map (hash -> filename).
 QStringList listFiles(const QDir &dir, QDir::SortFlags sortFlags = QDir::NoSort)
 {
@@ -408,10 +514,18 @@ FileWatcher::FileWatcher(
     , m_valid(true)
     , m_indexData()
     , m_maxItems(maxItems)
+    , m_inotifyFd(-1)
+    , m_inotifyWatch(-1)
+    , m_inotifyNotifier(nullptr)
+    , m_directoryWatcher(nullptr)
+    , m_updateAll(true)
 {
     m_updateTimer.setInterval(updateItemsIntervalMs);
     m_updateTimer.setSingleShot(true);
 
+    m_updateChangedTimer.setInterval(updateChangedItemsIntervalMs);
+    m_updateChangedTimer.setSingleShot(true);
+
 #ifdef HAS_TESTS
     // Use smaller update interval for tests.
     if ( !qEnvironmentVariableIsEmpty("COPYQ_TEST_ID") )
@@ -420,6 +534,8 @@ FileWatcher::FileWatcher(
 
     connect( &m_updateTimer, &QTimer::timeout,
              this, &FileWatcher::updateItems );
+    connect( &m_updateChangedTimer, &QTimer::timeout,
+             this, &FileWatcher::updateItems );
 
     connect( m_model.data(), &QAbstractItemModel::rowsInserted,
              this, &FileWatcher::onRowsInserted );
@@ -436,12 +552,23 @@ FileWatcher::FileWatcher(
     updateItems();
 }
 
+FileWatcher::~FileWatcher()
+{
+#ifdef Q_OS_LINUX
+    if (m_inotifyNotifier)
+        m_inotifyNotifier->setEnabled(false);
+    if (m_inotifyFd != -1)
+        ::close(m_inotifyFd);
+#endif
+}
+
 bool FileWatcher::lock()
 {
     if ( !m_valid )
         return false;
 
     m_updateTimer.stop();
+    m_updateChangedTimer.stop();
     m_valid = false;
     return true;
 }
@@ -449,21 +576,27 @@ bool FileWatcher::lock()
 void FileWatcher::unlock()
 {
     m_valid = true;
-    m_updateTimer.start();
+
+    // Poll for changes only if changes in files are not reported.
+    if ( !isWatchingFiles() )
+        m_updateTimer.start();
+    else if ( m_updateAll || !m_changedBaseNames.isEmpty() )
+        m_updateChangedTimer.start();
 }
 
 bool FileWatcher::createItemFromFiles(const QDir &dir, const BaseNameExtensions &baseNameWithExts, int targetRow)
 {
     QVariantMap dataMap;
     QVariantMap mimeToExtension;
+    FileStats fileStats;
 
-    updateDataAndWatchFile(dir, baseNameWithExts, &dataMap, &mimeToExtension);
+    updateDataAndWatchFile(dir, baseNameWithExts, &dataMap, &mimeToExtension, &fileStats);
 
     if ( !mimeToExtension.isEmpty() ) {
         dataMap.insert( mimeBaseName, QFileInfo(baseNameWithExts.baseName).fileName() );
         dataMap.insert(mimeExtensionMap, mimeToExtension);
 
-        if ( !createItem(dataMap, targetRow) )
+        if ( !createItem(dataMap, fileStats, targetRow) )
             return false;
     }
 
@@ -486,37 +619,248 @@ void FileWatcher::updateItems()
     if ( !lock() )
         return;
 
+    // Start watching before listing files so no change is missed.
+    watchDirectory();
+
     const QDir dir(m_path);
+    if ( m_updateAll || !isWatchingFiles() )
+        updateAllItems(dir);
+    else
+        updateChangedItems(dir);
+
+    unlock();
+}
+
+void FileWatcher::watchDirectory()
+{
+    if ( isWatchingFiles() )
+        return;
+
+#ifdef Q_OS_LINUX
+    if (m_inotifyFd == -1) {
+        m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotifyFd == -1) {
+            log( QString("ItemSync: Failed to initialize inotify: %1")
+                 .arg(QString::fromUtf8(strerror(errno))), LogWarning );
+        } else {
+            m_inotifyNotifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+            connect( m_inotifyNotifier, &QSocketNotifier::activated,
+                     this, &FileWatcher::readFileSystemEvents );
+        }
+    }
+
+    if (m_inotifyFd != -1) {
+        const uint32_t mask = IN_ONLYDIR | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_ATTRIB
+                | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+        m_inotifyWatch = inotify_add_watch( m_inotifyFd, QFile::encodeName(m_path).constData(), mask );
+        if ( isWatchingFiles() ) {
+            delete m_directoryWatcher;
+            m_directoryWatcher = nullptr;
+            m_changedBaseNames.clear();
+            m_updateAll = true;
+            return;
+        }
+    }
+#endif
+
+    // Fallback: Get notified about new and removed files and poll for other changes.
+    if (!m_directoryWatcher) {
+        m_directoryWatcher = new QFileSystemWatcher(this);
+        connect( m_directoryWatcher, &QFileSystemWatcher::directoryChanged,
+                 this, &FileWatcher::onDirectoryChanged );
+    }
+
+    if ( m_directoryWatcher->directories().isEmpty() && QDir(m_path).exists() )
+        m_directoryWatcher->addPath(m_path);
+}
+
+void FileWatcher::readFileSystemEvents()
+{
+#ifdef Q_OS_LINUX
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;) {
+        const ssize_t size = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (size <= 0)
+            break;
+
+        for ( const char *ptr = buffer; ptr < buffer + size; ) {
+            const auto event = reinterpret_cast<const inotify_event *>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if ( event->mask & IN_Q_OVERFLOW ) {
+                m_updateAll = true;
+            } else if ( event->mask & IN_IGNORED ) {
+                // Directory was removed or moved.
+                if (event->wd == m_inotifyWatch)
+                    m_inotifyWatch = -1;
+                m_updateAll = true;
+            } else if (event->len > 0) {
+                onFileChanged( QFile::decodeName(event->name) );
+            }
+        }
+    }
+
+    scheduleUpdate();
+#endif
+}
+
+void FileWatcher::onDirectoryChanged()
+{
+    m_updateAll = true;
+    scheduleUpdate();
+}
+
+void FileWatcher::onFileChanged(const QString &fileName)
+{
+    if ( fileName.startsWith('.') )
+        return;
+
+    const Ext ext = findByExtension(fileName, m_formatSettings);
+    if ( ext.format.isEmpty() || ext.format == "-" )
+        return;
+
+    m_changedBaseNames.insert( fileName.left(fileName.size() - ext.extension.size()) );
+}
+
+void FileWatcher::scheduleUpdate()
+{
+    if ( !m_valid || (!m_updateAll && m_changedBaseNames.isEmpty()) )
+        return;
+
+    m_updateTimer.stop();
+    if ( !m_updateChangedTimer.isActive() )
+        m_updateChangedTimer.start();
+}
+
+void FileWatcher::updateAllItems(const QDir &dir)
+{
+    m_updateAll = false;
+    m_changedBaseNames.clear();
+
     const QStringList files = listFiles(dir, QDir::Time | QDir::Reversed);
-    BaseNameExtensionsList fileList = listFiles(files, m_formatSettings);
+    const BaseNameExtensionsList fileList = listFiles(files, m_formatSettings);
+
+    QHash<QString, int> baseNameToFile;
+    baseNameToFile.reserve( fileList.size() );
+    for ( int i = 0; i < fileList.size(); ++i )
+        baseNameToFile.insert( fileList[i].baseName, i );
+
+    QVector<bool> used( fileList.size(), false );
 
     for ( int row = 0; row < m_model->rowCount(); ++row ) {
         const QModelIndex index = m_model->index(row, 0);
         const QString baseName = getBaseName(index);
 
-        int i = 0;
-        for ( i = 0; i < fileList.size() && fileList[i].baseName != baseName; ++i ) {}
+        const int i = baseNameToFile.value(baseName, -1);
+        const bool hasFiles = i != -1 && !used[i];
+        if (hasFiles)
+            used[i] = true;
 
-        QVariantMap dataMap;
-        QVariantMap mimeToExtension;
+        if ( !updateItem(dir, index, hasFiles ? fileList[i] : BaseNameExtensions(baseName)) )
+            --row;
+    }
+
+    BaseNameExtensionsList newFileList;
+    for ( int i = 0; i < fileList.size(); ++i ) {
+        if ( !used[i] )
+            newFileList.append(fileList[i]);
+    }
 
-        if ( i < fileList.size() ) {
-            updateDataAndWatchFile(dir, fileList[i], &dataMap, &mimeToExtension);
-            fileList.removeAt(i);
+    createItemsFromFiles(dir, newFileList);
+}
+
+void FileWatcher::updateChangedItems(const QDir &dir)
+{
+    const auto changedBaseNames = m_changedBaseNames;
+    m_changedBaseNames.clear();
+
+    BaseNameExtensionsList newFileList;
+    QList<QDateTime> newFileTimes;
+
+    for (const auto &baseName : changedBaseNames) {
+        const BaseNameExtensions baseNameWithExts = listFiles(dir, baseName, m_formatSettings);
+        const QPersistentModelIndex index = m_baseNameToIndex.value(baseName);
+        if ( index.isValid() ) {
+            updateItem(dir, index, baseNameWithExts);
+        } else if ( !baseNameWithExts.exts.isEmpty() ) {
+            // Keep new files sorted by time so that newer items end up on top.
+            const QDateTime time = lastModified(dir, baseNameWithExts);
+            const auto it = std::upper_bound(newFileTimes.begin(), newFileTimes.end(), time);
+            const int i = static_cast<int>( it - newFileTimes.begin() );
+            newFileTimes.insert(i, time);
+            newFileList.insert(i, baseNameWithExts);
         }
+    }
 
-        if ( mimeToExtension.isEmpty() ) {
-            m_model->removeRow(row--);
-        } else {
-            dataMap.insert(mimeBaseName, baseName);
-            dataMap.insert(mimeExtensionMap, mimeToExtension);
-            updateIndexData(index, dataMap);
+    createItemsFromFiles(dir, newFileList);
+}
+
+bool FileWatcher::updateItem(const QDir &dir, const QModelIndex &index, const BaseNameExtensions &baseNameWithExts)
+{
+    if ( isItemUnchanged(dir, index, baseNameWithExts) )
+        return true;
+
+    QVariantMap dataMap;
+    QVariantMap mimeToExtension;
+    FileStats fileStats;
+
+    if ( !baseNameWithExts.exts.isEmpty() )
+        updateDataAndWatchFile(dir, baseNameWithExts, &dataMap, &mimeToExtension, &fileStats);
+
+    if ( mimeToExtension.isEmpty() ) {
+        m_model->removeRow( index.row() );
+        return false;
+    }
+
+    dataMap.insert(mimeBaseName, baseNameWithExts.baseName);
+    dataMap.insert(mimeExtensionMap, mimeToExtension);
+    updateIndexData(index, dataMap);
+    indexData(index).fileStats = fileStats;
+    return true;
+}
+
+bool FileWatcher::isItemUnchanged(const QDir &dir, const QModelIndex &index, const BaseNameExtensions &baseNameWithExts)
+{
+    if ( baseNameWithExts.exts.isEmpty() )
+        return false;
+
+    const auto it = findIndexData(index);
+    if ( it == m_indexData.end() || it->baseName != baseNameWithExts.baseName )
+        return false;
+
+    const FileStats &fileStats = it->fileStats;
+    if ( fileStats.size() != baseNameWithExts.exts.size() )
+        return false;
+
+    const QString basePath = dir.absoluteFilePath(baseNameWithExts.baseName);
+    QVector<QString> verifiedExtensions;
+    for (const auto &ext : baseNameWithExts.exts) {
+        const auto statIt = fileStats.constFind(ext.extension);
+        if ( statIt == fileStats.constEnd() )
+            return false;
+
+        const QString fileName = basePath + ext.extension;
+        const FileStat stat = fileStat(fileName);
+        if ( *statIt != stat )
+            return false;
+
+        // Same size and modification time does not mean same content
+        // if the file was modified recently.
+        if ( !statIt->digest.isEmpty() ) {
+            QFile f(fileName);
+            if ( !f.open(QIODevice::ReadOnly) || calculateHash(f.readAll()) != statIt->digest )
+                return false;
+            if ( !isModifiedRecently(stat) )
+                verifiedExtensions.append(ext.extension);
         }
     }
 
-    createItemsFromFiles(dir, fileList);
+    // Avoid reading files again if they cannot change unnoticed anymore.
+    for (const auto &ext : verifiedExtensions)
+        it->fileStats[ext].digest.clear();
 
-    unlock();
+    return true;
 }
 
 void FileWatcher::onRowsInserted(const QModelIndex &, int first, int last)
@@ -537,6 +881,8 @@ void FileWatcher::onRowsRemoved(const QModelIndex &, int first, int last)
         Q_ASSERT( it != m_indexData.end() );
         if ( isOwnBaseName(it->baseName) )
             removeFilesForRemovedIndex(m_path, index);
+        if ( m_baseNameToIndex.value(it->baseName) == index )
+            m_baseNameToIndex.remove(it->baseName);
         m_indexData.erase(it);
     }
 }
@@ -554,12 +900,13 @@ FileWatcher::IndexData &FileWatcher::indexData(const QModelIndex &index)
     return *it;
 }
 
-bool FileWatcher::createItem(const QVariantMap &dataMap, int targetRow)
+bool FileWatcher::createItem(const QVariantMap &dataMap, const FileStats &fileStats, int targetRow)
 {
     const int row = qMax( 0, qMin(targetRow, m_model->rowCount()) );
     if ( m_model->insertRow(row) ) {
         const QModelIndex &index = m_model->index(row, 0);
         updateIndexData(index, dataMap);
+        indexData(index).fileStats = fileStats;
         return true;
     }
 
@@ -578,7 +925,12 @@ void FileWatcher::updateIndexData(const QModelIndex &index, const QVariantMap &i
 
     IndexData &data = indexData(index);
 
-    data.baseName = baseName;
+    if ( data.baseName != baseName ) {
+        if ( !data.baseName.isEmpty() && m_baseNameToIndex.value(data.baseName) == index )
+            m_baseNameToIndex.remove(data.baseName);
+        data.baseName = baseName;
+    }
+    m_baseNameToIndex.insert(baseName, index);
 
     QMap<QString, Hash> &formatData = data.formatHash;
     formatData.clear();
@@ -651,8 +1003,11 @@ void FileWatcher::saveItems(int first, int last)
             } else {
                 mimeToExtension.insert(format, ext);
                 const Hash oldHash = indexData(index).formatHash.value(format);
-                if ( !saveItemFile(filePath + ext, bytes, &existingFiles, hash != oldHash) )
+                const bool hashChanged = hash != oldHash;
+                if ( !saveItemFile(filePath + ext, bytes, &existingFiles, hashChanged) )
                     return;
+                // Avoid reading the saved file again.
+                indexData(index).fileStats.insert( ext, fileStat(filePath + ext, hash) );
             }
         }
 
@@ -668,6 +1023,8 @@ void FileWatcher::saveItems(int first, int last)
             QByteArray data = serializeData(dataMapUnknown);
             if ( !saveItemFile(filePath + dataFileSuffix, data, &existingFiles) )
                 return;
+            indexData(index).fileStats.insert(
+                        dataFileSuffix, fileStat(filePath + dataFileSuffix, calculateHash(data)) );
         }
 
         if ( !noSaveData.isEmpty() || mimeToExtension != oldMimeToExtension ) {
@@ -681,6 +1038,9 @@ void FileWatcher::saveItems(int first, int last)
 
             // Remove files of removed formats.
             removeFormatFiles(filePath, oldMimeToExtension);
+            FileStats &fileStats = indexData(index).fileStats;
+            for (const auto &extValue : oldMimeToExtension)
+                fileStats.remove( extValue.toString() );
         }
     }
 
@@ -728,6 +1088,8 @@ bool FileWatcher::renameMoveCopy(const QDir &dir, const QList<QPersistentModelIn
             itemData.remove(mimeSyncPath);
             itemData.insert(mimeBaseName, baseName);
             updateIndexData(index, itemData);
+            if (copyFilesFromOtherTab)
+                indexData(index).fileStats.clear();
 
             if ( oldBaseName.isEmpty() && itemData.contains(mimeUriList) ) {
                 if ( copyFilesFromUriList(itemData[mimeUriList].toByteArray(), index.row(), baseNames) )
@@ -740,7 +1102,7 @@ bool FileWatcher::renameMoveCopy(const QDir &dir, const QList<QPersistentModelIn
 }
 
 void FileWatcher::updateDataAndWatchFile(const QDir &dir, const BaseNameExtensions &baseNameWithExts,
-                            QVariantMap *dataMap, QVariantMap *mimeToExtension)
+                            QVariantMap *dataMap, QVariantMap *mimeToExtension, FileStats *fileStats)
 {
     const QString basePath = dir.absoluteFilePath(baseNameWithExts.baseName);
 
@@ -749,20 +1111,39 @@ void FileWatcher::updateDataAndWatchFile(const QDir &dir, const BaseNameExtensio
 
         const QString fileName = basePath + ext.extension;
 
-        QFile f( dir.absoluteFilePath(fileName) );
-        if ( !f.open(QIODevice::ReadOnly) )
+        // Get file properties before reading so later changes are not missed.
+        FileStat stat = fileStat(fileName);
+        if ( !stat.isValid() )
             continue;
 
-        if ( ext.extension == dataFileSuffix && deserializeData(dataMap, f.readAll()) ) {
-            mimeToExtension->insert(mimeUnknownFormats, dataFileSuffix);
-        } else if ( f.size() > sizeLimit || ext.format.startsWith(mimeNoFormat)
-                    || dataMap->contains(ext.format) )
+        const bool isDataFile = ext.extension == dataFileSuffix;
+        if ( !isDataFile && (stat.size > sizeLimit || ext.format.startsWith(mimeNoFormat)
+                             || dataMap->contains(ext.format)) )
         {
+            // Don't read the file, only keep its extension.
             mimeToExtension->insert(mimeNoFormat + ext.extension, ext.extension);
+            fileStats->insert(ext.extension, stat);
+            continue;
+        }
+
+        QFile f(fileName);
+        if ( !f.open(QIODevice::ReadOnly) )
+            continue;
+
+        const QByteArray bytes = f.readAll();
+        if (isDataFile) {
+            if ( deserializeData(dataMap, bytes) )
+                mimeToExtension->insert(mimeUnknownFormats, dataFileSuffix);
+            else
+                mimeToExtension->insert(mimeNoFormat + ext.extension, ext.extension);
         } else {
-            dataMap->insert(ext.format, f.readAll());
+            dataMap->insert(ext.format, bytes);
             mimeToExtension->insert(ext.format, ext.extension);
         }
+
+        if ( isModifiedRecently(stat) )
+            stat.digest = calculateHash(bytes);
+        fileStats->insert(ext.extension, stat);
     }
 }
 
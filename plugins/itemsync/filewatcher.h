@@ -22,15 +22,19 @@
 
 #include "common/mimetypes.h"
 
+#include <QHash>
 #include <QObject>
 #include <QPointer>
 #include <QPersistentModelIndex>
+#include <QSet>
 #include <QStringList>
 #include <QTimer>
 #include <QVector>
 
 class QAbstractItemModel;
 class QDir;
+class QFileSystemWatcher;
+class QSocketNotifier;
 
 struct Ext;
 struct BaseNameExtensions;
@@ -50,10 +54,31 @@ struct FileFormat {
     QString icon;
 };
 
-using BaseNameExtensionsList = QList<BaseNameExtensions>;
-
 using Hash = QByteArray;
 
+/// File properties used to detect changes without reading the file.
+struct FileStat {
+    FileStat() : inode(0), size(-1), modified(0) {}
+    bool isValid() const { return size != -1; }
+    bool operator==(const FileStat &other) const {
+        return inode == other.inode && size == other.size && modified == other.modified;
+    }
+    bool operator!=(const FileStat &other) const { return !(*this == other); }
+    qint64 inode;
+    qint64 size;
+    qint64 modified;
+    /**
+     * Hash of file content if the file can change without changing other properties
+     * (i.e. it was modified recently or it was not read or written); otherwise empty.
+     */
+    Hash digest;
+};
+
+/// File extension -> file properties at the time the file was read or written.
+using FileStats = QMap<QString, FileStat>;
+
+using BaseNameExtensionsList = QList<BaseNameExtensions>;
+
 class FileWatcher : public QObject {
 public:
     static QString getBaseName(const QModelIndex &index);
@@ -72,6 +97,8 @@ public:
     FileWatcher(const QString &path, const QStringList &paths, QAbstractItemModel *model,
                 int maxItems, const QList<FileFormat> &formatSettings, QObject *parent);
 
+    ~FileWatcher();
+
     const QString &path() const { return m_path; }
 
     bool isValid() const { return m_valid; }
@@ -88,10 +115,38 @@ public:
 
     /**
      * Check for new files.
+     *
+     * If the directory is watched for changes, only items for changed files
+     * are updated, otherwise all files are listed and compared to items.
      */
     void updateItems();
 
 private:
+    /// Start watching directory for changes unless already watching.
+    void watchDirectory();
+
+    /// Return true if changes of individual files are reported.
+    bool isWatchingFiles() const { return m_inotifyWatch != -1; }
+
+    void readFileSystemEvents();
+
+    void onDirectoryChanged();
+
+    void onFileChanged(const QString &fileName);
+
+    /// Update changed items after a while (batches multiple file changes).
+    void scheduleUpdate();
+
+    void updateAllItems(const QDir &dir);
+
+    void updateChangedItems(const QDir &dir);
+
+    /// Update item data from files or remove item if there are no files (returns false).
+    bool updateItem(const QDir &dir, const QModelIndex &index, const BaseNameExtensions &baseNameWithExts);
+
+    /// Return true only if no file of the item was added, removed or modified since last read.
+    bool isItemUnchanged(const QDir &dir, const QModelIndex &index, const BaseNameExtensions &baseNameWithExts);
+
     void onRowsInserted(const QModelIndex &, int first, int last);
 
     void onDataChanged(const QModelIndex &a, const QModelIndex &b);
@@ -102,6 +157,7 @@ private:
         QPersistentModelIndex index;
         QString baseName;
         QMap<QString, Hash> formatHash;
+        FileStats fileStats;
 
         IndexData() {}
         explicit IndexData(const QModelIndex &index) : index(index) {}
@@ -114,7 +170,7 @@ private:
 
     IndexData &indexData(const QModelIndex &index);
 
-    bool createItem(const QVariantMap &dataMap, int targetRow);
+    bool createItem(const QVariantMap &dataMap, const FileStats &fileStats, int targetRow);
 
     void updateIndexData(const QModelIndex &index, const QVariantMap &itemData);
 
@@ -126,17 +182,26 @@ private:
 
     void updateDataAndWatchFile(
             const QDir &dir, const BaseNameExtensions &baseNameWithExts,
-            QVariantMap *dataMap, QVariantMap *mimeToExtension);
+            QVariantMap *dataMap, QVariantMap *mimeToExtension, FileStats *fileStats);
 
     bool copyFilesFromUriList(const QByteArray &uriData, int targetRow, const QStringList &baseNames);
 
     QPointer<QAbstractItemModel> m_model;
     QTimer m_updateTimer;
+    QTimer m_updateChangedTimer;
     const QList<FileFormat> &m_formatSettings;
     QString m_path;
     bool m_valid;
     IndexDataList m_indexData;
+    QHash<QString, QPersistentModelIndex> m_baseNameToIndex;
     int m_maxItems;
+
+    int m_inotifyFd;
+    int m_inotifyWatch;
+    QSocketNotifier *m_inotifyNotifier;
+    QFileSystemWatcher *m_directoryWatcher;
+    QSet<QString> m_changedBaseNames;
+    bool m_updateAll;
 };
 
 #endif // FILEWATCHER_H
@@ -22,6 +22,7 @@
 #include "common/mimetypes.h"
 #include "tests/test_utils.h"
 
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
 
@@ -432,6 +433,62 @@ void ItemSyncTests::modifyFiles()
     RUN(args << "size", "4\n");
 }
 
+void ItemSyncTests::modifyFilesSameSizeAndTime()
+{
+    TestDir dir1(1);
+    const QString tab1 = testTab(1);
+    RUN(Args() << "show" << tab1, "");
+
+    const Args args = Args() << "separator" << "," << "tab" << tab1;
+
+    RUN(args << "add" << "A" << "B", "");
+
+    const QString fileA = fileNameForId(0);
+    const QString fileB = fileNameForId(1);
+    QCOMPARE( dir1.files().join(sep), fileA + sep + fileB );
+
+    // Change content of a file without changing its size or modification time.
+    FilePtr file = dir1.file(fileB);
+    QVERIFY(file->open(QIODevice::ReadWrite));
+#if QT_VERSION >= QT_VERSION_CHECK(5,10,0)
+    const QDateTime modified = file->fileTime(QFileDevice::FileModificationTime);
+#endif
+    QCOMPARE(file->readAll().data(), QByteArray("B").data());
+    QVERIFY(file->seek(0));
+    file->write("X");
+    file->flush();
+#if QT_VERSION >= QT_VERSION_CHECK(5,10,0)
+    QVERIFY(file->setFileTime(modified, QFileDevice::FileModificationTime));
+#endif
+    file->close();
+
+    WAIT_ON_OUTPUT(args << "read" << "0" << "1", "X,A");
+    RUN(args << "size", "2\n");
+}
+
+void ItemSyncTests::renameFiles()
+{
+    TestDir dir1(1);
+    const QString tab1 = testTab(1);
+    RUN(Args() << "show" << tab1, "");
+
+    const Args args = Args() << "separator" << "," << "tab" << tab1;
+
+    RUN(args << "add" << "A" << "B", "");
+
+    const QString fileA = fileNameForId(0);
+    const QString fileB = fileNameForId(1);
+    const QString fileC = "test.txt";
+
+    QCOMPARE( dir1.files().join(sep), fileA + sep + fileB );
+
+    QVERIFY( QFile::rename(dir1.filePath(fileA), dir1.filePath(fileC)) );
+
+    WAIT_ON_OUTPUT(args << "read" << "0" << "1" << "2", "A,B,");
+    RUN(args << "size", "2\n");
+    QCOMPARE( dir1.files().join(sep), fileB + sep + fileC );
+}
+
 void ItemSyncTests::notes()
 {
     TestDir dir1(1);
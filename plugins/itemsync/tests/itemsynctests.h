@@ -51,6 +51,8 @@ private slots:
 
     void modifyItems();
     void modifyFiles();
+    void modifyFilesSameSizeAndTime();
+    void renameFiles();
 
     void notes();
 
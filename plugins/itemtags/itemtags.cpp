@@ -57,7 +57,8 @@ enum {
     match,
     styleSheet,
     color,
-    icon
+    icon,
+    itemCount
 };
 }
 
@@ -394,19 +395,7 @@ void ItemTagsScriptable::tag()
     }
 
     if ( args.size() <= 1 ) {
-        const auto dataValueList = call("selectedItemsData").toList();
-
-        QVariantList dataList;
-        dataList.reserve( dataValueList.size() );
-        for (const auto &itemDataValue : dataValueList) {
-            auto itemData = itemDataValue.toMap();
-            auto itemTags = ::tags(itemData);
-            if ( addTag(tagName, &itemTags) )
-                itemData.insert( mimeTags, itemTags.join(",") );
-            dataList.append(itemData);
-        }
-
-        call( "setSelectedItemsData", QVariantList() << QVariant(dataList) );
+        call( "addSelectedItemsListValue", QVariantList() << mimeTags << tagName );
     } else {
         for ( int row : rows(args, 1) ) {
             auto itemTags = tags(row);
@@ -422,9 +411,9 @@ void ItemTagsScriptable::untag()
     auto tagName = args.value(0).toString();
 
     if ( args.size() <= 1 ) {
-        const auto dataValueList = call("selectedItemsData").toList();
-
         if ( tagName.isEmpty() ) {
+            const auto dataValueList = call("selectedItemsData", QVariantList() << mimeTags).toList();
+
             QStringList allTags;
             for (const auto &itemDataValue : dataValueList) {
                 const auto itemData = itemDataValue.toMap();
@@ -436,17 +425,7 @@ void ItemTagsScriptable::untag()
                 return;
         }
 
-        QVariantList dataList;
-        dataList.reserve( dataValueList.size() );
-        for (const auto &itemDataValue : dataValueList) {
-            auto itemData = itemDataValue.toMap();
-            auto itemTags = ::tags(itemData);
-            if ( removeTag(tagName, &itemTags) )
-                itemData.insert( mimeTags, itemTags.join(",") );
-            dataList.append(itemData);
-        }
-
-        call( "setSelectedItemsData", QVariantList() << QVariant(dataList) );
+        call( "removeSelectedItemsListValue", QVariantList() << mimeTags << tagName );
     } else {
         const auto rows = this->rows(args, 1);
 
@@ -473,16 +452,16 @@ void ItemTagsScriptable::clearTags()
     const auto args = currentArguments();
 
     if ( args.isEmpty() ) {
-        const auto dataValueList = call("selectedItemsData").toList();
+        const auto dataValueList = call("selectedItemsData", QVariantList() << mimeTags).toList();
 
-        QVariantList dataList;
-        for (const auto &itemDataValue : dataValueList) {
-            auto itemData = itemDataValue.toMap();
-            itemData.remove(mimeTags);
-            dataList.append(itemData);
-        }
+        QVariantMap patch;
+        patch.insert(mimeTags, QVariant());
+
+        QVariantList patches;
+        for (int i = 0; i < dataValueList.size(); ++i)
+            patches.append(patch);
 
-        call( "setSelectedItemsData", QVariantList() << QVariant(dataList) );
+        call( "patchSelectedItemsData", QVariantList() << QVariant(patches) );
     } else {
         const auto rows = this->rows(args, 0);
         for (int row : rows)
@@ -496,7 +475,7 @@ bool ItemTagsScriptable::hasTag()
     const auto tagName = args.value(0).toString();
 
     if ( args.size() <= 1 ) {
-        const auto dataValueList = call("selectedItemsData").toList();
+        const auto dataValueList = call("selectedItemsData", QVariantList() << mimeTags).toList();
         for (const auto &itemDataValue : dataValueList) {
             const auto itemData = itemDataValue.toMap();
             const auto itemTags = ::tags(itemData);
@@ -510,6 +489,21 @@ bool ItemTagsScriptable::hasTag()
     return tags(row).contains(tagName);
 }
 
+QVariantMap ItemTagsScriptable::tagCounts()
+{
+    return call("queryItemsIndex", QVariantList() << mimeTags << "counts").toMap();
+}
+
+QVariantList ItemTagsScriptable::taggedRows()
+{
+    return taggedRows("rows");
+}
+
+QVariantList ItemTagsScriptable::taggedRowsAny()
+{
+    return taggedRows("rowsAny");
+}
+
 QString ItemTagsScriptable::askTagName(const QString &dialogTitle, const QStringList &tags)
 {
     const auto value = call( "dialog", QVariantList()
@@ -556,6 +550,13 @@ void ItemTagsScriptable::setTags(int row, const QStringList &tags)
     call("change", QVariantList() << row << mimeTags << value);
 }
 
+QVariantList ItemTagsScriptable::taggedRows(const QString &query)
+{
+    // Tags are looked up in index kept in server, items are not fetched.
+    const auto args = QVariantList() << mimeTags << query << QVariant(currentArguments());
+    return call("queryItemsIndex", args).toList();
+}
+
 bool ItemTagsScriptable::addTag(const QString &tagName, QStringList *tags)
 {
     if ( tags->contains(tagName) )
@@ -636,6 +637,7 @@ QWidget *ItemTagsLoader::createSettingsWidget(QWidget *parent)
     header->setSectionResizeMode(tagsTableColumns::match, QHeaderView::Stretch);
     setFixedColumnSize(ui->tableWidget, tagsTableColumns::color);
     setFixedColumnSize(ui->tableWidget, tagsTableColumns::icon);
+    header->setSectionResizeMode(tagsTableColumns::itemCount, QHeaderView::ResizeToContents);
 
     connect( ui->tableWidget, &QTableWidget::itemChanged,
              this, &ItemTagsLoader::onTableWidgetItemChanged );
@@ -653,8 +655,23 @@ ItemWidget *ItemTagsLoader::transform(ItemWidget *itemWidget, const QVariantMap
     return new ItemTags(itemWidget, tags);
 }
 
+ItemSaverPtr ItemTagsLoader::transformSaver(const ItemSaverPtr &saver, QAbstractItemModel *model)
+{
+    m_tagIndexes.removeAll(nullptr);
+
+    const auto tagIndex = ModelTagIndex::attach(model, mimeTags);
+    if ( !m_tagIndexes.contains(tagIndex) )
+        m_tagIndexes.append(tagIndex);
+
+    return saver;
+}
+
 bool ItemTagsLoader::matches(const QModelIndex &index, const QRegExp &re) const
 {
+    const auto tagIndex = ModelTagIndex::find( index.model() );
+    if (tagIndex)
+        return tagIndex->matches(index.row(), re);
+
     const QByteArray tagsData =
             index.data(contentType::data).toMap().value(mimeTags).toByteArray();
     const auto tags = getTextData(tagsData);
@@ -836,6 +853,13 @@ void ItemTagsLoader::addTagToSettingsTable(const ItemTagsLoader::Tag &tag)
     t->setItem( row, tagsTableColumns::color, new QTableWidgetItem() );
     t->setItem( row, tagsTableColumns::icon, new QTableWidgetItem() );
 
+    auto itemCountItem = new QTableWidgetItem();
+    itemCountItem->setFlags(Qt::ItemIsEnabled);
+    itemCountItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    if ( isTagValid(tag) )
+        itemCountItem->setText( QString::number(itemCount(tag)) );
+    t->setItem( row, tagsTableColumns::itemCount, itemCountItem );
+
     auto colorButton = new QPushButton(t);
     const QColor color = tag.color.isEmpty()
             ? QColor::fromRgb(50, 50, 50)
@@ -866,3 +890,27 @@ ItemTagsLoader::Tag ItemTagsLoader::tagFromTable(int row)
     tag.match = t->item(row, tagsTableColumns::match)->text();
     return tag;
 }
+
+int ItemTagsLoader::itemCount(const Tag &tag) const
+{
+    const QRegExp re(tag.match);
+
+    int count = 0;
+    for (const auto &tagIndex : m_tagIndexes) {
+        if (!tagIndex)
+            continue;
+
+        const auto &index = tagIndex->index();
+        if ( tag.match.isEmpty() ) {
+            count += index.count(tag.name);
+        } else {
+            const auto counts = index.counts();
+            for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+                if ( re.exactMatch(it.key()) )
+                    count += it.value();
+            }
+        }
+    }
+
+    return count;
+}
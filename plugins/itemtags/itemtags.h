@@ -22,7 +22,9 @@
 
 #include "gui/icons.h"
 #include "item/itemwidgetwrapper.h"
+#include "tagindex.h"
 
+#include <QPointer>
 #include <QVariant>
 #include <QVector>
 #include <QWidget>
@@ -84,6 +86,9 @@ public slots:
     void untag();
     void clearTags();
     bool hasTag();
+    QVariantMap tagCounts();
+    QVariantList taggedRows();
+    QVariantList taggedRowsAny();
 
 private:
     QString askTagName(const QString &dialogTitle, const QStringList &tags);
@@ -93,6 +98,7 @@ private:
     void setTags(int row, const QStringList &tags);
     bool addTag(const QString &tagName, QStringList *tags);
     bool removeTag(const QString &tagName, QStringList *tags);
+    QVariantList taggedRows(const QString &query);
 
     QStringList m_userTags;
 };
@@ -123,6 +129,8 @@ public:
 
     ItemWidget *transform(ItemWidget *itemWidget, const QVariantMap &data) override;
 
+    ItemSaverPtr transformSaver(const ItemSaverPtr &saver, QAbstractItemModel *model) override;
+
     bool matches(const QModelIndex &index, const QRegExp &re) const override;
 
     QObject *tests(const TestInterfacePtr &test) const override;
@@ -152,11 +160,16 @@ private:
 
     Tag tagFromTable(int row);
 
+    /// Returns number of items with the tag in all loaded tabs.
+    int itemCount(const Tag &tag) const;
+
     QVariantMap m_settings;
     Tags m_tags;
     std::unique_ptr<Ui::ItemTagsSettings> ui;
 
     bool m_blockDataChange;
+
+    QList< QPointer<ModelTagIndex> > m_tagIndexes;
 };
 
 #endif // ITEMTAGS_H
@@ -0,0 +1,356 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tagindex.h"
+
+#include "common/contenttype.h"
+#include "common/textdata.h"
+
+#include <QAbstractItemModel>
+
+#include <algorithm>
+
+namespace {
+
+/// Unused tag sets are dropped if there are more of them than this.
+const int maxUnusedTagSetCount = 256;
+
+} // namespace
+
+TagIndex::TagIndex()
+{
+    clear();
+}
+
+void TagIndex::clear()
+{
+    m_rowTagSets.clear();
+    m_tagSets.clear();
+    m_tagSetRowCounts.clear();
+    m_unusedTagSetCount = 0;
+    m_tagSetIds.clear();
+    m_tagCounts.clear();
+    m_filter = QRegExp();
+    m_filterMatches.clear();
+
+    // Tag set for untagged items has always ID 0.
+    tagSetId(QString());
+}
+
+void TagIndex::insertRows(int row, const QStringList &tagTexts)
+{
+    Q_ASSERT(row >= 0 && row <= rowCount());
+
+    m_rowTagSets.insert(row, tagTexts.size(), 0);
+    for (int i = 0; i < tagTexts.size(); ++i) {
+        const int id = tagSetId(tagTexts[i]);
+        m_rowTagSets[row + i] = id;
+        addCounts(id, 1);
+    }
+}
+
+void TagIndex::removeRows(int row, int count)
+{
+    Q_ASSERT(row >= 0 && row + count <= rowCount());
+
+    for (int i = row; i < row + count; ++i)
+        addCounts(m_rowTagSets[i], -1);
+
+    m_rowTagSets.remove(row, count);
+
+    removeUnusedTagSets();
+}
+
+void TagIndex::moveRows(int start, int end, int destinationRow)
+{
+    Q_ASSERT(start >= 0 && start <= end && end < rowCount());
+
+    const auto begin = m_rowTagSets.begin();
+    if (destinationRow > end)
+        std::rotate(begin + start, begin + end + 1, begin + destinationRow);
+    else if (destinationRow < start)
+        std::rotate(begin + destinationRow, begin + start, begin + end + 1);
+}
+
+void TagIndex::setRowTags(int row, const QString &tagText)
+{
+    Q_ASSERT(row >= 0 && row < rowCount());
+
+    const int id = tagSetId(tagText);
+    int &oldId = m_rowTagSets[row];
+    if (oldId == id)
+        return;
+
+    addCounts(oldId, -1);
+    addCounts(id, 1);
+    oldId = id;
+
+    removeUnusedTagSets();
+}
+
+int TagIndex::count(const QString &tag) const
+{
+    return m_tagCounts.value(tag, 0);
+}
+
+QMap<QString, int> TagIndex::counts() const
+{
+    QMap<QString, int> result;
+    for (auto it = m_tagCounts.constBegin(); it != m_tagCounts.constEnd(); ++it) {
+        if (it.value() > 0)
+            result.insert( it.key(), it.value() );
+    }
+    return result;
+}
+
+QBitArray TagIndex::rows(const QStringList &tags, Query query) const
+{
+    QBitArray tagSetMatches(m_tagSets.size());
+    for (int id = 0; id < m_tagSets.size(); ++id) {
+        const auto &tagSetTags = m_tagSets[id].tags;
+        const auto hasTag = [&](const QString &tag) { return tagSetTags.contains(tag); };
+        const bool match = query == Query::AllTags
+                ? std::all_of(tags.begin(), tags.end(), hasTag)
+                : std::any_of(tags.begin(), tags.end(), hasTag);
+        tagSetMatches.setBit(id, match);
+    }
+
+    QBitArray result(rowCount());
+    for (int row = 0; row < rowCount(); ++row) {
+        if ( tagSetMatches.testBit(m_rowTagSets[row]) )
+            result.setBit(row);
+    }
+
+    return result;
+}
+
+bool TagIndex::matches(int row, const QRegExp &re) const
+{
+    Q_ASSERT(row >= 0 && row < rowCount());
+
+    if (m_filter != re) {
+        m_filter = re;
+        m_filterMatches.clear();
+    }
+
+    if ( m_filterMatches.size() < m_tagSets.size() )
+        m_filterMatches.resize( m_tagSets.size() );
+
+    const int id = m_rowTagSets[row];
+    signed char &match = m_filterMatches[id];
+    if (match == 0)
+        match = re.indexIn(m_tagSets[id].text) != -1 ? 1 : -1;
+
+    return match == 1;
+}
+
+int TagIndex::tagSetId(const QString &tagText)
+{
+    const auto it = m_tagSetIds.constFind(tagText);
+    if ( it != m_tagSetIds.constEnd() )
+        return it.value();
+
+    TagSet tagSet;
+    tagSet.text = tagText;
+    tagSet.tags = tagText.split(',', QString::SkipEmptyParts);
+    tagSet.tags.removeDuplicates();
+
+    const int id = m_tagSets.size();
+    m_tagSets.append(tagSet);
+    m_tagSetRowCounts.append(0);
+    ++m_unusedTagSetCount;
+    m_tagSetIds.insert(tagText, id);
+    return id;
+}
+
+void TagIndex::addCounts(int tagSetId, int delta)
+{
+    int &rowCount = m_tagSetRowCounts[tagSetId];
+    if (rowCount == 0)
+        --m_unusedTagSetCount;
+    rowCount += delta;
+    if (rowCount == 0)
+        ++m_unusedTagSetCount;
+
+    for (const auto &tag : m_tagSets[tagSetId].tags)
+        m_tagCounts[tag] += delta;
+}
+
+void TagIndex::removeUnusedTagSets()
+{
+    if (m_unusedTagSetCount <= maxUnusedTagSetCount)
+        return;
+
+    // Tag set for untagged items keeps ID 0.
+    QVector<int> newIds( m_tagSets.size(), -1 );
+    QVector<TagSet> tagSets;
+    QVector<int> tagSetRowCounts;
+    m_tagSetIds.clear();
+    for (int id = 0; id < m_tagSets.size(); ++id) {
+        if (id == 0 || m_tagSetRowCounts[id] > 0) {
+            newIds[id] = tagSets.size();
+            m_tagSetIds.insert( m_tagSets[id].text, tagSets.size() );
+            tagSets.append( m_tagSets[id] );
+            tagSetRowCounts.append( m_tagSetRowCounts[id] );
+        }
+    }
+
+    for (auto &id : m_rowTagSets)
+        id = newIds[id];
+
+    m_tagSets = tagSets;
+    m_tagSetRowCounts = tagSetRowCounts;
+    m_unusedTagSetCount = m_tagSetRowCounts[0] == 0 ? 1 : 0;
+
+    // Cached filter results are for old IDs.
+    m_filterMatches.clear();
+
+    // Remove counts of tags no longer used.
+    for (auto it = m_tagCounts.begin(); it != m_tagCounts.end(); ) {
+        if (it.value() == 0)
+            it = m_tagCounts.erase(it);
+        else
+            ++it;
+    }
+}
+
+ModelTagIndex *ModelTagIndex::attach(QAbstractItemModel *model, const QString &tagsFormat)
+{
+    auto tagIndex = model->findChild<ModelTagIndex*>(QString(), Qt::FindDirectChildrenOnly);
+    if (tagIndex) {
+        tagIndex->rebuild();
+        return tagIndex;
+    }
+
+    return new ModelTagIndex(model, tagsFormat);
+}
+
+const ModelTagIndex *ModelTagIndex::find(const QAbstractItemModel *model)
+{
+    return model->findChild<const ModelTagIndex*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+ModelTagIndex::ModelTagIndex(QAbstractItemModel *model, const QString &tagsFormat)
+    : QObject(model)
+    , m_model(model)
+    , m_tagsFormat(tagsFormat)
+{
+    // Allows server to find the index for the format (see queryItemsIndex()).
+    setObjectName(tagsFormat);
+
+    connect( model, &QAbstractItemModel::rowsInserted,
+             this, &ModelTagIndex::onRowsInserted );
+    connect( model, &QAbstractItemModel::rowsRemoved,
+             this, &ModelTagIndex::onRowsRemoved );
+    connect( model, &QAbstractItemModel::rowsMoved,
+             this, &ModelTagIndex::onRowsMoved );
+    connect( model, &QAbstractItemModel::dataChanged,
+             this, &ModelTagIndex::onDataChanged );
+    connect( model, &QAbstractItemModel::modelReset,
+             this, &ModelTagIndex::rebuild );
+    connect( model, &QAbstractItemModel::layoutChanged,
+             this, &ModelTagIndex::rebuild );
+
+    rebuild();
+}
+
+QVariant ModelTagIndex::query(const QString &name, const QVariantList &arguments) const
+{
+    if (name == "counts") {
+        const auto counts = m_index.counts();
+        QVariantMap result;
+        for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+            result.insert( it.key(), it.value() );
+        return result;
+    }
+
+    if (name == "rows" || name == "rowsAny") {
+        QStringList tags;
+        for (const auto &arg : arguments) {
+            if ( arg.type() == QVariant::List || arg.type() == QVariant::StringList )
+                tags.append( arg.toStringList() );
+            else
+                tags.append( arg.toString() );
+        }
+
+        const auto query = name == "rows" ? TagIndex::Query::AllTags : TagIndex::Query::AnyTag;
+        const auto rows = m_index.rows(tags, query);
+
+        QVariantList result;
+        for (int row = 0; row < rows.size(); ++row) {
+            if ( rows.testBit(row) )
+                result.append(row);
+        }
+        return result;
+    }
+
+    return QVariant();
+}
+
+bool ModelTagIndex::matches(int row, const QRegExp &re) const
+{
+    if ( m_index.rowCount() != m_model->rowCount() )
+        rebuild();
+
+    return m_index.matches(row, re);
+}
+
+void ModelTagIndex::rebuild() const
+{
+    // Clearing the index also drops all tag sets which are no longer used.
+    m_index.clear();
+
+    QStringList tagTexts;
+    for (int row = 0; row < m_model->rowCount(); ++row)
+        tagTexts.append( tagText(row) );
+    m_index.insertRows(0, tagTexts);
+}
+
+QString ModelTagIndex::tagText(int row) const
+{
+    const auto index = m_model->index(row, 0);
+    const auto dataMap = index.data(contentType::data).toMap();
+    return getTextData( dataMap.value(m_tagsFormat).toByteArray() );
+}
+
+void ModelTagIndex::onRowsInserted(const QModelIndex &, int start, int end)
+{
+    QStringList tagTexts;
+    for (int row = start; row <= end; ++row)
+        tagTexts.append( tagText(row) );
+
+    m_index.insertRows(start, tagTexts);
+}
+
+void ModelTagIndex::onRowsRemoved(const QModelIndex &, int start, int end)
+{
+    m_index.removeRows(start, end - start + 1);
+}
+
+void ModelTagIndex::onRowsMoved(
+        const QModelIndex &, int start, int end, const QModelIndex &, int destinationRow)
+{
+    m_index.moveRows(start, end, destinationRow);
+}
+
+void ModelTagIndex::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    for ( int row = topLeft.row(); row <= bottomRight.row(); ++row )
+        m_index.setRowTags( row, tagText(row) );
+}
@@ -0,0 +1,160 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QRegExp>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class QAbstractItemModel;
+class QModelIndex;
+
+/**
+ * Index of item tags for fast filtering and counting of items by tags.
+ *
+ * Each row refers to an interned set of tags (tags of an item), so inserting
+ * or removing rows only shifts a vector of integers, and each distinct
+ * combination of tags is parsed and matched only once.
+ */
+class TagIndex final {
+public:
+    enum class Query {
+        /// Match rows with all given tags.
+        AllTags,
+        /// Match rows with any of given tags.
+        AnyTag
+    };
+
+    TagIndex();
+
+    void clear();
+
+    int rowCount() const { return m_rowTagSets.size(); }
+
+    /// Inserts rows with given comma-separated tags.
+    void insertRows(int row, const QStringList &tagTexts);
+
+    void removeRows(int row, int count);
+
+    /// Moves rows similarly to QAbstractItemModel::rowsMoved().
+    void moveRows(int start, int end, int destinationRow);
+
+    void setRowTags(int row, const QString &tagText);
+
+    /// Returns number of rows with given tag.
+    int count(const QString &tag) const;
+
+    /// Returns number of rows for each tag.
+    QMap<QString, int> counts() const;
+
+    /// Returns rows matching the query (bit for each row).
+    QBitArray rows(const QStringList &tags, Query query) const;
+
+    /// Returns true if comma-separated tags of the row match the expression.
+    bool matches(int row, const QRegExp &re) const;
+
+    /// Returns number of interned tag sets (including unused ones).
+    int tagSetCount() const { return m_tagSets.size(); }
+
+private:
+    struct TagSet {
+        QString text;
+        QStringList tags;
+    };
+
+    int tagSetId(const QString &tagText);
+    void addCounts(int tagSetId, int delta);
+
+    /// Drops tag sets which are not used by any row.
+    void removeUnusedTagSets();
+
+    QVector<int> m_rowTagSets;
+    QVector<TagSet> m_tagSets;
+    /// Number of rows for each tag set.
+    QVector<int> m_tagSetRowCounts;
+    int m_unusedTagSetCount = 0;
+    QHash<QString, int> m_tagSetIds;
+    QHash<QString, int> m_tagCounts;
+
+    // Cached results of matches() for each tag set.
+    mutable QRegExp m_filter;
+    mutable QVector<signed char> m_filterMatches;
+};
+
+/**
+ * Keeps TagIndex up to date with tags in a model.
+ *
+ * The object is owned by the model.
+ */
+class ModelTagIndex final : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * Returns tag index for the model (creates it if needed).
+     *
+     * Existing index is rebuilt since items could be loaded into the model
+     * while its signals were blocked.
+     */
+    static ModelTagIndex *attach(QAbstractItemModel *model, const QString &tagsFormat);
+
+    /// Returns tag index for the model or nullptr if it doesn't exist.
+    static const ModelTagIndex *find(const QAbstractItemModel *model);
+
+    const TagIndex &index() const { return m_index; }
+
+    /**
+     * Returns true if tags of the row match the expression.
+     *
+     * The index is rebuilt first if it has different number of rows than the model.
+     */
+    bool matches(int row, const QRegExp &re) const;
+
+    /**
+     * Answers queries for queryItemsIndex() script function in server.
+     *
+     * Supported queries are "counts" (no arguments), "rows" and "rowsAny"
+     * (tag names as arguments).
+     */
+    Q_INVOKABLE QVariant query(const QString &name, const QVariantList &arguments) const;
+
+private:
+    ModelTagIndex(QAbstractItemModel *model, const QString &tagsFormat);
+
+    void rebuild() const;
+    QString tagText(int row) const;
+
+    void onRowsInserted(const QModelIndex &parent, int start, int end);
+    void onRowsRemoved(const QModelIndex &parent, int start, int end);
+    void onRowsMoved(const QModelIndex &, int start, int end, const QModelIndex &, int destinationRow);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+    QAbstractItemModel *m_model;
+    QString m_tagsFormat;
+    mutable TagIndex m_index;
+};
+
+#endif // TAGINDEX_H
@@ -21,6 +21,10 @@
 
 #include "tests/test_utils.h"
 
+#include "../tagindex.h"
+
+#include <QRegExp>
+
 namespace {
 
 QString testTag(int i)
@@ -28,6 +32,19 @@ QString testTag(int i)
     return "TAG_&" + QString::number(i);
 }
 
+/// Returns number of calls of given function in server from output of "metrics" command.
+qint64 serverCallCount(const QByteArray &metrics, const QByteArray &method)
+{
+    const QByteArray prefix = "\ncopyq_ipc_calls_total{method=\"" + method + "\"} ";
+    const int start = metrics.indexOf(prefix);
+    if (start == -1)
+        return 0;
+
+    const int valueStart = start + prefix.size();
+    const int end = metrics.indexOf('\n', valueStart);
+    return metrics.mid(valueStart, end - valueStart).toLongLong();
+}
+
 } // namespace
 
 ItemTagsTests::ItemTagsTests(const TestInterfacePtr &test, QObject *parent)
@@ -214,6 +231,64 @@ void ItemTagsTests::searchTags()
     RUN(args << "testSelected", tab1 + " 2 2\n");
 }
 
+void ItemTagsTests::tagCounts()
+{
+    const QString tab1 = testTab(1);
+    const Args args = Args() << "tab" << tab1;
+    RUN(args << "add" << "A" << "B" << "C" << "D", "");
+    RUN(args << "-e" << "plugins.itemtags.tag('tag1', 0, 1)", "");
+    RUN(args << "-e" << "plugins.itemtags.tag('tag2', 1, 2)", "");
+    RUN(args << "-e" << "JSON.stringify(plugins.itemtags.tagCounts())", "{\"tag1\":2,\"tag2\":2}\n");
+    RUN(args << "-e" << "plugins.itemtags.taggedRows('tag1', 'tag2')", "1\n");
+    RUN(args << "-e" << "plugins.itemtags.taggedRowsAny('tag1', 'tag2')", "0\n1\n2\n");
+
+    RUN(args << "remove" << "1", "");
+    RUN(args << "-e" << "JSON.stringify(plugins.itemtags.tagCounts())", "{\"tag1\":1,\"tag2\":1}\n");
+    RUN(args << "-e" << "plugins.itemtags.taggedRows('tag2')", "1\n");
+}
+
+void ItemTagsTests::tagLookupUsesIndex()
+{
+    const QString tab1 = testTab(1);
+    const Args args = Args() << "tab" << tab1;
+    RUN(args << "add" << "A" << "B" << "C", "");
+    RUN(args << "-e" << "plugins.itemtags.tag('tag1', 0, 2)", "");
+
+    QByteArray before;
+    TEST( m_test->getClientOutput(Args("metrics"), &before) );
+
+    RUN(args << "-e" << "JSON.stringify(plugins.itemtags.tagCounts())", "{\"tag1\":2}\n");
+    RUN(args << "-e" << "plugins.itemtags.taggedRows('tag1')", "0\n2\n");
+    RUN(args << "-e" << "plugins.itemtags.taggedRowsAny('tag1', 'tag2')", "0\n2\n");
+
+    QByteArray after;
+    TEST( m_test->getClientOutput(Args("metrics"), &after) );
+
+    // Lookups are answered from index in server without reading items.
+    QCOMPARE( serverCallCount(after, "browserItemsIndexQuery"),
+              serverCallCount(before, "browserItemsIndexQuery") + 3 );
+    for (const QByteArray method : {"browserItemData", "browserItemsFormats", "selectedItemsFormats"})
+        QCOMPARE( serverCallCount(after, method), serverCallCount(before, method) );
+}
+
+void ItemTagsTests::tagIndexDropsUnusedTagSets()
+{
+    TagIndex index;
+    index.insertRows( 0, QStringList() << "a" << "b,c" );
+
+    for (int i = 0; i < 1000; ++i)
+        index.setRowTags( 0, "x" + QString::number(i) );
+
+    QVERIFY2( index.tagSetCount() < 500, qPrintable(QString::number(index.tagSetCount())) );
+    QCOMPARE( index.count("a"), 0 );
+    QCOMPARE( index.count("x998"), 0 );
+    QCOMPARE( index.count("x999"), 1 );
+    QCOMPARE( index.count("c"), 1 );
+    QVERIFY( index.matches(0, QRegExp("^x999$")) );
+    QVERIFY( index.matches(1, QRegExp("^b,c$")) );
+    QVERIFY( !index.matches(1, QRegExp("x")) );
+}
+
 void ItemTagsTests::tagSelected()
 {
     const auto script = R"(
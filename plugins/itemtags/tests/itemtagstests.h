@@ -43,6 +43,9 @@ private slots:
     void untag();
     void clearTags();
     void searchTags();
+    void tagCounts();
+    void tagLookupUsesIndex();
+    void tagIndexDropsUnusedTagSets();
 
     void tagSelected();
     void untagSelected();
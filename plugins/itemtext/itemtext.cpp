@@ -20,6 +20,10 @@
 #include "itemtext.h"
 #include "ui_itemtextsettings.h"
 
+#ifdef HAS_TESTS
+#   include "tests/itemtexttests.h"
+#endif
+
 #include "common/mimetypes.h"
 #include "common/textdata.h"
 
@@ -35,6 +39,8 @@
 #include <QTextDocument>
 #include <QtPlugin>
 
+#include <algorithm>
+
 namespace {
 
 // Limit number of characters for performance reasons.
@@ -48,6 +54,11 @@ const int maxLineLengthInPreview = 16 * maxLineLength;
 const int maxLineCount = 4 * 1024;
 const int maxLineCountInPreview = 16 * maxLineCount;
 
+// Size of text chunks (in bytes) loaded on demand in item preview.
+const int textChunkSize = 128 * 1024;
+// Maximum number of text chunks laid out in item preview.
+const int maxTextChunkCountInPreview = 32;
+
 const char optionUseRichText[] = "use_rich_text";
 const char optionMaximumLines[] = "max_lines";
 const char optionMaximumHeight[] = "max_height";
@@ -62,40 +73,43 @@ void removeTrailingNull(QString *text)
         text->chop(1);
 }
 
+/// Decodes only beginning of text which can be shown.
+QString getLimitedTextData(const QVariantMap &dataMap, const QString &mime)
+{
+    const QByteArray bytes = dataMap.value(mime).toByteArray();
+    QString text = getTextData(bytes, maxCharacters + 1);
+    if (text.size() > maxCharacters)
+        text.truncate(maxCharacters);
+    else
+        removeTrailingNull(&text);
+    return text;
+}
+
 bool getRichText(const QVariantMap &dataMap, QString *text)
 {
     if ( dataMap.contains(mimeHtml) ) {
-        *text = getTextData(dataMap, mimeHtml);
+        *text = getLimitedTextData(dataMap, mimeHtml);
         return true;
     }
 
     if ( dataMap.contains(mimeRichText) ) {
-        *text = getTextData(dataMap, mimeRichText);
+        *text = getLimitedTextData(dataMap, mimeRichText);
         return true;
     }
 
     return false;
 }
 
-bool getText(const QVariantMap &dataMap, QString *text)
+/// Returns plain text format (empty if not available).
+QString getTextFormat(const QVariantMap &dataMap)
 {
-    if ( dataMap.contains(mimeText) ) {
-        *text = getTextData(dataMap, mimeText);
-        return true;
-    }
+    if ( dataMap.contains(mimeText) )
+        return mimeText;
 
-    if ( dataMap.contains(mimeUriList) ) {
-        *text = getTextData(dataMap, mimeUriList);
-        return true;
-    }
+    if ( dataMap.contains(mimeUriList) )
+        return mimeUriList;
 
-    return false;
-}
-
-QString normalizeText(QString text)
-{
-    removeTrailingNull(&text);
-    return text.left(maxCharacters);
+    return QString();
 }
 
 void insertEllipsis(QTextCursor *tc)
@@ -113,6 +127,7 @@ ItemText::ItemText(const QString &text, const QString &richText, int maxLines, i
     , ItemWidget(this)
     , m_textDocument()
     , m_maximumHeight(maximumHeight)
+    , m_lineLength(lineLength)
 {
     m_textDocument.setDefaultFont(font());
 
@@ -152,16 +167,7 @@ ItemText::ItemText(const QString &text, const QString &richText, int maxLines, i
         }
     }
 
-    if (lineLength > 0) {
-        for ( auto block = m_textDocument.begin(); block.isValid(); block = block.next() ) {
-            if ( block.length() > lineLength ) {
-                QTextCursor tc(&m_textDocument);
-                tc.setPosition(block.position() + lineLength);
-                tc.setPosition(block.position() + block.length() - 1, QTextCursor::KeepAnchor);
-                insertEllipsis(&tc);
-            }
-        }
-    }
+    elideLongLines( m_textDocument.begin() );
 
     setDocument(&m_textDocument);
 
@@ -169,15 +175,68 @@ ItemText::ItemText(const QString &text, const QString &richText, int maxLines, i
              this, &ItemText::onSelectionChanged );
 }
 
+void ItemText::setRemainingText(const QByteArray &bytes, int position, int chunkSize, int maxChunkCount)
+{
+    if ( position >= bytes.size() )
+        return;
+
+    const bool connectScrollBar = m_text.isEmpty();
+
+    m_text = bytes;
+    m_textChunkSize = chunkSize;
+    m_maxTextChunkCount = qMax(2, maxChunkCount);
+
+    // Shown text is the first chunk.
+    m_chunkPositions.clear();
+    m_chunkPositions.append(0);
+    m_chunkTextPositions.clear();
+    m_firstTextChunk = 0;
+    m_lastTextChunk = 0;
+    if (position > 0) {
+        m_chunkPositions.append(position);
+        m_chunkTextPositions.append(0);
+        m_lastTextChunk = 1;
+    }
+
+    if (connectScrollBar) {
+        connect( verticalScrollBar(), &QScrollBar::valueChanged,
+                 this, &ItemText::onScrolled );
+    }
+}
+
 void ItemText::highlight(const QRegExp &re, const QFont &highlightFont, const QPalette &highlightPalette)
+{
+    m_highlightExpression = re;
+    m_highlightFont = highlightFont;
+    m_highlightPalette = highlightPalette;
+
+    // Search rest of the text only if there is no match in the shown part.
+    const bool seekToMatch = !re.isEmpty()
+            && !m_text.isEmpty()
+            && m_textDocument.find(re).isNull()
+            && loadTextUntilMatch(re);
+
+    updateHighlight();
+
+    const auto selections = extraSelections();
+    if ( seekToMatch && !selections.isEmpty() ) {
+        QTextCursor tc = selections.first().cursor;
+        tc.clearSelection();
+        setTextCursor(tc);
+        ensureCursorVisible();
+    }
+}
+
+void ItemText::updateHighlight()
 {
     QList<QTextEdit::ExtraSelection> selections;
 
+    const QRegExp &re = m_highlightExpression;
     if ( !re.isEmpty() ) {
         QTextEdit::ExtraSelection selection;
-        selection.format.setBackground( highlightPalette.base() );
-        selection.format.setForeground( highlightPalette.text() );
-        selection.format.setFont(highlightFont);
+        selection.format.setBackground( m_highlightPalette.base() );
+        selection.format.setForeground( m_highlightPalette.text() );
+        selection.format.setFont(m_highlightFont);
 
         QTextCursor cur = m_textDocument.find(re);
         int a = cur.position();
@@ -259,6 +318,180 @@ QMimeData *ItemText::createMimeDataFromSelection() const
     return data;
 }
 
+void ItemText::onScrolled(int value)
+{
+    if (m_loadingText)
+        return;
+
+    // Load more text before the end or the beginning is reached.
+    const auto scrollBar = verticalScrollBar();
+    const int margin = 2 * viewport()->height();
+    if ( scrollBar->maximum() - value < margin && hasTextChunk(m_lastTextChunk) )
+        loadMoreText();
+    else if ( value < margin && m_firstTextChunk > 0 )
+        loadPreviousText();
+    else
+        return;
+
+    if ( !m_highlightExpression.isEmpty() )
+        updateHighlight();
+}
+
+void ItemText::loadMoreText()
+{
+    if ( m_lastTextChunk - m_firstTextChunk < m_maxTextChunkCount ) {
+        // Text is only appended so scroll position and selection are kept.
+        m_loadingText = true;
+        appendTextChunk();
+        m_loadingText = false;
+    } else {
+        // Drop older part of the text so layout is kept small.
+        const int lastChunk = m_lastTextChunk + 1;
+        showTextChunks( lastChunk - slidingTextChunkCount(), lastChunk );
+    }
+}
+
+void ItemText::loadPreviousText()
+{
+    const int firstChunk = qMax(0, m_firstTextChunk - slidingTextChunkCount());
+    const int lastChunk = qMin(m_lastTextChunk, firstChunk + m_maxTextChunkCount);
+    showTextChunks(firstChunk, lastChunk);
+}
+
+int ItemText::slidingTextChunkCount() const
+{
+    // At least two chunks are kept so matches across chunk boundary are shown.
+    return qMax(2, m_maxTextChunkCount / 2);
+}
+
+bool ItemText::hasTextChunk(int chunk) const
+{
+    return chunk < m_chunkPositions.size() && m_chunkPositions[chunk] < m_text.size();
+}
+
+QString ItemText::textChunk(int chunk)
+{
+    // Chunk boundaries depend on UTF-8 encoding so they are remembered
+    // when a chunk is decoded for the first time.
+    int position = m_chunkPositions[chunk];
+    QString text = getTextDataChunk(m_text, &position, m_textChunkSize);
+    if ( chunk + 1 == m_chunkPositions.size() )
+        m_chunkPositions.append(position);
+    if ( position >= m_text.size() )
+        removeTrailingNull(&text);
+    return text;
+}
+
+void ItemText::appendTextChunk()
+{
+    const QString text = textChunk(m_lastTextChunk);
+
+    QTextCursor tc(&m_textDocument);
+    tc.movePosition(QTextCursor::End);
+    m_chunkTextPositions.append( tc.position() );
+    const QTextBlock firstChangedBlock = tc.block();
+    tc.insertText( text, QTextCharFormat() );
+    ++m_lastTextChunk;
+
+    elideLongLines(firstChangedBlock);
+}
+
+void ItemText::showTextChunks(int firstChunk, int lastChunk)
+{
+    m_loadingText = true;
+
+    // Remember text shown at the top to restore scroll position.
+    const int topPosition = cursorForPosition(QPoint(0, 0)).position();
+    const auto topChunkIt = std::upper_bound(
+                m_chunkTextPositions.constBegin(), m_chunkTextPositions.constEnd(), topPosition);
+    const int topChunkIndex = static_cast<int>(topChunkIt - m_chunkTextPositions.constBegin()) - 1;
+    const int topChunk = m_firstTextChunk + topChunkIndex;
+    const int topOffset = topChunkIndex >= 0
+            ? topPosition - m_chunkTextPositions[topChunkIndex] : 0;
+
+    QTextCursor tc(&m_textDocument);
+    tc.select(QTextCursor::Document);
+    tc.removeSelectedText();
+
+    m_chunkTextPositions.clear();
+    m_firstTextChunk = firstChunk;
+    m_lastTextChunk = firstChunk;
+    while (m_lastTextChunk < lastChunk)
+        appendTextChunk();
+
+    if (firstChunk <= topChunk && topChunk < lastChunk) {
+        tc.setPosition( qMin(
+            m_chunkTextPositions[topChunk - firstChunk] + topOffset,
+            m_textDocument.characterCount() - 1) );
+        const auto scrollBar = verticalScrollBar();
+        scrollBar->setValue( scrollBar->value() + cursorRect(tc).top() );
+    }
+
+    m_loadingText = false;
+}
+
+int ItemText::findInTextChunks(const QRegExp &re, int firstChunk, int lastChunk, QString previousText)
+{
+    // Each chunk is searched together with the end of the previous one so
+    // that matches spanning chunk boundaries are found (pattern length
+    // is the match length for plain text).
+    const int overlap = qMax(0, re.pattern().size() - 1);
+
+    for (int chunk = firstChunk; (lastChunk == -1 || chunk < lastChunk) && hasTextChunk(chunk); ++chunk) {
+        const QString text = previousText + textChunk(chunk);
+        if ( re.indexIn(text) != -1 )
+            return chunk;
+        previousText = text.right(overlap);
+    }
+
+    return -1;
+}
+
+bool ItemText::loadTextUntilMatch(const QRegExp &re)
+{
+    const int overlap = qMax(0, re.pattern().size() - 1);
+    QTextCursor tc(&m_textDocument);
+    tc.movePosition(QTextCursor::End);
+    tc.movePosition(QTextCursor::Left, QTextCursor::KeepAnchor, overlap);
+    const QString previousText = tc.selectedText().replace(QChar::ParagraphSeparator, '\n');
+
+    // Decode and search whole text in chunks without laying it out,
+    // starting after the shown text.
+    int chunk = findInTextChunks(re, m_lastTextChunk, -1, previousText);
+    if (chunk == -1 && m_firstTextChunk > 0)
+        chunk = findInTextChunks(re, 0, m_firstTextChunk + 1, QString());
+    if (chunk == -1)
+        return false;
+
+    if ( m_lastTextChunk <= chunk && chunk < m_firstTextChunk + m_maxTextChunkCount ) {
+        // Chunks are loaded up to the match.
+        m_loadingText = true;
+        while (m_lastTextChunk <= chunk)
+            appendTextChunk();
+        m_loadingText = false;
+    } else {
+        const int lastChunk = chunk + 1;
+        showTextChunks( qMax(0, lastChunk - slidingTextChunkCount()), lastChunk );
+    }
+
+    return true;
+}
+
+void ItemText::elideLongLines(QTextBlock block)
+{
+    if (m_lineLength <= 0)
+        return;
+
+    for ( ; block.isValid(); block = block.next() ) {
+        if ( block.length() > m_lineLength ) {
+            QTextCursor tc(&m_textDocument);
+            tc.setPosition(block.position() + m_lineLength);
+            tc.setPosition(block.position() + block.length() - 1, QTextCursor::KeepAnchor);
+            insertEllipsis(&tc);
+        }
+    }
+}
+
 void ItemText::onSelectionChanged()
 {
     // Expand the ellipsis if selected.
@@ -289,20 +522,28 @@ ItemWidget *ItemTextLoader::create(const QVariantMap &data, QWidget *parent, boo
     const bool isRichText = m_settings.value(optionUseRichText, true).toBool()
             && getRichText(data, &richText);
 
-    QString text;
-    const bool isPlainText = getText(data, &text);
+    const QString textFormat = getTextFormat(data);
+    const bool isPlainText = !textFormat.isEmpty();
 
     if (!isRichText && !isPlainText)
         return nullptr;
 
-    richText = normalizeText(richText);
-    text = normalizeText(text);
-
     ItemText *item = nullptr;
     // Always limit text size for performance reasons.
-    if (preview) {
+    if (preview && !isRichText) {
+        // Lay out only beginning of long text, rest is loaded on demand.
+        const QByteArray bytes = data.value(textFormat).toByteArray();
+        int position = 0;
+        QString text = getTextDataChunk(bytes, &position, textChunkSize);
+        if ( position >= bytes.size() )
+            removeTrailingNull(&text);
+        item = new ItemText(text, QString(), 0, maxLineLengthInPreview, 0, parent);
+        item->setRemainingText(bytes, position, textChunkSize, maxTextChunkCountInPreview);
+    } else if (preview) {
+        const QString text = isPlainText ? getLimitedTextData(data, textFormat) : QString();
         item = new ItemText(text, richText, maxLineCountInPreview, maxLineLengthInPreview, 0, parent);
     } else {
+        const QString text = isPlainText ? getLimitedTextData(data, textFormat) : QString();
         int maxLines = m_settings.value(optionMaximumLines, maxLineCount).toInt();
         if (maxLines <= 0 || maxLines > maxLineCount)
             maxLines = maxLineCount;
@@ -339,3 +580,14 @@ QWidget *ItemTextLoader::createSettingsWidget(QWidget *parent)
     ui->spinBoxMaxHeight->setValue( m_settings.value(optionMaximumHeight, 0).toInt() );
     return w;
 }
+
+QObject *ItemTextLoader::tests(const TestInterfacePtr &test) const
+{
+#ifdef HAS_TESTS
+    QObject *tests = new ItemTextTests(test);
+    return tests;
+#else
+    Q_UNUSED(test);
+    return nullptr;
+#endif
+}
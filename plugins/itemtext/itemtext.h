@@ -23,12 +23,18 @@
 #include "gui/icons.h"
 #include "item/itemwidget.h"
 
+#include <QFont>
+#include <QPalette>
+#include <QRegExp>
 #include <QTextDocument>
 #include <QTextDocumentFragment>
 #include <QTextEdit>
+#include <QVector>
 
 #include <memory>
 
+class QTextBlock;
+
 namespace Ui {
 class ItemTextSettings;
 }
@@ -40,6 +46,18 @@ class ItemText : public QTextEdit, public ItemWidget
 public:
     ItemText(const QString &text, const QString &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent);
 
+    /**
+     * Set UTF-8 encoded plain text which is not yet shown, starting at byte @a position.
+     *
+     * The text is decoded and laid out in chunks of @a chunkSize bytes only
+     * when scrolled near the end of the widget or when searched text is found in it.
+     *
+     * At most @a maxChunkCount chunks (including the shown text) are laid out
+     * at once; chunks far from the shown part are dropped from the layout
+     * and loaded again when scrolled back. Search goes through the whole text.
+     */
+    void setRemainingText(const QByteArray &bytes, int position, int chunkSize, int maxChunkCount);
+
 protected:
     void highlight(const QRegExp &re, const QFont &highlightFont,
                            const QPalette &highlightPalette) override;
@@ -52,12 +70,59 @@ protected:
 
 private:
     void onSelectionChanged();
+    void onScrolled(int value);
+
+    /// Shows next chunk of text, drops older chunks if too many are shown.
+    void loadMoreText();
+
+    /// Shows chunks of text before the shown ones.
+    void loadPreviousText();
+
+    /// Number of chunks shown after chunks were dropped.
+    int slidingTextChunkCount() const;
+
+    bool hasTextChunk(int chunk) const;
+
+    /// Decodes chunk of text (boundary of the next chunk must be known).
+    QString textChunk(int chunk);
+
+    void appendTextChunk();
+
+    /// Replaces shown text with chunks from @a firstChunk to @a lastChunk (exclusive).
+    void showTextChunks(int firstChunk, int lastChunk);
+
+    /// Returns chunk with end of first match (-1 if nothing found; @a lastChunk -1 searches to the end).
+    int findInTextChunks(const QRegExp &re, int firstChunk, int lastChunk, QString previousText);
+
+    /// Shows text around first match (returns false if nothing found).
+    bool loadTextUntilMatch(const QRegExp &re);
+
+    void elideLongLines(QTextBlock block);
+
+    void updateHighlight();
 
     QTextDocument m_textDocument;
     QTextDocumentFragment m_elidedFragment;
     int m_ellipsisPosition = -1;
     int m_maximumHeight;
+    int m_lineLength;
     bool m_isRichText = false;
+
+    /// Whole plain text for item preview (laid out only partially).
+    QByteArray m_text;
+    /// Byte positions of text chunks decoded so far.
+    QVector<int> m_chunkPositions;
+    /// Document positions of shown chunks.
+    QVector<int> m_chunkTextPositions;
+    int m_firstTextChunk = 0;
+    int m_lastTextChunk = 0;
+    int m_textChunkSize = 0;
+    int m_maxTextChunkCount = 0;
+    bool m_loadingText = false;
+
+    QRegExp m_highlightExpression;
+    QFont m_highlightFont;
+    QPalette m_highlightPalette;
 };
 
 class ItemTextLoader : public QObject, public ItemLoaderInterface
@@ -86,6 +151,8 @@ public:
 
     QWidget *createSettingsWidget(QWidget *parent) override;
 
+    QObject *tests(const TestInterfacePtr &test) const override;
+
 private:
     QVariantMap m_settings;
     std::unique_ptr<Ui::ItemTextSettings> ui;
@@ -0,0 +1,139 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemtexttests.h"
+
+#include "tests/test_utils.h"
+#include "common/textdata.h"
+
+#include "../itemtext.h"
+
+#include <QFont>
+#include <QPalette>
+#include <QRegExp>
+
+namespace {
+
+void highlight(ItemText *item, const QString &text)
+{
+    ItemWidget *itemWidget = item;
+    itemWidget->setHighlight( QRegExp(text, Qt::CaseSensitive, QRegExp::FixedString), QFont(), QPalette() );
+}
+
+} // namespace
+
+ItemTextTests::ItemTextTests(const TestInterfacePtr &test, QObject *parent)
+    : QObject(parent)
+    , m_test(test)
+{
+}
+
+void ItemTextTests::initTestCase()
+{
+    TEST(m_test->initTestCase());
+}
+
+void ItemTextTests::cleanupTestCase()
+{
+    TEST(m_test->cleanupTestCase());
+}
+
+void ItemTextTests::init()
+{
+    TEST(m_test->init());
+}
+
+void ItemTextTests::cleanup()
+{
+    TEST( m_test->cleanup() );
+}
+
+void ItemTextTests::searchAcrossChunks()
+{
+    const QByteArray bytes = "0123456789ABCDEFGHIJKLMNOPQRSTUV";
+    ItemText item(bytes.left(8), QString(), 0, 0, 0, nullptr);
+    item.setRemainingText(bytes, 8, 8, 100);
+    QCOMPARE( item.toPlainText(), QString("01234567") );
+
+    // Match spans shown text and first chunk.
+    highlight(&item, "6789");
+    QCOMPARE( item.toPlainText(), QString(bytes.left(16)) );
+    QCOMPARE( item.extraSelections().size(), 1 );
+
+    // Match spans two chunks which are not loaded.
+    highlight(&item, "EFGH");
+    QCOMPARE( item.toPlainText(), QString(bytes.left(24)) );
+    QCOMPARE( item.extraSelections().size(), 1 );
+
+    highlight(&item, "UV");
+    QCOMPARE( item.toPlainText(), QString(bytes) );
+}
+
+void ItemTextTests::searchMultiByteChunks()
+{
+    const QString text = QString::fromUtf8("ěščřžýáíé ĚŠČŘŽÝÁÍÉ");
+    const QByteArray bytes = text.toUtf8();
+
+    // Chunk size is odd so most chunks end in the middle of a character.
+    const int chunkSize = 3;
+    int position = 0;
+    const QString firstChunk = getTextDataChunk(bytes, &position, chunkSize);
+    ItemText item(firstChunk, QString(), 0, 0, 0, nullptr);
+    item.setRemainingText(bytes, position, chunkSize, 100);
+
+    highlight( &item, QString::fromUtf8("ÁÍ") );
+    QVERIFY( item.toPlainText().endsWith(QString::fromUtf8("ÁÍ")) );
+
+    highlight( &item, QString::fromUtf8("ÍÉ") );
+    QCOMPARE( item.toPlainText(), text );
+}
+
+void ItemTextTests::chunkWindow()
+{
+    const QByteArray bytes = "aaaabbbbccccddddNEEDLE";
+    const int chunkSize = 4;
+    const int maxChunkCount = 3;
+
+    ItemText item(bytes.left(chunkSize), QString(), 0, 0, 0, nullptr);
+    item.setRemainingText(bytes, chunkSize, chunkSize, maxChunkCount);
+
+    // Text over the limit is searched; only chunks around the match are shown.
+    highlight(&item, "NEEDLE");
+    QCOMPARE( item.toPlainText(), QString("NEEDLE") );
+    QCOMPARE( item.extraSelections().size(), 1 );
+
+    // Text before the shown chunks is searched too.
+    highlight(&item, "aaaa");
+    QCOMPARE( item.toPlainText(), QString("aaaa") );
+    QCOMPARE( item.extraSelections().size(), 1 );
+
+    // Chunks are appended up to the limit.
+    highlight(&item, "bc");
+    QCOMPARE( item.toPlainText(), QString("aaaabbbbcccc") );
+    QCOMPARE( item.extraSelections().size(), 1 );
+
+    // Older chunks are dropped over the limit.
+    highlight(&item, "cd");
+    QCOMPARE( item.toPlainText(), QString("ccccdddd") );
+    QCOMPARE( item.extraSelections().size(), 1 );
+
+    highlight(&item, "missing");
+    QVERIFY( item.extraSelections().isEmpty() );
+    QCOMPARE( item.toPlainText(), QString("ccccdddd") );
+}
@@ -161,6 +161,9 @@ App::App(QCoreApplication *application,
 #ifdef HAS_TESTS
     initTests();
 #endif
+
+    // Start after session name is final since it determines the log file.
+    startLogWriter();
 }
 
 App::~App()
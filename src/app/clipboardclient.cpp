@@ -46,6 +46,8 @@ QString messageCodeToString(int code)
         return "CommandFunctionCallReturnValue";
     case CommandInputDialogFinished:
         return "CommandInputDialogFinished";
+    case CommandProvideClipboard:
+        return "CommandProvideClipboard";
     case CommandStop:
         return "CommandStop";
     default:
@@ -107,6 +109,11 @@ void ClipboardClient::onMessageReceived(const QByteArray &data, int messageCode)
         break;
     }
 
+    case CommandProvideClipboard: {
+        emit provideClipboardReceived(data);
+        break;
+    }
+
     case CommandStop: {
         exit(0);
         break;
@@ -157,6 +164,8 @@ void ClipboardClient::start(const QStringList &arguments)
              &scriptableProxy, &ScriptableProxy::setFunctionCallReturnValue );
     connect( this, &ClipboardClient::inputDialogFinished,
              &scriptableProxy, &ScriptableProxy::setInputDialogResult );
+    connect( this, &ClipboardClient::provideClipboardReceived,
+             &scriptableProxy, &ScriptableProxy::setProvideClipboardData );
 
     connect( &socket, &ClientSocket::disconnected,
              &scriptable, &Scriptable::abort );
@@ -24,9 +24,12 @@
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "gui/actionhandler.h"
+#include "item/serialize.h"
 #include "platform/platformclipboard.h"
 #include "platform/platformnativeinterface.h"
+#include "scriptable/scriptableproxy.h"
 
+#include <QPointer>
 #include <QTimer>
 
 class ClipboardManagerPrivate {
@@ -55,16 +58,56 @@ public:
         // Provide clipboard here first to be able to paste quickly.
         createPlatformNativeInterface()->clipboard()->setData(mode, data);
 
-        // Start separate process later to take over clipboard ownership.
+        // Hand over clipboard ownership to provider process right away if it's running,
+        // otherwise start separate process later.
         if (mode == ClipboardMode::Clipboard) {
             m_clipboardData = data;
-            m_timerProvideClipboard.start();
+            if (m_provider)
+                provideClipboard(ClipboardMode::Clipboard, "provideClipboard", &m_clipboardData);
+            else
+                m_timerProvideClipboard.start();
         } else {
             m_selectionData = data;
-            m_timerProvideSelection.start();
+            if (m_provider)
+                provideClipboard(ClipboardMode::Selection, "provideSelection", &m_selectionData);
+            else
+                m_timerProvideSelection.start();
         }
     }
 
+    void setProvider(ScriptableProxy *provider)
+    {
+        m_provider = provider;
+
+        // Send data which were set while the provider was starting.
+        if ( !m_clipboardData.isEmpty() )
+            provideClipboard(ClipboardMode::Clipboard, "provideClipboard", &m_clipboardData);
+        if ( !m_selectionData.isEmpty() )
+            provideClipboard(ClipboardMode::Selection, "provideSelection", &m_selectionData);
+    }
+
+    void unsetProvider(ScriptableProxy *provider)
+    {
+        if (m_provider != provider)
+            return;
+
+        m_provider = nullptr;
+
+        // Clipboard is still owned by this process if the provider exited
+        // before taking over the last data.
+        if ( m_clipboardData.isEmpty() )
+            m_clipboardData = m_providedClipboardData;
+        if ( m_selectionData.isEmpty() )
+            m_selectionData = m_providedSelectionData;
+        m_providedClipboardData.clear();
+        m_providedSelectionData.clear();
+
+        if ( !m_clipboardData.isEmpty() )
+            provideClipboard(ClipboardMode::Clipboard, "provideClipboard", &m_clipboardData);
+        if ( !m_selectionData.isEmpty() )
+            provideClipboard(ClipboardMode::Selection, "provideSelection", &m_selectionData);
+    }
+
 private:
     void provideClipboard(ClipboardMode mode, const QString &scriptFunctionName, QVariantMap *data)
     {
@@ -72,18 +115,35 @@ private:
         if ( owner != data->value(mimeOwner).toByteArray() )
             return;
 
+        if (m_provider) {
+            m_provider->sendProvideClipboardData(*data, mode);
+            auto &providedData = mode == ClipboardMode::Clipboard
+                    ? m_providedClipboardData : m_providedSelectionData;
+            providedData = *data;
+            data->clear();
+            return;
+        }
+
+        // Wait for the starting provider to register.
+        if (m_providerAction)
+            return;
+
         auto action = new Action();
         action->setCommand(QStringList() << "copyq" << scriptFunctionName);
         action->setData(*data);
         data->clear();
-        m_actionHandler->internalAction(action);
+        m_providerAction = m_actionHandler->internalAction(action);
     }
 
     ActionHandler *m_actionHandler;
+    QPointer<Action> m_providerAction;
+    QPointer<ScriptableProxy> m_provider;
     QTimer m_timerProvideClipboard;
     QTimer m_timerProvideSelection;
     QVariantMap m_clipboardData;
     QVariantMap m_selectionData;
+    QVariantMap m_providedClipboardData;
+    QVariantMap m_providedSelectionData;
 };
 
 ClipboardManager::ClipboardManager(ActionHandler *actionHandler)
@@ -106,5 +166,16 @@ void ClipboardManager::setClipboard(const QVariantMap &data, ClipboardMode mode)
             return;
 #endif
 
-    d->setClipboard(data, mode);
+    // Clipboard data can outlive tab with the item.
+    d->setClipboard(detachedMappedData(data), mode);
+}
+
+void ClipboardManager::setProvider(ScriptableProxy *provider)
+{
+    d->setProvider(provider);
+}
+
+void ClipboardManager::unsetProvider(ScriptableProxy *provider)
+{
+    d->unsetProvider(provider);
 }
@@ -28,6 +28,7 @@
 
 class ActionHandler;
 class ClipboardManagerPrivate;
+class ScriptableProxy;
 
 class ClipboardManager {
 public:
@@ -38,6 +39,22 @@ public:
     void setClipboard(const QVariantMap &data);
     void setClipboard(const QVariantMap &data, ClipboardMode mode);
 
+    /**
+     * Sets running clipboard provider.
+     *
+     * New clipboard data are sent to the provider right away
+     * instead of starting new process each time.
+     */
+    void setProvider(ScriptableProxy *provider);
+
+    /**
+     * Unsets clipboard provider if it's the current one.
+     *
+     * Data handed over to the provider which it hasn't provided yet
+     * are passed to a new provider process.
+     */
+    void unsetProvider(ScriptableProxy *provider);
+
 private:
     std::unique_ptr<ClipboardManagerPrivate> d;
 };
@@ -19,12 +19,16 @@
 
 #include "clipboardmonitor.h"
 
+#include "app/clipboardsnapshot.h"
+
 #include "common/action.h"
 #include "common/appconfig.h"
 #include "common/common.h"
 #include "common/log.h"
+#include "common/mimeatoms.h"
 #include "common/mimetypes.h"
 #include "common/textdata.h"
+#include "common/trace.h"
 #include "item/serialize.h"
 #include "platform/platformclipboard.h"
 
@@ -35,19 +39,20 @@ namespace {
 bool hasSameData(const QVariantMap &data, const QVariantMap &lastData)
 {
     for (auto it = lastData.constBegin(); it != lastData.constEnd(); ++it) {
-        const auto &format = it.key();
-        if ( !format.startsWith(COPYQ_MIME_PREFIX)
-             && !data.contains(format) )
+        if ( isUserMimeAtom(mimeAtom(it.key()))
+             && !data.contains(it.key()) )
         {
             return false;
         }
     }
 
     for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        const auto &format = it.key();
-        if ( !format.startsWith(COPYQ_MIME_PREFIX)
-             && !data[format].toByteArray().isEmpty()
-             && data[format] != lastData.value(format) )
+        if ( !isUserMimeAtom(mimeAtom(it.key())) )
+            continue;
+
+        const QByteArray bytes = it.value().toByteArray();
+        if ( !bytes.isEmpty()
+             && bytes != lastData.value(it.key()).toByteArray() )
         {
             return false;
         }
@@ -88,6 +93,16 @@ ClipboardMonitor::ClipboardMonitor(const QStringList &formats)
 
 void ClipboardMonitor::onClipboardChanged(ClipboardMode mode)
 {
+    // Platform clipboard can already trace the change.
+    const bool hasTraceEventId = !currentTraceEventId().isEmpty();
+    TraceEventScope traceEventScope(
+        !hasTraceEventId && isTracingEnabled() ? createTraceEventId() : QByteArray() );
+    COPYQ_TRACE("ClipboardMonitor::onClipboardChanged");
+
+    // Stamp data before reading them so that server can drop the report
+    // if the clipboard changes again in the meantime.
+    const qint64 sequence = clipboardChangeSequence();
+
     QVariantMap data = m_clipboard->data(mode, m_formats);
     auto clipboardData = mode == ClipboardMode::Clipboard
             ? &m_clipboardData : &m_selectionData;
@@ -100,6 +115,13 @@ void ClipboardMonitor::onClipboardChanged(ClipboardMode mode)
 
     *clipboardData = data;
 
+    // Correlate trace spans of the clipboard change in other processes.
+    const QByteArray traceEventId = currentTraceEventId();
+    if ( !traceEventId.isEmpty() )
+        data.insert(mimeTraceEventId, traceEventId);
+
+    data.insert( mimeClipboardSequence, QByteArray::number(sequence) );
+
     COPYQ_LOG( QString("%1 changed, owner is \"%2\"")
                .arg(mode == ClipboardMode::Clipboard ? "Clipboard" : "Selection",
                     getTextData(data, mimeOwner)) );
@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clipboardsnapshot.h"
+
+#include "common/common.h"
+#include "common/log.h"
+#include "common/mimetypes.h"
+
+#include <QClipboard>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QMimeData>
+
+ClipboardSnapshot::ClipboardSnapshot(QObject *parent)
+    : QObject(parent)
+{
+    connect( QGuiApplication::clipboard(), &QClipboard::changed, this,
+             [this](QClipboard::Mode mode) {
+                 if (mode == QClipboard::Clipboard)
+                     invalidate(ClipboardMode::Clipboard);
+                 else if (mode == QClipboard::Selection)
+                     invalidate(ClipboardMode::Selection);
+             } );
+}
+
+QByteArray ClipboardSnapshot::data(const QString &format, ClipboardMode mode)
+{
+    auto &snapshot = this->snapshot(mode);
+    const auto it = snapshot.data.constFind(format);
+    if ( it != snapshot.data.constEnd() )
+        return it.value().toByteArray();
+
+    const QMimeData *mimeData = clipboardData(mode);
+    if (!mimeData)
+        return QByteArray();
+
+    COPYQ_LOG_VERBOSE( QString("Fetching clipboard format: %1").arg(format) );
+    const auto bytes = cloneData(*mimeData, QStringList(format)).value(format).toByteArray();
+    snapshot.data.insert(format, bytes);
+    return bytes;
+}
+
+QStringList ClipboardSnapshot::formats(ClipboardMode mode)
+{
+    auto &snapshot = this->snapshot(mode);
+    if (!snapshot.hasFormats) {
+        const QMimeData *mimeData = clipboardData(mode);
+        if (!mimeData)
+            return QStringList();
+
+        snapshot.formats = mimeData->formats();
+        snapshot.hasFormats = true;
+    }
+
+    return snapshot.formats;
+}
+
+bool ClipboardSnapshot::hasFormat(const QString &format, ClipboardMode mode)
+{
+    // Non-empty data can be only in available format.
+    const auto &data = snapshot(mode).data;
+    const auto it = data.constFind(format);
+    if ( it != data.constEnd() && !it.value().toByteArray().isEmpty() )
+        return true;
+
+    return formats(mode).contains(format);
+}
+
+void ClipboardSnapshot::setData(const QVariantMap &data, ClipboardMode mode)
+{
+    auto &snapshot = this->snapshot(mode);
+
+    // Drop data read before the last known clipboard change.
+    const qint64 sequence = data.value(mimeClipboardSequence).toLongLong();
+    if (sequence <= snapshot.sequence) {
+        COPYQ_LOG( QString("Ignoring stale %1 snapshot")
+                   .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection") );
+        return;
+    }
+
+    snapshot = Snapshot();
+    snapshot.sequence = sequence;
+
+    // Omit internal formats added by monitor (owner, window title etc.).
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        if ( !it.key().startsWith(COPYQ_MIME_PREFIX) )
+            snapshot.data.insert( it.key(), it.value() );
+    }
+}
+
+void ClipboardSnapshot::invalidate(ClipboardMode mode)
+{
+    auto &snapshot = this->snapshot(mode);
+    snapshot = Snapshot();
+    snapshot.sequence = clipboardChangeSequence();
+}
+
+ClipboardSnapshot::Snapshot &ClipboardSnapshot::snapshot(ClipboardMode mode)
+{
+    return mode == ClipboardMode::Clipboard ? m_clipboard : m_selection;
+}
+
+qint64 clipboardChangeSequence()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer.msecsSinceReference();
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLIPBOARDSNAPSHOT_H
+#define CLIPBOARDSNAPSHOT_H
+
+#include "common/clipboardmode.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * Last known clipboard and selection data for scripts.
+ *
+ * Asking clipboard owner for data can be slow (e.g. on X11 each request
+ * is a synchronous conversion with the owner), so data are reused
+ * until the clipboard changes.
+ *
+ * Data are initially set from clipboard monitor; missing formats
+ * are fetched from clipboard only once.
+ *
+ * Each snapshot is stamped with clipboard change sequence so that
+ * a delayed report from monitor cannot replace newer data.
+ */
+class ClipboardSnapshot final : public QObject
+{
+public:
+    explicit ClipboardSnapshot(QObject *parent = nullptr);
+
+    /// Returns data for format (fetches it from clipboard if not available yet).
+    QByteArray data(const QString &format, ClipboardMode mode);
+
+    /// Returns available formats.
+    QStringList formats(ClipboardMode mode);
+
+    bool hasFormat(const QString &format, ClipboardMode mode);
+
+    /**
+     * Replaces snapshot with new data from clipboard monitor.
+     *
+     * Data are ignored if the clipboard changed after monitor read them.
+     */
+    void setData(const QVariantMap &data, ClipboardMode mode);
+
+    void invalidate(ClipboardMode mode);
+
+private:
+    struct Snapshot {
+        QVariantMap data;
+        QStringList formats;
+        bool hasFormats = false;
+        qint64 sequence = 0;
+    };
+
+    Snapshot &snapshot(ClipboardMode mode);
+
+    Snapshot m_clipboard;
+    Snapshot m_selection;
+};
+
+/**
+ * Returns clipboard change sequence number for current time.
+ *
+ * The number is based on monotonic clock so it can be compared
+ * between processes.
+ */
+qint64 clipboardChangeSequence();
+
+#endif // CLIPBOARDSNAPSHOT_H
@@ -21,9 +21,11 @@
 
 #include "common/common.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
 #include "common/processsignals.h"
 #include "common/timer.h"
+#include "common/trace.h"
 #include "item/serialize.h"
 
 #include <QCoreApplication>
@@ -44,6 +46,10 @@ void startProcess(QProcess *process, const QStringList &args, QIODevice::OpenMod
     if (executable == "copyq")
         executable = QCoreApplication::applicationFilePath();
 
+    static auto &processesStarted = metricCounter(
+        "copyq_processes_started_total", "Number of started processes.");
+    processesStarted.add();
+
     process->start(executable, args.mid(1), mode);
 }
 
@@ -223,13 +229,15 @@ void Action::setInputWithFormat(const QVariantMap &data, const QString &inputFor
         m_input = serializeData(data);
         m_inputFormats = data.keys();
     } else {
-        m_input = data.value(inputFormat).toByteArray();
+        m_input = detachedMappedData( data.value(inputFormat).toByteArray() );
         m_inputFormats = QStringList(inputFormat);
     }
 }
 
 void Action::start()
 {
+    COPYQ_TRACE("Action::start");
+
     closeSubCommands();
 
     if ( m_currentLine + 1 >= m_cmds.size() ) {
@@ -329,7 +337,8 @@ bool Action::isRunning() const
 
 void Action::setData(const QVariantMap &data)
 {
-    m_data = data;
+    // Action can outlive tab with the item.
+    m_data = detachedMappedData(data);
 }
 
 const QVariantMap &Action::data() const
@@ -8,6 +8,30 @@ enum class ActionState {
     Error,
 };
 
+/**
+ * Scheduling class of actions (in order of priority).
+ *
+ * Actions of each class (except Immediate) are queued
+ * if too many actions of the class are already running.
+ */
+enum class ActionPriority {
+    /// Commands triggered by user.
+    Interactive,
+    /// Display commands.
+    Automatic,
+    /**
+     * Internal scripts without immediate visible effect (window title and
+     * notification updates); identical pending scripts are merged.
+     */
+    Background,
+    /**
+     * Internal actions which must start right away: long-running ones
+     * (clipboard monitor, callbacks), clipboard change handlers
+     * and menu command filters.
+     */
+    Immediate,
+};
+
 namespace ActionHandlerColumn {
 enum {
     id,
@@ -20,6 +44,18 @@ enum {
 };
 }
 
+namespace ActionStatsColumn {
+enum {
+    name,
+    count,
+    failures,
+    total,
+    average,
+    percentile95,
+    columnCount
+};
+}
+
 namespace ActionHandlerRole {
 enum {
     sort,
@@ -0,0 +1,179 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "actionstatsmodel.h"
+
+#include "common/actionhandlerenums.h"
+
+#include <algorithm>
+
+namespace {
+
+/// Maximum number of commands with statistics.
+constexpr int maxCommandCount = 200;
+
+/// Number of recent run times used to compute percentiles.
+constexpr size_t recentRunCount = 100;
+
+qint64 percentile95(std::vector<qint64> values)
+{
+    if ( values.empty() )
+        return 0;
+
+    const auto n = (values.size() * 95 + 99) / 100 - 1;
+    std::nth_element( values.begin(), values.begin() + n, values.end() );
+    return values[n];
+}
+
+} // namespace
+
+ActionStatsModel::ActionStatsModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void ActionStatsModel::addAction(const QString &name, qint64 durationMsec, bool failed)
+{
+    int row = m_rows.value(name, -1);
+    if (row == -1) {
+        removeOldestCommand();
+
+        row = rowCount();
+        beginInsertRows(QModelIndex(), row, row);
+        CommandStats stats;
+        stats.name = name;
+        m_stats.push_back(stats);
+        m_rows.insert(name, row);
+        endInsertRows();
+    }
+
+    CommandStats &stats = m_stats[static_cast<size_t>(row)];
+    ++stats.count;
+    if (failed)
+        ++stats.failures;
+    stats.totalMsec += durationMsec;
+    stats.lastUpdate = ++m_lastUpdate;
+
+    if ( stats.recentMsec.size() < recentRunCount )
+        stats.recentMsec.push_back(durationMsec);
+    else
+        stats.recentMsec[stats.nextRecent] = durationMsec;
+    stats.nextRecent = (stats.nextRecent + 1) % recentRunCount;
+    stats.percentile95Msec = percentile95(stats.recentMsec);
+
+    emit dataChanged( index(row, ActionStatsColumn::count), index(row, ActionStatsColumn::columnCount - 1) );
+}
+
+QVariant ActionStatsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        switch (section) {
+        case ActionStatsColumn::name:
+            return "Name";
+        case ActionStatsColumn::count:
+            return "Runs";
+        case ActionStatsColumn::failures:
+            return "Failures";
+        case ActionStatsColumn::total:
+            return "Total (ms)";
+        case ActionStatsColumn::average:
+            return "Average (ms)";
+        case ActionStatsColumn::percentile95:
+            return "95th Percentile (ms)";
+        }
+    }
+
+    return QVariant();
+}
+
+int ActionStatsModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return static_cast<int>( m_stats.size() );
+}
+
+int ActionStatsModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return ActionStatsColumn::columnCount;
+}
+
+QVariant ActionStatsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const CommandStats &stats = m_stats[static_cast<size_t>(index.row())];
+
+    if (role == Qt::DisplayRole || role == Qt::EditRole)
+        return value(stats, index.column());
+
+    if (role == Qt::ToolTipRole && index.column() == ActionStatsColumn::name)
+        return stats.name;
+
+    if (role == Qt::UserRole + ActionHandlerRole::sort)
+        return value(stats, index.column());
+
+    return QVariant();
+}
+
+QVariant ActionStatsModel::value(const CommandStats &stats, int column)
+{
+    switch (column) {
+    case ActionStatsColumn::name:
+        return stats.name;
+    case ActionStatsColumn::count:
+        return stats.count;
+    case ActionStatsColumn::failures:
+        return stats.failures;
+    case ActionStatsColumn::total:
+        return stats.totalMsec;
+    case ActionStatsColumn::average:
+        return stats.count > 0 ? stats.totalMsec / stats.count : 0;
+    case ActionStatsColumn::percentile95:
+        return stats.percentile95Msec;
+    }
+
+    return QVariant();
+}
+
+void ActionStatsModel::removeOldestCommand()
+{
+    if ( rowCount() < maxCommandCount )
+        return;
+
+    const auto it = std::min_element(
+        m_stats.begin(), m_stats.end(),
+        [](const CommandStats &lhs, const CommandStats &rhs) {
+            return lhs.lastUpdate < rhs.lastUpdate;
+        } );
+
+    const int row = static_cast<int>( std::distance(m_stats.begin(), it) );
+    beginRemoveRows(QModelIndex(), row, row);
+    m_stats.erase(it);
+    endRemoveRows();
+
+    m_rows.clear();
+    for (size_t i = 0; i < m_stats.size(); ++i)
+        m_rows.insert( m_stats[i].name, static_cast<int>(i) );
+}
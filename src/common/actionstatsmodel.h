@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ACTIONSTATSMODEL_H
+#define ACTIONSTATSMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+
+#include <vector>
+
+/**
+ * Aggregated run times of commands for process manager.
+ *
+ * Keeps statistics for a limited number of most recently finished commands.
+ */
+class ActionStatsModel final : public QAbstractTableModel
+{
+public:
+    explicit ActionStatsModel(QObject *parent = nullptr);
+
+    /// Adds finished run of a command.
+    void addAction(const QString &name, qint64 durationMsec, bool failed);
+
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    struct CommandStats {
+        QString name;
+        qint64 count = 0;
+        qint64 failures = 0;
+        qint64 totalMsec = 0;
+        qint64 percentile95Msec = 0;
+        qint64 lastUpdate = 0;
+        /// Most recent run times (circular buffer).
+        std::vector<qint64> recentMsec;
+        size_t nextRecent = 0;
+    };
+
+    static QVariant value(const CommandStats &stats, int column);
+
+    /// Removes least recently updated command if the model is full.
+    void removeOldestCommand();
+
+    std::vector<CommandStats> m_stats;
+    QHash<QString, int> m_rows;
+    qint64 m_lastUpdate = 0;
+};
+
+#endif // ACTIONSTATSMODEL_H
@@ -24,10 +24,15 @@
 
 #include <QColor>
 
+#include <algorithm>
+
 namespace {
 
 constexpr auto dateTimeFormat = "yyyy-MM-dd HH:mm:ss.zzz";
 
+/// Maximum number of actions kept in the model (running actions are never removed).
+constexpr int maxActionCount = 1000;
+
 QString actionStateToString(ActionState state)
 {
     switch (state) {
@@ -57,22 +62,22 @@ ActionTableModel::ActionTableModel(QObject *parent)
 {
 }
 
-void ActionTableModel::actionAboutToStart(Action *action)
+int ActionTableModel::actionAboutToStart(Action *action)
 {
     ActionData actionData;
-    actionData.name = action->name();
-    if ( actionData.name.isEmpty() )
-        actionData.name = action->commandLine();
+    actionData.id = ++m_lastActionId;
+    actionData.name = actionName(*action);
     actionData.finished = -1;
-
-    beginInsertRows(QModelIndex(), actionCount(), actionCount());
-    m_actions.push_back(actionData);
-    endInsertRows();
+    appendAction(actionData);
+    return actionData.id;
 }
 
 void ActionTableModel::actionStarted(Action *action)
 {
-    const int row = action->id();
+    const int row = actionRow( action->id() );
+    if (row == -1)
+        return;
+
     actionData(row).started = QDateTime::currentDateTime();
     for (const int column : { ActionHandlerColumn::started, ActionHandlerColumn::status }) {
         const auto index = this->index(row, column);
@@ -82,7 +87,10 @@ void ActionTableModel::actionStarted(Action *action)
 
 void ActionTableModel::actionFailed(Action *action, const QString &error)
 {
-    const int row = action->id();
+    const int row = actionRow( action->id() );
+    if (row == -1)
+        return;
+
     actionData(row).error = error;
     for (const int column : { ActionHandlerColumn::error, ActionHandlerColumn::status }) {
         const auto index = this->index(row, column);
@@ -90,27 +98,38 @@ void ActionTableModel::actionFailed(Action *action, const QString &error)
     }
 }
 
-void ActionTableModel::actionFinished(Action *action)
+qint64 ActionTableModel::actionFinished(Action *action)
 {
-    const int row = action->id();
+    const int row = actionRow( action->id() );
+    if (row == -1)
+        return 0;
+
     ActionData &data = actionData(row);
-    data.finished = data.started.msecsTo(QDateTime::currentDateTime());
+    data.finished = data.started.isValid()
+            ? data.started.msecsTo(QDateTime::currentDateTime())
+            : 0;
     for (const int column : { ActionHandlerColumn::finished, ActionHandlerColumn::status }) {
         const auto index = this->index(row, column);
         emit dataChanged(index, index);
     }
+
+    return data.finished;
 }
 
 void ActionTableModel::actionFinished(const QString &name)
 {
     ActionData actionData;
+    actionData.id = ++m_lastActionId;
     actionData.name = name;
     actionData.started = QDateTime::currentDateTime();
     actionData.finished = 0;
+    appendAction(actionData);
+}
 
-    beginInsertRows(QModelIndex(), actionCount(), actionCount());
-    m_actions.push_back(actionData);
-    endInsertRows();
+QString ActionTableModel::actionName(const Action &action)
+{
+    const auto name = action.name();
+    return name.isEmpty() ? action.commandLine() : name;
 }
 
 QVariant ActionTableModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -162,7 +181,7 @@ QVariant ActionTableModel::data(const QModelIndex &index, int role) const
         const ActionData &data = actionData(row);
         switch (column) {
         case ActionHandlerColumn::id:
-            return row;
+            return data.id;
         case ActionHandlerColumn::name:
             return data.name;
         case ActionHandlerColumn::status:
@@ -202,7 +221,7 @@ QVariant ActionTableModel::data(const QModelIndex &index, int role) const
             const ActionData &data = actionData(row);
             switch (column) {
             case ActionHandlerColumn::id:
-                return row;
+                return data.id;
             case ActionHandlerColumn::name:
                 return data.name;
             case ActionHandlerColumn::status:
@@ -234,3 +253,37 @@ ActionState ActionTableModel::actionState(const ActionTableModel::ActionData &da
         return ActionState::Running;
     return ActionState::Starting;
 }
+
+int ActionTableModel::actionRow(int id) const
+{
+    // Actions are ordered by ID.
+    const auto it = std::lower_bound(
+        m_actions.begin(), m_actions.end(), id,
+        [](const ActionData &data, int id) { return data.id < id; } );
+
+    if ( it == m_actions.end() || it->id != id )
+        return -1;
+
+    return static_cast<int>( std::distance(m_actions.begin(), it) );
+}
+
+void ActionTableModel::appendAction(const ActionData &data)
+{
+    // Remove oldest finished action if the model is full.
+    if ( actionCount() >= maxActionCount ) {
+        const auto it = std::find_if(
+            m_actions.begin(), m_actions.end(),
+            [](const ActionData &data) { return data.finished != -1; } );
+
+        if ( it != m_actions.end() ) {
+            const int row = static_cast<int>( std::distance(m_actions.begin(), it) );
+            beginRemoveRows(QModelIndex(), row, row);
+            m_actions.erase(it);
+            endRemoveRows();
+        }
+    }
+
+    beginInsertRows(QModelIndex(), actionCount(), actionCount());
+    m_actions.push_back(data);
+    endInsertRows();
+}
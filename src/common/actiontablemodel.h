@@ -23,21 +23,33 @@
 #include <QAbstractTableModel>
 #include <QDateTime>
 
+#include <deque>
+
 class Action;
 
 enum class ActionState;
 
+/**
+ * Recent actions for process manager.
+ *
+ * Only a limited number of finished actions is kept (oldest are removed first).
+ */
 class ActionTableModel : public QAbstractTableModel
 {
 public:
     explicit ActionTableModel(QObject *parent = nullptr);
 
-    void actionAboutToStart(Action *action);
+    /// Adds new action and returns its unique ID.
+    int actionAboutToStart(Action *action);
     void actionStarted(Action *action);
     void actionFailed(Action *action, const QString &error);
-    void actionFinished(Action *action);
+    /// Marks action as finished and returns its run time in milliseconds.
+    qint64 actionFinished(Action *action);
     void actionFinished(const QString &name);
 
+    /// Returns action name shown in the process manager.
+    static QString actionName(const Action &action);
+
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
@@ -47,6 +59,7 @@ public:
 
 private:
     struct ActionData {
+        int id;
         QString name;
         QDateTime started;
         qint64 finished;
@@ -57,9 +70,15 @@ private:
 
     ActionData &actionData(int row) { return m_actions[row]; }
     const ActionData &actionData(int row) const { return m_actions[row]; }
-    int actionCount() const { return m_actions.size(); }
+    int actionCount() const { return static_cast<int>(m_actions.size()); }
+
+    /// Returns row for action ID or -1 if it was already removed.
+    int actionRow(int id) const;
+
+    void appendAction(const ActionData &data);
 
-    std::vector<ActionData> m_actions;
+    std::deque<ActionData> m_actions;
+    int m_lastActionId = -1;
 };
 
 #endif // ACTIONTABLEMODEL_H
@@ -59,6 +59,11 @@ struct expire_tab : Config<bool> {
     static QString name() { return "expire_tab"; }
 };
 
+struct memory_budget : Config<int> {
+    static QString name() { return "memory_budget"; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
 struct editor : Config<QString> {
     static QString name() { return "editor"; }
     static Value defaultValue();
@@ -249,6 +254,24 @@ struct command_history_size : Config<int> {
     static Value defaultValue() { return 100; }
 };
 
+/**
+ * Time in milliseconds to reuse results of menu command filters (0 to disable).
+ *
+ * Disabled by default since filters can depend on more than item data.
+ */
+struct menu_filter_cache_ttl : Config<int> {
+    static QString name() { return "menu_filter_cache_ttl"; }
+    static Value defaultValue() { return 0; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
+/// Maximum number of commands running at the same time (0 to derive from number of CPU cores).
+struct max_running_commands : Config<int> {
+    static QString name() { return "max_running_commands"; }
+    static Value defaultValue() { return 0; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
 struct check_selection : Config<bool> {
     static QString name() { return "check_selection"; }
 };
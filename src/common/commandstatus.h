@@ -40,6 +40,9 @@ enum CommandStatus {
     CommandStop = 10,
 
     CommandInputDialogFinished = 11,
+
+    /** New data for clipboard provider */
+    CommandProvideClipboard = 12,
 };
 
 #endif // COMMANDSTATUS_H
@@ -21,12 +21,15 @@
 
 #include "common/display.h"
 #include "common/log.h"
+#include "common/mimeatoms.h"
 #include "common/mimetypes.h"
 #include "common/textdata.h"
+#include "item/serialize.h"
 
 #include <QAction>
 #include <QApplication>
 #include <QBuffer>
+#include <QCache>
 #include <QClipboard>
 #include <QDropEvent>
 #include <QElapsedTimer>
@@ -35,6 +38,8 @@
 #include <QKeyEvent>
 #include <QMimeData>
 #include <QMovie>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QObject>
 #include <QPoint>
 #include <QProcess>
@@ -50,6 +55,23 @@ namespace {
 
 const int maxElidedTextLineLength = 512;
 
+/// Maximum line length decoded for labels (lines are elided later).
+const int maxPreviewLineLength = 16 * maxElidedTextLineLength;
+
+/// Maximum number of labels in label cache.
+const int labelCacheSize = 512;
+
+/// Maximum size of text prefix hashed to verify cached label (labels show only few lines).
+const int labelVerifierTextSize = 4 * 1024;
+
+QMutex labelCacheMutex;
+
+QCache<QByteArray, QString> &labelCache()
+{
+    static QCache<QByteArray, QString> cache(labelCacheSize);
+    return cache;
+}
+
 // Avoids accessing old clipboard/drag'n'drop data.
 class ClipboardDataGuard {
 public:
@@ -102,7 +124,7 @@ public:
             return bytes;
         }
 
-        if ( format.startsWith("text/") )
+        if ( isTextMimeAtom(mimeAtom(format)) )
             return dataToText( data(format), format ).toUtf8();
 
         return data(format);
@@ -210,14 +232,14 @@ QTextCodec *codecForText(const QByteArray &bytes)
     return QTextCodec::codecForName("utf-8");
 }
 
-bool findFormatsWithPrefix(bool hasPrefix, const QString &prefix, const QVariantMap &data)
+bool hasFormatWithFlag(MimeAtom flag, const QVariantMap &data)
 {
     for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        if ( it.key().startsWith(prefix) == hasPrefix )
-            return hasPrefix;
+        if ( (mimeAtom(it.key()) & flag) != 0 )
+            return true;
     }
 
-    return !hasPrefix;
+    return false;
 }
 
 } // namespace
@@ -266,11 +288,10 @@ QVariantMap cloneData(const QMimeData &rawData, QStringList formats)
      so these doesn't have to be ignored.
      */
     if ( formats.contains(mimeText) && data.hasFormat(mimeText) ) {
-        const QString mimeImagePrefix = "image/";
         const auto first = std::remove_if(
                     std::begin(formats), std::end(formats),
-                    [&mimeImagePrefix](const QString &format) {
-                        return format.startsWith(mimeImagePrefix)
+                    [](const QString &format) {
+                        return isImageMimeAtom(mimeAtom(format))
                             && !format.contains("xml")
                             && !format.contains("svg");
                     });
@@ -327,8 +348,9 @@ QMimeData* createMimeData(const QVariantMap &data)
 
     std::unique_ptr<QMimeData> newClipboardData(new QMimeData);
 
+    // Clipboard data can outlive tab with the item.
     for ( const auto &format : copyFormats )
-        newClipboardData->setData( format, data[format].toByteArray() );
+        newClipboardData->setData( format, detachedMappedData(data[format].toByteArray()) );
 
     if ( !copyFormats.contains(mimeOwner) )
         newClipboardData->setData( mimeOwner, makeClipboardOwnerData() );
@@ -412,7 +434,7 @@ QString elideText(const QString &text, const QFont &font, const QString &format,
 }
 
 QString textLabelForData(const QVariantMap &data, const QFont &font, const QString &format,
-                         bool escapeAmpersands, int maxWidthPixels, int maxLines)
+                         bool escapeAmpersands, int maxWidthPixels, int maxLines, int lineCount)
 {
     QString label;
 
@@ -421,8 +443,10 @@ QString textLabelForData(const QVariantMap &data, const QFont &font, const QStri
     if ( data.contains(mimeHidden) ) {
         label = QObject::tr("<HIDDEN>", "Label for hidden/secret clipboard content");
     } else if ( data.contains(mimeText) || data.contains(mimeUriList) ) {
-        const QString text = getTextData(data);
-        const int n = text.count(QChar('\n')) + 1;
+        // Avoid decoding whole text just to show few lines.
+        const QByteArray bytes = data.value( data.contains(mimeText) ? mimeText : mimeUriList ).toByteArray();
+        const int n = lineCount >= 0 ? lineCount : bytes.count('\n') + 1;
+        const QString text = getTextPreview(bytes, maxLines, maxPreviewLineLength);
 
         if (n > 1)
             label = QObject::tr("%1 (%n lines)", "Label for multi-line text in clipboard", n);
@@ -434,11 +458,11 @@ QString textLabelForData(const QVariantMap &data, const QFont &font, const QStri
 
         const QString textWithNotes = notes.isEmpty() ? text : notes + ": " + text;
         return elideText(textWithNotes, font, label, escapeAmpersands, maxWidthPixels, maxLines);
-    } else if ( findFormatsWithPrefix(true, "image/", data) ) {
+    } else if ( hasFormatWithFlag(MimeAtomImage, data) ) {
         label = QObject::tr("<IMAGE>", "Label for image in clipboard");
     } else if ( data.contains(mimeItems) ) {
         label = QObject::tr("<ITEMS>", "Label for copied items in clipboard");
-    } else if ( findFormatsWithPrefix(false, COPYQ_MIME_PREFIX, data) ) {
+    } else if ( !hasFormatWithFlag(MimeAtomUser, data) ) {
         label = QObject::tr("<EMPTY>", "Label for empty clipboard");
     } else {
         label = QObject::tr("<DATA>", "Label for data in clipboard");
@@ -460,6 +484,55 @@ QString textLabelForData(const QVariantMap &data)
     return textLabelForData(data, QFont(), QString());
 }
 
+QByteArray labelDataVerifier(const QVariantMap &data)
+{
+    qint64 size = 0;
+    for (const auto &value : data)
+        size += value.toByteArray().size();
+
+    const QByteArray text = data.value( data.contains(mimeText) ? mimeText : mimeUriList ).toByteArray();
+    const QByteArray textPrefix = QByteArray::fromRawData(
+                text.constData(), qMin(text.size(), labelVerifierTextSize) );
+
+    return QByteArray::number(data.size())
+            + ':' + QByteArray::number(size)
+            + ':' + QByteArray::number( qHash(textPrefix) );
+}
+
+QString cachedLabel(const QByteArray &key, const std::function<QString()> &createLabel)
+{
+    {
+        QMutexLocker lock(&labelCacheMutex);
+        const QString *label = labelCache().object(key);
+        if (label)
+            return *label;
+    }
+
+    const QString label = createLabel();
+
+    QMutexLocker lock(&labelCacheMutex);
+    labelCache().insert( key, new QString(label) );
+    return label;
+}
+
+QString cachedTextLabelForData(uint dataHash, const QVariantMap &data, const QFont &font,
+                               const QString &format, bool escapeAmpersands,
+                               int maxWidthPixels, int maxLines, int lineCount)
+{
+    const QByteArray key = "label:" + QByteArray::number(dataHash)
+            + ':' + labelDataVerifier(data)
+            + ':' + QByteArray::number(lineCount)
+            + ':' + font.key().toUtf8()
+            + ':' + QByteArray::number(maxWidthPixels)
+            + ':' + QByteArray::number(maxLines)
+            + ':' + (escapeAmpersands ? '&' : '-')
+            + format.toUtf8();
+
+    return cachedLabel(key, [&]() {
+        return textLabelForData(data, font, format, escapeAmpersands, maxWidthPixels, maxLines, lineCount);
+    });
+}
+
 void renameToUnique(QString *name, const QStringList &names)
 {
     const QString baseName = *name;
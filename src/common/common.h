@@ -25,6 +25,8 @@
 #include <QtGlobal> // Q_WS_*
 #include <QVariantMap>
 
+#include <functional>
+
 class QAction;
 class QByteArray;
 class QClipboard;
@@ -93,15 +95,45 @@ QString elideText(const QString &text, const QFont &font,
  *          (unescaped ampersand is used for shortcut key in labels)
  * @param maxWidthPixels  maximum width in pixels
  * @param maxLines  maximum number of lines
+ * @param lineCount  number of lines in text if already known
+ *          (see contentType::textLineCount), otherwise -1
  *
  * @return result text
  */
 QString textLabelForData(const QVariantMap &data, const QFont &font,
                          const QString &format, bool escapeAmpersands = false,
-                         int maxWidthPixels = -1, int maxLines = 1);
+                         int maxWidthPixels = -1, int maxLines = 1, int lineCount = -1);
 
 QString textLabelForData(const QVariantMap &data);
 
+/**
+ * Return cheap summary of data used to verify cached labels.
+ *
+ * Contains number of formats, size of all data and hash of beginning of text
+ * so a collision of data hash does not return label for other data.
+ */
+QByteArray labelDataVerifier(const QVariantMap &data);
+
+/**
+ * Return label from cache or create it using @a createLabel.
+ *
+ * Labels are kept in a bounded LRU cache so labels for the same items
+ * shown in tray menu, window title and notifications are not recomputed.
+ *
+ * @param key  unique key for the label, should contain hash of the data,
+ *             labelDataVerifier() and all other arguments affecting the label (font, size)
+ */
+QString cachedLabel(const QByteArray &key, const std::function<QString()> &createLabel);
+
+/**
+ * Same as textLabelForData() but the result is cached (see cachedLabel()).
+ *
+ * @param dataHash  item hash from model (contentType::hash) or hash(data)
+ */
+QString cachedTextLabelForData(uint dataHash, const QVariantMap &data, const QFont &font,
+                               const QString &format, bool escapeAmpersands = false,
+                               int maxWidthPixels = -1, int maxLines = 1, int lineCount = -1);
+
 void renameToUnique(QString *name, const QStringList &names);
 
 QString dataToText(const QByteArray &bytes, const QString &mime = QString());
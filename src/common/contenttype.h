@@ -59,7 +59,13 @@ enum {
     color,
 
     /// If true, hide content of item (not notes, tags etc.).
-    isHidden
+    isHidden,
+
+    /// Length of text (computed once per item without decoding the text).
+    textLength,
+
+    /// Number of lines in text.
+    textLineCount
 };
 
 }
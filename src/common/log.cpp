@@ -23,18 +23,27 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QMutex>
 #include <QString>
 #include <QSystemSemaphore>
 #include <QThread>
 #include <QtGlobal>
 #include <QVariant>
+#include <QWaitCondition>
 
 #include <QStandardPaths>
 
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
 #include <cmath>
 #include <memory>
 
+#ifdef Q_OS_UNIX
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
 #ifdef Q_OS_MAC
 #   define THREAD_LOCAL __thread
 #else
@@ -90,7 +99,13 @@ THREAD_LOCAL char currentThreadLabel_[maxThreadLabelSize + 1] = "";
 const int logFileSize = 512 * 1024;
 const int logFileCount = 10;
 
+/// Maximum number of log messages waiting to be written (must be power of two).
+constexpr size_t logQueueSize = 1024;
+/// Interval for writing pending messages to log file.
+const int logFlushIntervalMs = 200;
+
 const char propertySessionMutex[] = "CopyQ_Session_Mutex";
+const char propertyLogWriter[] = "CopyQ_Log_Writer";
 
 int getLogLevel()
 {
@@ -254,6 +269,300 @@ QByteArray createLogMessage(const QByteArray &text, const LogLevel level)
     return createLogMessage(label, text);
 }
 
+void writeToStderr(const QByteArray &msg)
+{
+    QFile ferr;
+    ferr.open(stderr, QIODevice::WriteOnly);
+    ferr.write(msg);
+}
+
+/**
+ * Appends messages to log file and rotates log files if needed.
+ *
+ * Messages are written to stderr if log file cannot be written.
+ */
+void writeToLogFile(const QString &fileName, const QByteArray &messages)
+{
+    SystemMutexLocker lock(getSessionMutex());
+
+    QFile f(fileName);
+    if ( !f.open(QIODevice::Append) || f.write(messages) != messages.size() ) {
+        writeToStderr(messages);
+        return;
+    }
+
+    const bool rotate = f.size() > logFileSize;
+    f.close();
+
+    if (rotate)
+        rotateLogFiles();
+}
+
+/**
+ * Bounded lock-free queue of log messages.
+ *
+ * Any thread can add messages but only single thread at a time can remove them.
+ */
+class LogMessageQueue final {
+public:
+    LogMessageQueue()
+        : m_enqueuePos(0)
+        , m_dequeuePos(0)
+    {
+        for (size_t i = 0; i < logQueueSize; ++i)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /// Returns false if the queue is full.
+    bool push(const QByteArray &message)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = m_cells[pos % logQueueSize];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == pos) {
+                if ( m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) ) {
+                    cell.message = message;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < pos) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Returns false if the queue is empty.
+    bool pop(QByteArray *message)
+    {
+        const size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell &cell = m_cells[pos % logQueueSize];
+        if ( cell.sequence.load(std::memory_order_acquire) != pos + 1 )
+            return false;
+
+        m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        message->swap(cell.message);
+        cell.message.clear();
+        cell.sequence.store(pos + logQueueSize, std::memory_order_release);
+        return true;
+    }
+
+    size_t pendingCount() const
+    {
+        return m_enqueuePos.load(std::memory_order_relaxed)
+                - m_dequeuePos.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Calls fn(data, size) for each pending message without removing it.
+     *
+     * Does not allocate or lock so it can be used from signal handler.
+     */
+    template <typename Fn>
+    void forEachPending(Fn fn) const
+    {
+        const size_t end = m_enqueuePos.load(std::memory_order_acquire);
+        for (size_t pos = m_dequeuePos.load(std::memory_order_acquire); pos != end; ++pos) {
+            const Cell &cell = m_cells[pos % logQueueSize];
+            if ( cell.sequence.load(std::memory_order_acquire) == pos + 1 )
+                fn( cell.message.constData(), static_cast<size_t>(cell.message.size()) );
+        }
+    }
+
+    LogMessageQueue(const LogMessageQueue &) = delete;
+    LogMessageQueue &operator=(const LogMessageQueue &) = delete;
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        QByteArray message;
+    };
+
+    Cell m_cells[logQueueSize];
+    std::atomic<size_t> m_enqueuePos;
+    std::atomic<size_t> m_dequeuePos;
+};
+
+/**
+ * Writes queued log messages to log file in batches from background thread.
+ *
+ * Logging threads only format and enqueue messages so they don't block on
+ * file access or on the system-wide mutex shared with other processes.
+ */
+class LogWriter final : public QThread {
+public:
+    LogWriter()
+        : m_writeMutex(QMutex::Recursive)
+        , m_stopped(false)
+        , m_crashLogPath(nullptr)
+        , m_batchData(nullptr)
+        , m_batchSize(0)
+    {
+        updateCrashLogPath( ::logFileName() );
+    }
+
+    void addMessage(const QByteArray &message, LogLevel level)
+    {
+        if ( !m_queue.push(message) ) {
+            flush();
+            if ( !m_queue.push(message) ) {
+                QMutexLocker lock(&m_writeMutex);
+                writeToLogFile(::logFileName(), message);
+                return;
+            }
+        }
+
+        // Errors are written immediately in case the application crashes.
+        if ( level <= LogError || m_stopped.load() )
+            flush();
+        else if ( level == LogWarning || m_queue.pendingCount() > logQueueSize / 2 )
+            m_wakeUp.wakeOne();
+    }
+
+    /// Writes all pending messages.
+    void flush()
+    {
+        QMutexLocker lock(&m_writeMutex);
+
+        QByteArray message;
+        while ( m_queue.pop(&message) )
+            m_batch.append(message);
+
+        if ( m_batch.isEmpty() )
+            return;
+
+        // Messages removed from queue are written by flushOnCrash() until they are in log file.
+        m_batchSize.store( static_cast<size_t>(m_batch.size()) );
+        m_batchData.store( m_batch.constData() );
+
+        const QString fileName = ::logFileName();
+        updateCrashLogPath(fileName);
+        writeToLogFile(fileName, m_batch);
+
+        m_batchData.store(nullptr);
+        m_batch.clear();
+    }
+
+    /**
+     * Stops background thread, waits for it to finish and writes pending messages.
+     *
+     * Messages logged later are written immediately.
+     */
+    void stop()
+    {
+        {
+            QMutexLocker lock(&m_wakeMutex);
+            m_stopped.store(true);
+        }
+        m_wakeUp.wakeOne();
+
+        if ( QThread::currentThread() != this )
+            wait();
+
+        flush();
+    }
+
+    /// Writes pending messages using only async-signal-safe functions.
+    void flushOnCrash()
+    {
+#ifdef Q_OS_UNIX
+        const char *path = m_crashLogPath.load();
+        if (path == nullptr)
+            return;
+
+        const int fd = ::open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd == -1)
+            return;
+
+        const auto writeAll = [fd](const char *data, size_t size) {
+            while (size > 0) {
+                const auto written = ::write(fd, data, size);
+                if (written <= 0)
+                    return;
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+        };
+
+        // Batch which is being written can be partially in the log file already.
+        const char *batchData = m_batchData.load();
+        if (batchData != nullptr)
+            writeAll( batchData, m_batchSize.load() );
+
+        m_queue.forEachPending(writeAll);
+
+        ::close(fd);
+#endif
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker lock(&m_wakeMutex);
+        while ( !m_stopped.load() ) {
+            m_wakeUp.wait(&m_wakeMutex, logFlushIntervalMs);
+            lock.unlock();
+            flush();
+            lock.relock();
+        }
+    }
+
+private:
+    /**
+     * Keeps current log file path for flushOnCrash().
+     *
+     * Old paths are intentionally leaked so the signal handler never reads freed memory
+     * (log file path changes at most few times during application start).
+     */
+    void updateCrashLogPath(const QString &fileName)
+    {
+        const QByteArray path = QFile::encodeName(fileName);
+        const char *oldPath = m_crashLogPath.load();
+        if ( oldPath == nullptr || path != oldPath )
+            m_crashLogPath.store( qstrdup(path.constData()) );
+    }
+
+    LogMessageQueue m_queue;
+    QMutex m_writeMutex;
+    QMutex m_wakeMutex;
+    QWaitCondition m_wakeUp;
+    std::atomic<bool> m_stopped;
+    std::atomic<const char*> m_crashLogPath;
+    QByteArray m_batch;
+    std::atomic<const char*> m_batchData;
+    std::atomic<size_t> m_batchSize;
+};
+
+std::atomic<LogWriter*> logWriterInstance(nullptr);
+
+void stopLogWriter()
+{
+    LogWriter *writer = logWriterInstance.load();
+    if (writer)
+        writer->stop();
+}
+
+/**
+ * Returns log writer started by the application.
+ *
+ * Plugins have their own copy of this code but they use the writer
+ * from the application which is passed in a property of application object.
+ */
+LogWriter *logWriter()
+{
+    LogWriter *writer = logWriterInstance.load();
+    if (writer || !qApp)
+        return writer;
+
+    writer = static_cast<LogWriter*>( qApp->property(propertyLogWriter).value<QObject*>() );
+    if (writer)
+        logWriterInstance.store(writer);
+
+    return writer;
+}
+
 } // namespace
 
 QString logFileName()
@@ -271,6 +580,8 @@ QString logFileName()
 
 QString readLogFile(int maxReadSize)
 {
+    flushLog();
+
     SystemMutexLocker lock(getSessionMutex());
 
     QString content;
@@ -289,6 +600,32 @@ void createSessionMutex()
     initSessionMutex(QSystemSemaphore::Create);
 }
 
+SessionMutexLocker::SessionMutexLocker()
+    : m_mutex(getSessionMutex())
+    , m_locked( m_mutex != nullptr && m_mutex->lock() )
+{
+}
+
+SessionMutexLocker::~SessionMutexLocker()
+{
+    if (m_locked)
+        m_mutex->unlock();
+}
+
+void startLogWriter()
+{
+    Q_ASSERT(qApp != nullptr);
+    Q_ASSERT(logWriterInstance.load() == nullptr);
+
+    // The writer is never deleted so messages logged from destructors
+    // of static objects are still written.
+    auto writer = new LogWriter();
+    writer->start(QThread::LowPriority);
+    logWriterInstance.store(writer);
+    qApp->setProperty( propertyLogWriter, QVariant::fromValue<QObject*>(writer) );
+    std::atexit(stopLogWriter);
+}
+
 bool hasLogLevel(LogLevel level)
 {
     static const int currentLogLevel = getLogLevel();
@@ -320,26 +657,32 @@ void log(const QString &text, const LogLevel level)
     if ( !hasLogLevel(level) )
         return;
 
-    SystemMutexLocker lock(getSessionMutex());
-
     const auto msgText = text.toUtf8();
     const auto msg = createLogMessage(msgText, level);
 
-    QFile f( logFileName() );
-    const bool writtenToLogFile = f.open(QIODevice::Append) && f.write(msg);
-    if (writtenToLogFile)
-        f.close();
-
     // Log to file and if needed to stderr.
-    if ( !writtenToLogFile || level <= LogWarning || hasLogLevel(LogDebug) ) {
-        QFile ferr;
-        ferr.open(stderr, QIODevice::WriteOnly);
-        const auto simpleMsg = createSimpleLogMessage(msgText, level);
-        ferr.write(simpleMsg);
-    }
+    if ( level <= LogWarning || hasLogLevel(LogDebug) )
+        writeToStderr( createSimpleLogMessage(msgText, level) );
+
+    LogWriter *writer = logWriter();
+    if (writer)
+        writer->addMessage(msg, level);
+    else
+        writeToLogFile(::logFileName(), msg);
+}
 
-    if ( writtenToLogFile && f.size() > logFileSize )
-        rotateLogFiles();
+void flushLog()
+{
+    LogWriter *writer = logWriter();
+    if (writer)
+        writer->flush();
+}
+
+void flushLogOnCrash()
+{
+    LogWriter *writer = logWriterInstance.load();
+    if (writer)
+        writer->flushOnCrash();
 }
 
 void setCurrentThreadName(const QString &name)
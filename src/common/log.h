@@ -20,8 +20,11 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <memory>
+
 class QByteArray;
 class QString;
+class SystemMutex;
 
 enum LogLevel {
     LogAlways,
@@ -38,6 +41,32 @@ QString readLogFile(int maxReadSize);
 
 void createSessionMutex();
 
+/**
+ * Locks system-wide mutex of current session while in scope.
+ *
+ * Used to access files shared by all processes of the session.
+ */
+class SessionMutexLocker final {
+public:
+    SessionMutexLocker();
+    ~SessionMutexLocker();
+
+    SessionMutexLocker(const SessionMutexLocker &) = delete;
+    SessionMutexLocker &operator=(const SessionMutexLocker &) = delete;
+
+private:
+    std::shared_ptr<SystemMutex> m_mutex;
+    bool m_locked;
+};
+
+/**
+ * Starts writing log messages asynchronously from a background thread.
+ *
+ * Must be called only once by the application (not plugins) after application
+ * object is created. Messages logged earlier are written synchronously.
+ */
+void startLogWriter();
+
 bool hasLogLevel(LogLevel level);
 
 QByteArray logLevelLabel(LogLevel level);
@@ -45,8 +74,24 @@ QByteArray logLevelLabel(LogLevel level);
 #define COPYQ_LOG(msg) do { if ( hasLogLevel(LogDebug) ) log(msg, LogDebug); } while (false)
 #define COPYQ_LOG_VERBOSE(msg) do { if ( hasLogLevel(LogTrace) ) log(msg, LogTrace); } while (false)
 
+/**
+ * Log message.
+ *
+ * Message is written to log file asynchronously unless level is LogError or LogAlways
+ * or log writer has not been started yet.
+ */
 void log(const QString &text, LogLevel level = LogNote);
 
+/// Write pending log messages to log file.
+void flushLog();
+
+/**
+ * Write pending log messages to log file from a fatal signal handler.
+ *
+ * Uses only async-signal-safe functions (no-op on non-Unix systems).
+ */
+void flushLogOnCrash();
+
 void setCurrentThreadName(const QString &name);
 
 QByteArray currentThreadLabel();
@@ -0,0 +1,226 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "metrics.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+
+#include <map>
+
+namespace {
+
+enum class MetricType {
+    Counter,
+    Gauge,
+    Histogram
+};
+
+struct Metric {
+    const char *name;
+    const char *help;
+    MetricType type;
+    QByteArray labels;
+    void *value;
+};
+
+struct MetricKey {
+    QByteArray name;
+    QByteArray labels;
+
+    bool operator<(const MetricKey &other) const
+    {
+        return name < other.name || (name == other.name && labels < other.labels);
+    }
+};
+
+QMutex metricsMutex;
+
+std::map<MetricKey, Metric> &metrics()
+{
+    // Never destroyed so metrics can be updated until the process exits.
+    static auto metrics = new std::map<MetricKey, Metric>();
+    return *metrics;
+}
+
+template <typename T>
+T &metric(const char *name, const char *help, MetricType type, const QByteArray &labels)
+{
+    QMutexLocker lock(&metricsMutex);
+
+    auto &value = metrics()[MetricKey{name, labels}];
+    if (value.value == nullptr)
+        value = Metric{name, help, type, labels, new T()};
+
+    Q_ASSERT(value.type == type);
+    return *static_cast<T*>(value.value);
+}
+
+const char *typeName(MetricType type)
+{
+    switch (type) {
+    case MetricType::Counter: return "counter";
+    case MetricType::Gauge: return "gauge";
+    case MetricType::Histogram: return "histogram";
+    }
+
+    Q_ASSERT(false);
+    return "untyped";
+}
+
+QByteArray secondsText(qint64 us)
+{
+    return QByteArray::number(static_cast<double>(us) / 1e6, 'g', 12);
+}
+
+QByteArray sampleLine(const QByteArray &name, const QByteArray &labels, const QByteArray &value)
+{
+    if ( labels.isEmpty() )
+        return name + " " + value + "\n";
+    return name + "{" + labels + "} " + value + "\n";
+}
+
+QByteArray joinLabels(const QByteArray &labels, const QByteArray &label)
+{
+    return labels.isEmpty() ? label : labels + "," + label;
+}
+
+QByteArray formatHistogram(const char *name, const QByteArray &labels, const MetricHistogram &histogram)
+{
+    const QByteArray bucketName = QByteArray(name) + "_bucket";
+
+    QByteArray result;
+    qint64 cumulativeCount = 0;
+    for (size_t i = 0; i < MetricHistogram::bucketBoundsUs.size(); ++i) {
+        cumulativeCount += histogram.bucketCount(i);
+        const qint64 boundUs = MetricHistogram::bucketBoundsUs[i];
+        const QByteArray le = boundUs == -1 ? "+Inf" : secondsText(boundUs);
+        result.append( sampleLine(
+            bucketName, joinLabels(labels, "le=\"" + le + "\""), QByteArray::number(cumulativeCount)) );
+    }
+
+    result.append( sampleLine(QByteArray(name) + "_sum", labels, secondsText(histogram.sumUs())) );
+    result.append( sampleLine(QByteArray(name) + "_count", labels, QByteArray::number(histogram.count())) );
+    return result;
+}
+
+QByteArray formatHeader(const char *name, const char *type, const char *help)
+{
+    return QByteArray("# HELP ") + name + " " + help + "\n"
+         + "# TYPE " + name + " " + type + "\n";
+}
+
+} // namespace
+
+const std::array<qint64, 10> MetricHistogram::bucketBoundsUs = {{
+    1000, 5000, 10000, 25000, 50000, 100000, 250000, 1000000, 5000000, -1
+}};
+
+MetricHistogram::MetricHistogram()
+    : m_count(0)
+    , m_sumUs(0)
+{
+    for (auto &bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void MetricHistogram::observe(qint64 durationUs)
+{
+    size_t bucket = 0;
+    while ( bucketBoundsUs[bucket] != -1 && durationUs > bucketBoundsUs[bucket] )
+        ++bucket;
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sumUs.fetch_add(durationUs, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+MetricCounter &metricCounter(const char *name, const char *help, const QByteArray &labels)
+{
+    return metric<MetricCounter>(name, help, MetricType::Counter, labels);
+}
+
+MetricGauge &metricGauge(const char *name, const char *help, const QByteArray &labels)
+{
+    return metric<MetricGauge>(name, help, MetricType::Gauge, labels);
+}
+
+MetricHistogram &metricHistogram(const char *name, const char *help, const QByteArray &labels)
+{
+    return metric<MetricHistogram>(name, help, MetricType::Histogram, labels);
+}
+
+QByteArray metricLabel(const char *name, const QString &value)
+{
+    QByteArray escaped;
+    for ( const char c : value.toUtf8() ) {
+        if (c == '\\' || c == '"')
+            escaped.append('\\');
+
+        if (c == '\n')
+            escaped.append("\\n");
+        else
+            escaped.append(c);
+    }
+
+    return QByteArray(name) + "=\"" + escaped + "\"";
+}
+
+QByteArray formatMetric(
+        const char *name, const char *type, const char *help, const QVector<MetricSample> &samples)
+{
+    QByteArray result = formatHeader(name, type, help);
+    for (const auto &sample : samples)
+        result.append( sampleLine(name, sample.labels, QByteArray::number(sample.value)) );
+    return result;
+}
+
+QByteArray metricsSnapshot()
+{
+    QMutexLocker lock(&metricsMutex);
+
+    QByteArray result;
+    QByteArray lastName;
+    for (const auto &keyValue : metrics()) {
+        const auto &metric = keyValue.second;
+
+        if (lastName != keyValue.first.name) {
+            lastName = keyValue.first.name;
+            result.append( formatHeader(metric.name, typeName(metric.type), metric.help) );
+        }
+
+        switch (metric.type) {
+        case MetricType::Counter:
+            result.append( sampleLine(metric.name, metric.labels,
+                QByteArray::number(static_cast<const MetricCounter*>(metric.value)->value())) );
+            break;
+        case MetricType::Gauge:
+            result.append( sampleLine(metric.name, metric.labels,
+                QByteArray::number(static_cast<const MetricGauge*>(metric.value)->value())) );
+            break;
+        case MetricType::Histogram:
+            result.append( formatHistogram(metric.name, metric.labels,
+                *static_cast<const MetricHistogram*>(metric.value)) );
+            break;
+        }
+    }
+
+    return result;
+}
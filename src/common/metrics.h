@@ -0,0 +1,126 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <array>
+#include <atomic>
+
+class QString;
+
+/// Monotonically increasing value.
+class MetricCounter final {
+public:
+    MetricCounter() : m_value(0) {}
+
+    void add(qint64 value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value;
+};
+
+/// Value that can go up and down.
+class MetricGauge final {
+public:
+    MetricGauge() : m_value(0) {}
+
+    void add(qint64 value) { m_value.fetch_add(value, std::memory_order_relaxed); }
+    void set(qint64 value) { m_value.store(value, std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value;
+};
+
+/// Distribution of durations in fixed buckets.
+class MetricHistogram final {
+public:
+    /// Upper bounds of buckets in microseconds (last bucket is +Inf).
+    static const std::array<qint64, 10> bucketBoundsUs;
+
+    MetricHistogram();
+
+    void observe(qint64 durationUs);
+
+    qint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    qint64 sumUs() const { return m_sumUs.load(std::memory_order_relaxed); }
+    qint64 bucketCount(size_t bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<qint64>, 10> m_buckets;
+    std::atomic<qint64> m_count;
+    std::atomic<qint64> m_sumUs;
+};
+
+/// Observes time spent in a scope.
+class MetricTimer final {
+public:
+    explicit MetricTimer(MetricHistogram *histogram)
+        : m_histogram(histogram)
+    {
+        m_timer.start();
+    }
+
+    ~MetricTimer()
+    {
+        m_histogram->observe(m_timer.nsecsElapsed() / 1000);
+    }
+
+    MetricTimer(const MetricTimer &) = delete;
+    MetricTimer &operator=(const MetricTimer &) = delete;
+
+private:
+    MetricHistogram *m_histogram;
+    QElapsedTimer m_timer;
+};
+
+/**
+ * Returns metric from registry of current process (creates the metric if needed).
+ *
+ * Returned objects are never destroyed so hot paths can keep references
+ * (e.g. in a function-local static variable) and update them with atomics.
+ *
+ * The labels argument is in Prometheus format, e.g. `method="tab"`.
+ */
+MetricCounter &metricCounter(const char *name, const char *help, const QByteArray &labels = QByteArray());
+MetricGauge &metricGauge(const char *name, const char *help, const QByteArray &labels = QByteArray());
+MetricHistogram &metricHistogram(const char *name, const char *help, const QByteArray &labels = QByteArray());
+
+/// Returns label in Prometheus format with escaped value, e.g. `tab="&clipboard"`.
+QByteArray metricLabel(const char *name, const QString &value);
+
+struct MetricSample {
+    QByteArray labels;
+    qint64 value;
+};
+
+/// Returns metric samples in Prometheus text exposition format.
+QByteArray formatMetric(
+        const char *name, const char *type, const char *help, const QVector<MetricSample> &samples);
+
+/// Returns all registered metrics in Prometheus text exposition format.
+QByteArray metricsSnapshot();
+
+#endif // METRICS_H
@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mimeatoms.h"
+
+#include "common/mimetypes.h"
+
+#include <QHash>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+#include <QWriteLocker>
+
+namespace {
+
+static_assert( static_cast<MimeAtom>(maxMimeAtomCount) <= mimeAtomIndexMask,
+               "Atom index must fit into index bits" );
+
+struct MimeAtomRegistry {
+    QReadWriteLock lock;
+    QHash<QString, MimeAtom> atoms;
+    QVector<QString> names;
+};
+
+MimeAtom createMimeAtom(const QString &mime, int index)
+{
+    MimeAtom atom = static_cast<MimeAtom>(index);
+    if ( mime.startsWith(COPYQ_MIME_PREFIX) )
+        atom |= MimeAtomInternal;
+    else
+        atom |= MimeAtomUser;
+
+    if ( mime.startsWith("text/") )
+        atom |= MimeAtomText;
+    else if ( mime.startsWith("image/") )
+        atom |= MimeAtomImage;
+
+    return atom;
+}
+
+MimeAtom intern(MimeAtomRegistry *registry, const QString &mime)
+{
+    // Don't grow registry indefinitely with unusual formats.
+    if ( registry->names.size() >= maxMimeAtomCount )
+        return createMimeAtom(mime, 0);
+
+    const MimeAtom atom = createMimeAtom( mime, registry->names.size() );
+    registry->names.append(mime);
+    registry->atoms.insert(mime, atom);
+    return atom;
+}
+
+MimeAtomRegistry &registry()
+{
+    // Never destroyed so atoms can be used until the process exits.
+    static auto registry = [](){
+        auto registry = new MimeAtomRegistry();
+
+        // Index zero is reserved for invalid atom.
+        registry->names.append(QString());
+
+        for ( const char *mime : {
+                  mimeText, mimeHtml, mimeUriList, mimeWindowTitle, mimeItemNotes,
+                  mimeOwner, mimeClipboardMode, mimeHidden, mimeColor } )
+        {
+            intern(registry, QString(mime));
+        }
+
+        return registry;
+    }();
+    return *registry;
+}
+
+} // namespace
+
+MimeAtom mimeAtom(const QString &mime)
+{
+    auto &r = registry();
+
+    {
+        QReadLocker lock(&r.lock);
+        const auto it = r.atoms.constFind(mime);
+        if ( it != r.atoms.constEnd() )
+            return it.value();
+    }
+
+    QWriteLocker lock(&r.lock);
+    const auto it = r.atoms.constFind(mime);
+    if ( it != r.atoms.constEnd() )
+        return it.value();
+
+    return intern(&r, mime);
+}
+
+MimeAtom uninternedMimeAtom(const QString &mime)
+{
+    return createMimeAtom(mime, 0);
+}
+
+MimeAtom findMimeAtom(const QString &mime)
+{
+    auto &r = registry();
+    QReadLocker lock(&r.lock);
+    return r.atoms.value(mime, 0);
+}
+
+QString mimeAtomName(MimeAtom atom)
+{
+    auto &r = registry();
+    const int index = static_cast<int>(atom & mimeAtomIndexMask);
+    QReadLocker lock(&r.lock);
+    Q_ASSERT( index < r.names.size() );
+    return r.names.value(index);
+}
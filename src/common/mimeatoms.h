@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MIMEATOMS_H
+#define MIMEATOMS_H
+
+#include <QtGlobal>
+
+class QString;
+
+/**
+ * Interned MIME type.
+ *
+ * Lower bits contain index to process-wide registry, upper bits contain
+ * flags precomputed from MIME type so these can be tested without lookups.
+ *
+ * Zero is not valid atom.
+ */
+using MimeAtom = quint32;
+
+/// Set for internal formats (MIME type starts with COPYQ_MIME_PREFIX).
+const MimeAtom MimeAtomInternal = 0x80000000;
+/// Set for formats provided by applications (not internal).
+const MimeAtom MimeAtomUser = 0x40000000;
+/// Set for text formats (MIME type starts with "text/").
+const MimeAtom MimeAtomText = 0x20000000;
+/// Set for image formats (MIME type starts with "image/").
+const MimeAtom MimeAtomImage = 0x10000000;
+
+const MimeAtom mimeAtomIndexMask = 0x00ffffff;
+
+/// Maximum number of interned MIME types (the registry is never shrunk).
+const int maxMimeAtomCount = 4096;
+
+/**
+ * Returns atom for MIME type (interns the MIME type if needed).
+ *
+ * If too many MIME types were interned already, returns uninterned atom
+ * (see uninternedMimeAtom()) and the MIME type needs to be kept by caller.
+ */
+MimeAtom mimeAtom(const QString &mime);
+
+/// Returns atom with flags for MIME type but without index to registry.
+MimeAtom uninternedMimeAtom(const QString &mime);
+
+/// Returns atom for MIME type or zero if the MIME type was not interned yet.
+MimeAtom findMimeAtom(const QString &mime);
+
+/// Returns MIME type for atom (empty for uninterned atom).
+QString mimeAtomName(MimeAtom atom);
+
+inline bool isInternedMimeAtom(MimeAtom atom) { return (atom & mimeAtomIndexMask) != 0; }
+inline bool isInternalMimeAtom(MimeAtom atom) { return (atom & MimeAtomInternal) != 0; }
+inline bool isUserMimeAtom(MimeAtom atom) { return (atom & MimeAtomUser) != 0; }
+inline bool isTextMimeAtom(MimeAtom atom) { return (atom & MimeAtomText) != 0; }
+inline bool isImageMimeAtom(MimeAtom atom) { return (atom & MimeAtomImage) != 0; }
+
+#endif // MIMEATOMS_H
@@ -29,6 +29,8 @@ extern const char mimeItems[];
 extern const char mimeItemNotes[];
 extern const char mimeOwner[];
 extern const char mimeClipboardMode[];
+extern const char mimeTraceEventId[];
+extern const char mimeClipboardSequence[];
 extern const char mimeCurrentTab[];
 extern const char mimeSelectedItems[];
 extern const char mimeCurrentItem[];
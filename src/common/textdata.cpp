@@ -27,6 +27,34 @@
 
 namespace {
 
+/// Maximum number of leading empty lines decoded for preview.
+const int maxPreviewEmptyLines = 1000;
+
+/// Maximum number of bytes per character (UTF-16 code unit) in UTF-8.
+const int maxUtf8CharSize = 4;
+
+bool isContinuationByte(char c)
+{
+    return (static_cast<uchar>(c) & 0xC0) == 0x80;
+}
+
+/// Returns position not in the middle of multi-byte UTF-8 character.
+int utf8Boundary(const QByteArray &bytes, int position)
+{
+    while ( position > 0 && position < bytes.size() && isContinuationByte(bytes[position]) )
+        --position;
+    return position;
+}
+
+bool isEmptyLine(const QString &line)
+{
+    for (const auto &c : line) {
+        if ( !c.isSpace() )
+            return false;
+    }
+    return true;
+}
+
 QString escapeHtmlSpaces(const QString &str)
 {
     QString str2 = str;
@@ -69,6 +97,103 @@ QString getTextData(const QByteArray &bytes)
     return QString::fromUtf8( bytes.constData(), bytes.size() );
 }
 
+QString getTextData(const QByteArray &bytes, int maxLength)
+{
+    if ( bytes.size() <= maxLength )
+        return getTextData(bytes);
+
+    const int size = utf8Boundary( bytes, qMin(bytes.size(), maxUtf8CharSize * maxLength) );
+    return QString::fromUtf8( bytes.constData(), size ).left(maxLength);
+}
+
+QString getTextDataChunk(const QByteArray &bytes, int *position, int maxSize)
+{
+    const int start = *position;
+    int end = qMin( bytes.size(), start + maxSize );
+    end = utf8Boundary(bytes, end);
+    // Always decode at least a character.
+    if (end <= start) {
+        end = start + 1;
+        while ( end < bytes.size() && isContinuationByte(bytes[end]) )
+            ++end;
+    }
+
+    *position = end;
+    return QString::fromUtf8( bytes.constData() + start, end - start );
+}
+
+QString getTextPreview(const QByteArray &bytes, int maxLines, int maxLineLength)
+{
+    QString preview;
+    int lineCount = 0;
+    int emptyLineCount = 0;
+
+    for (int start = 0; start <= bytes.size(); ) {
+        int end = bytes.indexOf('\n', start);
+        if (end == -1)
+            end = bytes.size();
+
+        const int lineSize = utf8Boundary( bytes, qMin(end, start + maxUtf8CharSize * maxLineLength) ) - start;
+        const QString line = QString::fromUtf8( bytes.constData() + start, lineSize ).left(maxLineLength);
+
+        if (start != 0)
+            preview.append('\n');
+        preview.append(line);
+
+        if ( lineCount > 0 || !isEmptyLine(line) )
+            ++lineCount;
+        else
+            ++emptyLineCount;
+
+        start = end + 1;
+        if ( start <= bytes.size() && (lineCount >= maxLines || emptyLineCount == maxPreviewEmptyLines) ) {
+            preview.append('\n');
+            break;
+        }
+    }
+
+    return preview;
+}
+
+TextMetadata textMetadata(const QByteArray &bytes)
+{
+    TextMetadata metadata;
+    metadata.lineCount = 1;
+
+    int pendingContinuationBytes = 0;
+    for (const char c : bytes) {
+        const auto byte = static_cast<uchar>(c);
+        if (pendingContinuationBytes > 0) {
+            if ( isContinuationByte(c) ) {
+                --pendingContinuationBytes;
+                continue;
+            }
+            pendingContinuationBytes = 0;
+        }
+
+        if (byte < 0x80) {
+            ++metadata.length;
+            if (c == '\n')
+                ++metadata.lineCount;
+        } else if ( (byte & 0xE0) == 0xC0 ) {
+            ++metadata.length;
+            pendingContinuationBytes = 1;
+        } else if ( (byte & 0xF0) == 0xE0 ) {
+            ++metadata.length;
+            pendingContinuationBytes = 2;
+        } else if ( (byte & 0xF8) == 0xF0 ) {
+            // Characters outside BMP are encoded as surrogate pairs in QString.
+            metadata.length += 2;
+            pendingContinuationBytes = 3;
+        } else {
+            // Invalid byte is decoded as replacement character.
+            ++metadata.length;
+        }
+    }
+
+    return metadata;
+}
+
 QString getTextData(const QVariantMap &data, const QString &mime)
 {
     const auto it = data.find(mime);
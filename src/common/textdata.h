@@ -25,6 +25,18 @@
 class QByteArray;
 class QString;
 
+/**
+ * Summary of UTF-8 encoded text computed without decoding whole text.
+ * @see textMetadata()
+ */
+struct TextMetadata {
+    /// Text length (same as size of decoded QString if text is valid UTF-8).
+    int length = 0;
+
+    /// Number of lines.
+    int lineCount = 0;
+};
+
 uint hash(const QVariantMap &data);
 
 QString quoteString(const QString &str);
@@ -33,6 +45,32 @@ QString escapeHtml(const QString &str);
 
 QString getTextData(const QByteArray &bytes);
 
+/**
+ * Decode at most @a maxLength characters from beginning of UTF-8 encoded text.
+ *
+ * Only the beginning of the data is decoded.
+ */
+QString getTextData(const QByteArray &bytes, int maxLength);
+
+/**
+ * Decode part of UTF-8 encoded text starting at byte @a position.
+ *
+ * At most @a maxSize bytes are decoded without splitting multi-byte characters
+ * and @a position is moved after the decoded part.
+ */
+QString getTextDataChunk(const QByteArray &bytes, int *position, int maxSize);
+
+/**
+ * Decode beginning of UTF-8 encoded text with at most @a maxLines lines
+ * after leading empty lines; each line is cut to @a maxLineLength characters.
+ *
+ * If the rest of the text is omitted, result ends with a newline.
+ */
+QString getTextPreview(const QByteArray &bytes, int maxLines, int maxLineLength);
+
+/** Return metadata for UTF-8 encoded text. */
+TextMetadata textMetadata(const QByteArray &bytes);
+
 /**
  * Get given text format from data; null string if not available.
  * Assumes that text data is UTF8 encoded.
@@ -0,0 +1,285 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trace.h"
+
+#include "common/log.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadStorage>
+
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+
+/// Maximum size of trace file before it's moved to backup file.
+const qint64 traceFileSize = 8 * 1024 * 1024;
+
+/// Write spans to file after this amount of data is pending even if some spans are still open.
+const int maxPendingTraceSize = 64 * 1024;
+
+struct TraceThreadData {
+    TraceThreadData()
+        : depth(0)
+        , threadId(0)
+    {
+    }
+
+    int depth;
+    int threadId;
+    QByteArray eventId;
+};
+
+QThreadStorage<TraceThreadData> traceThreadData;
+
+QMutex traceMutex;
+QByteArray pendingTrace;
+
+TraceThreadData &threadData()
+{
+    static QAtomicInt lastThreadId;
+
+    auto &data = traceThreadData.localData();
+    if (data.threadId == 0)
+        data.threadId = lastThreadId.fetchAndAddRelaxed(1) + 1;
+
+    return data;
+}
+
+qint64 monotonicTimeUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>( steady_clock::now().time_since_epoch() ).count();
+}
+
+QByteArray escapeJson(const QByteArray &text)
+{
+    QByteArray result;
+    result.reserve( text.size() );
+    for (const char c : text) {
+        if (c == '"' || c == '\\')
+            result.append('\\');
+        if ( static_cast<uchar>(c) >= 0x20 )
+            result.append(c);
+    }
+    return result;
+}
+
+QByteArray createTraceEvent(
+        const char *name, qint64 startUs, qint64 durationUs, const TraceThreadData &data)
+{
+    QByteArray event = "{\"name\":\"" + escapeJson(name)
+            + "\",\"cat\":\"copyq\",\"ph\":\"X\""
+            + ",\"ts\":" + QByteArray::number(startUs)
+            + ",\"dur\":" + QByteArray::number(durationUs)
+            + ",\"pid\":" + QByteArray::number(QCoreApplication::applicationPid())
+            + ",\"tid\":" + QByteArray::number(data.threadId)
+            + ",\"args\":{\"thread\":\"" + escapeJson(currentThreadLabel()) + "\"";
+
+    if ( !data.eventId.isEmpty() )
+        event.append(",\"event\":\"" + escapeJson(data.eventId) + "\"");
+
+    event.append("}}\n");
+    return event;
+}
+
+QString backupTraceFileName()
+{
+    return traceFileName() + ".1";
+}
+
+/**
+ * Appends spans to trace file (traceMutex must be locked).
+ *
+ * Returns error string on failure.
+ */
+QString writeTraceHelper(const QByteArray &trace)
+{
+    // Other processes append to the same file so the size check
+    // and moving the file to backup must not interleave with them.
+    SessionMutexLocker lock;
+
+    QFile f( traceFileName() );
+    if ( !f.open(QIODevice::Append) )
+        return f.errorString();
+
+    f.write(trace);
+
+    if ( f.size() > traceFileSize ) {
+        f.close();
+        QFile::remove( backupTraceFileName() );
+        QFile::rename( traceFileName(), backupTraceFileName() );
+    }
+
+    return QString();
+}
+
+void writeTrace(const QByteArray &trace)
+{
+    // Logging locks session mutex too.
+    const QString error = writeTraceHelper(trace);
+    if ( !error.isEmpty() )
+        log( QString("Failed to open trace file: %1").arg(error), LogWarning );
+}
+
+void flushTraceAtExit()
+{
+    flushTrace();
+}
+
+void addTraceEvent(const QByteArray &event, bool flush)
+{
+    QMutexLocker lock(&traceMutex);
+
+    static bool flushAtExitRegistered = false;
+    if (!flushAtExitRegistered) {
+        flushAtExitRegistered = true;
+        std::atexit(flushTraceAtExit);
+    }
+
+    pendingTrace.append(event);
+    if ( flush || pendingTrace.size() > maxPendingTraceSize ) {
+        writeTrace(pendingTrace);
+        pendingTrace.clear();
+    }
+}
+
+QByteArray readTraceFile(const QString &fileName)
+{
+    QFile f(fileName);
+    if ( !f.open(QIODevice::ReadOnly) )
+        return QByteArray();
+    return f.readAll();
+}
+
+} // namespace
+
+bool isTracingEnabled()
+{
+    static const bool enabled = [](){
+        const QByteArray value = qgetenv("COPYQ_TRACE");
+        return !value.isEmpty() && value != "0";
+    }();
+    return enabled;
+}
+
+QString traceFileName()
+{
+    QString fileName = logFileName();
+    if ( fileName.endsWith(".log") )
+        fileName.chop(4);
+    return fileName + ".trace";
+}
+
+QByteArray createTraceEventId()
+{
+    static QAtomicInt lastEventId;
+    return QByteArray::number(QCoreApplication::applicationPid())
+            + "-" + QByteArray::number(lastEventId.fetchAndAddRelaxed(1) + 1);
+}
+
+QByteArray currentTraceEventId()
+{
+    return isTracingEnabled() ? threadData().eventId : QByteArray();
+}
+
+void flushTrace()
+{
+    QMutexLocker lock(&traceMutex);
+    if ( !pendingTrace.isEmpty() ) {
+        writeTrace(pendingTrace);
+        pendingTrace.clear();
+    }
+}
+
+QByteArray readTrace()
+{
+    flushTrace();
+
+    QByteArray trace;
+    {
+        // Avoid reading while the trace file is moved to backup.
+        SessionMutexLocker lock;
+        trace = readTraceFile( backupTraceFileName() );
+        trace.append( readTraceFile(traceFileName()) );
+    }
+
+    QByteArray result = "{\"traceEvents\":[\n";
+    bool first = true;
+    for ( const auto &line : trace.split('\n') ) {
+        // Skip incomplete lines.
+        if ( !line.startsWith('{') || !line.endsWith('}') )
+            continue;
+
+        if (!first)
+            result.append(",\n");
+        first = false;
+        result.append(line);
+    }
+    result.append("\n]}\n");
+
+    return result;
+}
+
+TraceSpan::TraceSpan(const char *name)
+    : m_name(name)
+    , m_startUs(-1)
+{
+    if ( !isTracingEnabled() )
+        return;
+
+    ++threadData().depth;
+    m_startUs = monotonicTimeUs();
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_startUs == -1)
+        return;
+
+    const qint64 durationUs = monotonicTimeUs() - m_startUs;
+    auto &data = threadData();
+    --data.depth;
+
+    // Write spans to trace file once the outermost span ends.
+    addTraceEvent( createTraceEvent(m_name, m_startUs, durationUs, data), data.depth == 0 );
+}
+
+TraceEventScope::TraceEventScope(const QByteArray &id)
+    : m_enabled( isTracingEnabled() )
+{
+    if (!m_enabled)
+        return;
+
+    auto &data = threadData();
+    m_oldId = data.eventId;
+    if ( !id.isEmpty() )
+        data.eventId = id;
+}
+
+TraceEventScope::~TraceEventScope()
+{
+    if (m_enabled)
+        threadData().eventId = m_oldId;
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+class QString;
+
+/// Returns true if performance tracing is enabled (COPYQ_TRACE environment variable is set).
+bool isTracingEnabled();
+
+QString traceFileName();
+
+/// Returns new ID for correlating trace spans of a clipboard change across processes.
+QByteArray createTraceEventId();
+
+/// Returns trace event ID of spans in current thread.
+QByteArray currentTraceEventId();
+
+/// Writes pending trace spans of current process to trace file.
+void flushTrace();
+
+/// Returns recorded trace spans in Chrome trace-event JSON format.
+QByteArray readTrace();
+
+/**
+ * Records time spent in a scope for performance tracing.
+ *
+ * Spans from all processes are appended to a trace file
+ * with monotonic time stamps, process and thread labels.
+ *
+ * Does nothing unless tracing is enabled.
+ */
+class TraceSpan final {
+public:
+    explicit TraceSpan(const char *name);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_startUs;
+};
+
+/// Sets trace event ID of spans in current thread for the scope.
+class TraceEventScope final {
+public:
+    explicit TraceEventScope(const QByteArray &id);
+    ~TraceEventScope();
+
+    TraceEventScope(const TraceEventScope &) = delete;
+    TraceEventScope &operator=(const TraceEventScope &) = delete;
+
+private:
+    QByteArray m_oldId;
+    bool m_enabled;
+};
+
+#define COPYQ_TRACE_CONCAT_(a, b) a ## b
+#define COPYQ_TRACE_CONCAT(a, b) COPYQ_TRACE_CONCAT_(a, b)
+
+/// Records time spent in current scope.
+#define COPYQ_TRACE(name) TraceSpan COPYQ_TRACE_CONCAT(traceSpan_, __LINE__)(name)
+
+#endif // TRACE_H
@@ -21,11 +21,13 @@
 
 #include "common/appconfig.h"
 #include "common/action.h"
+#include "common/actionstatsmodel.h"
 #include "common/actiontablemodel.h"
 #include "common/common.h"
 #include "common/contenttype.h"
 #include "common/display.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
 #include "common/textdata.h"
 #include "gui/actionhandlerdialog.h"
@@ -37,11 +39,58 @@
 #include "item/serialize.h"
 
 #include <QDialog>
+#include <QThread>
 
 #include <cmath>
 
 namespace {
 
+/// Default maximum number of running actions with a scheduled priority.
+int defaultMaxRunningScheduledActions()
+{
+    return qMax(8, 4 * QThread::idealThreadCount());
+}
+
+MetricGauge &activeActions()
+{
+    static auto &gauge = metricGauge("copyq_actions_active", "Number of running and queued actions.");
+    return gauge;
+}
+
+const char *priorityName(ActionPriority priority)
+{
+    switch (priority) {
+    case ActionPriority::Interactive: return "interactive";
+    case ActionPriority::Automatic: return "automatic";
+    case ActionPriority::Background: return "background";
+    case ActionPriority::Immediate: return "immediate";
+    }
+
+    Q_ASSERT(false);
+    return "";
+}
+
+MetricGauge &queuedActions(ActionPriority priority)
+{
+    return metricGauge(
+        "copyq_actions_queued", "Number of actions waiting to start.",
+        metricLabel("priority", priorityName(priority)) );
+}
+
+MetricHistogram &actionQueueWait(ActionPriority priority)
+{
+    return metricHistogram(
+        "copyq_action_queue_wait_seconds", "Time actions spent waiting to start.",
+        metricLabel("priority", priorityName(priority)) );
+}
+
+MetricCounter &mergedActions()
+{
+    static auto &counter = metricCounter(
+        "copyq_actions_merged_total", "Number of internal actions merged with identical pending actions.");
+    return counter;
+}
+
 QString actionDescription(const Action &action)
 {
     const auto name = action.name();
@@ -57,12 +106,31 @@ ActionHandler::ActionHandler(NotificationDaemon *notificationDaemon, QWidget *pa
     : QObject(parent)
     , m_notificationDaemon(notificationDaemon)
     , m_actionModel(new ActionTableModel(parent))
+    , m_statsModel(new ActionStatsModel(parent))
+{
+    m_queueClock.start();
+    setMaxRunningActions(0);
+}
+
+void ActionHandler::setMaxRunningActions(int maxRunningActions)
 {
+    m_maxRunningScheduledActions = maxRunningActions > 0
+            ? maxRunningActions : defaultMaxRunningScheduledActions();
+
+    // Background scripts only update window title and notifications,
+    // so running the latest one is enough.
+    m_maxRunningActions = {{
+        qMax(1, m_maxRunningScheduledActions * 3 / 4),
+        qMax(1, m_maxRunningScheduledActions / 4),
+        1
+    }};
+
+    startPendingActions();
 }
 
 void ActionHandler::showProcessManagerDialog(QWidget *parent)
 {
-    auto dialog = new ActionHandlerDialog(this, m_actionModel, parent);
+    auto dialog = new ActionHandlerDialog(this, m_actionModel, m_statsModel, parent);
     dialog->setAttribute(Qt::WA_DeleteOnClose, true);
     dialog->show();
 }
@@ -70,6 +138,7 @@ void ActionHandler::showProcessManagerDialog(QWidget *parent)
 void ActionHandler::addFinishedAction(const QString &name)
 {
     m_actionModel->actionFinished(name);
+    m_statsModel->addAction(name, 0, false);
 }
 
 QVariantMap ActionHandler::actionData(int id) const
@@ -85,11 +154,23 @@ void ActionHandler::setActionData(int id, const QVariantMap &data)
         action->setData(data);
 }
 
-void ActionHandler::internalAction(Action *action)
+Action *ActionHandler::internalAction(Action *action, ActionPriority priority)
 {
-    this->action(action);
+    if (priority == ActionPriority::Background) {
+        const auto pendingAction = findPendingAction(*action, priority);
+        if (pendingAction) {
+            COPYQ_LOG( QString("Merging with pending action: %1").arg(actionDescription(*action)) );
+            mergedActions().add();
+            delete action;
+            return pendingAction;
+        }
+    }
+
+    this->action(action, priority);
     if ( m_actions.contains(action->id()) )
         m_internalActions.insert(action->id());
+
+    return action;
 }
 
 bool ActionHandler::isInternalActionId(int id) const
@@ -97,31 +178,101 @@ bool ActionHandler::isInternalActionId(int id) const
     return m_internalActions.contains(id);
 }
 
-void ActionHandler::action(Action *action)
+void ActionHandler::action(Action *action, ActionPriority priority)
 {
     action->setParent(this);
 
-    const auto id = m_actionModel->rowCount();
+    const auto id = m_actionModel->actionAboutToStart(action);
     action->setId(id);
     m_actions.insert(id, action);
+    activeActions().add(1);
 
     connect( action, &Action::actionStarted,
              this, &ActionHandler::actionStarted );
     connect( action, &Action::actionFinished,
              this, &ActionHandler::closeAction );
 
-    m_actionModel->actionAboutToStart(action);
-    COPYQ_LOG( QString("Executing: %1").arg(actionDescription(*action)) );
-    action->start();
+    if (priority == ActionPriority::Immediate) {
+        startAction(action);
+        return;
+    }
+
+    m_pendingActions[static_cast<size_t>(priority)].push_back( PendingAction{action, m_queueClock.elapsed()} );
+    queuedActions(priority).add(1);
+    startPendingActions();
 }
 
 void ActionHandler::terminateAction(int id)
 {
     Action *action = m_actions.value(id);
-    if (action)
+    if (!action)
+        return;
+
+    if ( removePendingAction(action) )
+        closeAction(action);
+    else
         action->terminate();
 }
 
+void ActionHandler::startAction(Action *action)
+{
+    COPYQ_LOG( QString("Executing: %1").arg(actionDescription(*action)) );
+    action->start();
+}
+
+void ActionHandler::startPendingActions()
+{
+    for (size_t i = 0; i < m_pendingActions.size(); ++i) {
+        const auto priority = static_cast<ActionPriority>(i);
+        auto &queue = m_pendingActions[i];
+        while ( !queue.empty()
+                && m_runningPriorities.size() < m_maxRunningScheduledActions
+                && m_runningActionCounts[i] < m_maxRunningActions[i] )
+        {
+            const auto pendingAction = queue.front();
+            queue.pop_front();
+            queuedActions(priority).add(-1);
+            actionQueueWait(priority).observe(
+                1000 * (m_queueClock.elapsed() - pendingAction.queuedMsec) );
+
+            ++m_runningActionCounts[i];
+            m_runningPriorities.insert(pendingAction.action->id(), priority);
+            startAction(pendingAction.action);
+        }
+    }
+}
+
+Action *ActionHandler::findPendingAction(const Action &action, ActionPriority priority) const
+{
+    for (const auto &pendingAction : m_pendingActions[static_cast<size_t>(priority)]) {
+        const auto pending = pendingAction.action;
+        if ( pending->command() == action.command()
+             && pending->input() == action.input()
+             && pending->data() == action.data() )
+        {
+            return pending;
+        }
+    }
+
+    return nullptr;
+}
+
+bool ActionHandler::removePendingAction(Action *action)
+{
+    for (size_t i = 0; i < m_pendingActions.size(); ++i) {
+        auto &queue = m_pendingActions[i];
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (it->action == action) {
+                queue.erase(it);
+                queuedActions( static_cast<ActionPriority>(i) ).add(-1);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 void ActionHandler::actionStarted(Action *action)
 {
     m_actionModel->actionStarted(action);
@@ -132,6 +283,7 @@ void ActionHandler::closeAction(Action *action)
 {
     m_actions.remove(action->id());
     m_internalActions.remove(action->id());
+    activeActions().add(-1);
 
     if ( action->actionFailed() ) {
         const auto msg = tr("Error: %1").arg(action->errorString());
@@ -148,12 +300,21 @@ void ActionHandler::closeAction(Action *action)
         showActionErrors(action, msg, IconTimesCircle);
     }
 
-    m_actionModel->actionFinished(action);
+    const auto durationMsec = m_actionModel->actionFinished(action);
+    const bool failed = action->actionFailed() || action->exitCode() != 0;
+    m_statsModel->addAction( ActionTableModel::actionName(*action), durationMsec, failed );
     Q_ASSERT(runningActionCount() >= 0);
 
     emit runningActionsCountChanged();
 
     action->deleteLater();
+
+    const auto it = m_runningPriorities.find(action->id());
+    if ( it != m_runningPriorities.end() ) {
+        --m_runningActionCounts[static_cast<size_t>(it.value())];
+        m_runningPriorities.erase(it);
+        startPendingActions();
+    }
 }
 
 void ActionHandler::showActionErrors(Action *action, const QString &message, ushort icon)
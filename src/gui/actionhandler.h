@@ -20,11 +20,19 @@
 #ifndef ACTIONHANDLER_H
 #define ACTIONHANDLER_H
 
+#include "common/actionhandlerenums.h"
+
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QSet>
 
+#include <array>
+#include <deque>
+
 class Action;
 class NotificationDaemon;
+class ActionStatsModel;
 class ActionTableModel;
 
 class ActionHandler : public QObject
@@ -42,11 +50,25 @@ public:
     QVariantMap actionData(int id) const;
     void setActionData(int id, const QVariantMap &data);
 
-    void internalAction(Action *action);
+    /**
+     * Execute internal action (not counted in running actions).
+     *
+     * Returns the action to wait for, which is an identical pending action
+     * if the new one was merged with it (the new action is deleted).
+     */
+    Action *internalAction(Action *action, ActionPriority priority = ActionPriority::Immediate);
     bool isInternalActionId(int id) const;
 
-    /** Execute action. */
-    void action(Action *action);
+    /**
+     * Set maximum number of running actions with a scheduled priority
+     * (zero to derive it from number of CPU cores).
+     *
+     * Limits for each priority are derived from the value.
+     */
+    void setMaxRunningActions(int maxRunningActions);
+
+    /** Execute action or queue it if too many actions of the same priority are running. */
+    void action(Action *action, ActionPriority priority = ActionPriority::Interactive);
 
     void terminateAction(int id);
 
@@ -55,6 +77,19 @@ signals:
     void runningActionsCountChanged();
 
 private:
+    struct PendingAction {
+        Action *action;
+        qint64 queuedMsec;
+    };
+
+    void startAction(Action *action);
+
+    /** Start queued actions in order of priority while limits allow it. */
+    void startPendingActions();
+
+    Action *findPendingAction(const Action &action, ActionPriority priority) const;
+    bool removePendingAction(Action *action);
+
     /** Called after action was started (creates menu item to kill it). */
     void actionStarted(Action *action);
 
@@ -65,9 +100,20 @@ private:
 
     NotificationDaemon *m_notificationDaemon;
     ActionTableModel *m_actionModel;
+    ActionStatsModel *m_statsModel;
     QHash<int, Action*> m_actions;
     QSet<int> m_internalActions;
-    int m_lastActionId = -1;
+
+    /// Queued actions for each scheduled priority.
+    std::array<std::deque<PendingAction>, 3> m_pendingActions;
+    /// Maximum number of running actions for each scheduled priority.
+    std::array<int, 3> m_maxRunningActions = {{1, 1, 1}};
+    int m_maxRunningScheduledActions = 1;
+    /// Number of running actions for each scheduled priority.
+    std::array<int, 3> m_runningActionCounts = {{0, 0, 0}};
+    /// Priorities of started scheduled actions by ID.
+    QHash<int, ActionPriority> m_runningPriorities;
+    QElapsedTimer m_queueClock;
 };
 
 #endif // ACTIONHANDLER_H
@@ -29,11 +29,11 @@
 
 namespace {
 
-void terminateSelectedActions(QItemSelectionModel *selectionModel, QSortFilterProxyModel *model, ActionHandler *actionHandler)
+void terminateSelectedActions(QItemSelectionModel *selectionModel, ActionHandler *actionHandler)
 {
      QSet<int> ids;
      for ( const auto &index : selectionModel->selectedIndexes() ) {
-         const int actionId = model->mapToSource(index).row();
+         const int actionId = index.sibling(index.row(), ActionHandlerColumn::id).data().toInt();
          ids.insert(actionId);
      }
      for (const int id : ids)
@@ -57,7 +57,9 @@ void updateTerminateButton(QItemSelectionModel *selectionModel, QAbstractItemMod
 
 } // namespace
 
-ActionHandlerDialog::ActionHandlerDialog(ActionHandler *actionHandler, QAbstractItemModel *model, QWidget *parent)
+ActionHandlerDialog::ActionHandlerDialog(
+        ActionHandler *actionHandler, QAbstractItemModel *model, QAbstractItemModel *statsModel,
+        QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::ActionHandlerDialog)
 {
@@ -74,16 +76,28 @@ ActionHandlerDialog::ActionHandlerDialog(ActionHandler *actionHandler, QAbstract
 
     ui->tableView->sortByColumn(ActionHandlerColumn::status, Qt::DescendingOrder);
 
+    auto statsProxyModel = new QSortFilterProxyModel(this);
+    statsProxyModel->setSourceModel(statsModel);
+    statsProxyModel->setDynamicSortFilter(true);
+    statsProxyModel->setSortRole(Qt::UserRole + ActionHandlerRole::sort);
+    statsProxyModel->setFilterKeyColumn(ActionStatsColumn::name);
+    ui->statsTableView->setModel(statsProxyModel);
+
+    ui->statsTableView->resizeColumnsToContents();
+
+    ui->statsTableView->sortByColumn(ActionStatsColumn::total, Qt::DescendingOrder);
+
     connect( ui->filterLineEdit, &QLineEdit::textChanged, proxyModel,
-             [proxyModel](const QString &pattern) {
+             [proxyModel, statsProxyModel](const QString &pattern) {
                  const QRegExp re(pattern, Qt::CaseInsensitive);
                  proxyModel->setFilterRegExp(re);
+                 statsProxyModel->setFilterRegExp(re);
              } );
 
     const auto selectionModel = ui->tableView->selectionModel();
     connect( ui->terminateButton, &QPushButton::clicked, this,
-             [selectionModel, actionHandler, proxyModel]() {
-                 terminateSelectedActions(selectionModel, proxyModel, actionHandler);
+             [selectionModel, actionHandler]() {
+                 terminateSelectedActions(selectionModel, actionHandler);
              } );
 
     const auto updateTerminateButtonSlot =
@@ -32,7 +32,9 @@ class ActionHandlerDialog;
 class ActionHandlerDialog : public QDialog
 {
 public:
-    explicit ActionHandlerDialog(ActionHandler *actionHandler, QAbstractItemModel *model, QWidget *parent = nullptr);
+    explicit ActionHandlerDialog(
+            ActionHandler *actionHandler, QAbstractItemModel *model, QAbstractItemModel *statsModel,
+            QWidget *parent = nullptr);
     ~ActionHandlerDialog();
 
 private:
@@ -22,10 +22,12 @@
 #include "common/common.h"
 #include "common/contenttype.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
 #include "common/temporaryfile.h"
 #include "common/textdata.h"
 #include "common/timer.h"
+#include "common/trace.h"
 #include "gui/clipboarddialog.h"
 #include "gui/iconfactory.h"
 #include "gui/icons.h"
@@ -561,6 +563,10 @@ void ClipboardBrowser::connectModelAndDelegate()
              &d, &ItemDelegate::rowsRemoved );
     connect( &m, &QAbstractItemModel::rowsAboutToBeMoved,
              &d, &ItemDelegate::rowsMoved );
+    connect( &m, &QAbstractItemModel::layoutAboutToBeChanged,
+             &d, &ItemDelegate::layoutAboutToBeChanged );
+    connect( &m, &QAbstractItemModel::layoutChanged,
+             &d, &ItemDelegate::layoutChanged );
     connect( &m, &QAbstractItemModel::dataChanged,
              &d, &ItemDelegate::dataChanged );
 
@@ -582,6 +588,8 @@ void ClipboardBrowser::connectModelAndDelegate()
              this, &ClipboardBrowser::delayedSaveItems );
     connect( &m, &QAbstractItemModel::rowsMoved,
              this, &ClipboardBrowser::delayedSaveItems );
+    connect( &m, &QAbstractItemModel::layoutChanged,
+             this, &ClipboardBrowser::delayedSaveItems );
     connect( &m, &QAbstractItemModel::dataChanged,
              this, &ClipboardBrowser::delayedSaveItems );
 
@@ -1339,6 +1347,10 @@ void ClipboardBrowser::filterItems(const QRegExp &re)
     if ( (d.searchExpression().isEmpty() && re.isEmpty()) || d.searchExpression() == re )
         return;
 
+    static auto &filterDuration = metricHistogram(
+        "copyq_filter_duration_seconds", "Time spent filtering items in a tab.");
+    MetricTimer timer(&filterDuration);
+
     d.setSearch(re);
 
     // If search string is a number, highlight item in that row.
@@ -1643,6 +1655,8 @@ bool ClipboardBrowser::add(const QVariantMap &data, int row)
 
 void ClipboardBrowser::addUnique(const QVariantMap &data, ClipboardMode mode)
 {
+    COPYQ_TRACE("ClipboardBrowser::addUnique");
+
     if ( moveToTop(hash(data)) ) {
         COPYQ_LOG("New item: Moving existing to top");
         return;
@@ -1710,11 +1724,17 @@ bool ClipboardBrowser::loadItems()
 
 bool ClipboardBrowser::saveItems()
 {
+    COPYQ_TRACE("ClipboardBrowser::saveItems");
+
     m_timerSave.stop();
 
     if ( !isLoaded() || m_tabName.isEmpty() )
         return false;
 
+    static auto &saveDuration = metricHistogram(
+        "copyq_tab_save_duration_seconds", "Time spent saving items in a tab.");
+    MetricTimer timer(&saveDuration);
+
     return ::saveItems(m_tabName, m, m_itemSaver);
 }
 
@@ -73,6 +73,9 @@ class ClipboardBrowser : public QListView
         /** Index of item in given row. */
         QModelIndex index(int i) const { return m.index(i,0); }
 
+        /** Return index of item with given @a hash (invalid if not found). */
+        QModelIndex findItem(uint itemHash) const { return index( m.findItem(itemHash) ); }
+
         /** Returns concatenation of selected items. */
         const QString selectedText() const;
 
@@ -148,6 +151,22 @@ class ClipboardBrowser : public QListView
         /** Number of items in list. */
         int length() const { return m.rowCount(); }
 
+        /** Number of created item widgets. */
+        int itemWidgetCount() const { return d.cacheSize(); }
+
+        /** Approximate number of bytes used by item data in memory. */
+        qint64 itemDataSize() const { return m.dataSize(); }
+
+        /** Number of bytes of item data in memory-mapped tab file. */
+        qint64 itemMappedDataSize() const { return m.mappedDataSize(); }
+
+        /**
+         * Approximate number of bytes used by item data and item widgets.
+         *
+         * Excludes memory-mapped item data which the system can drop from memory.
+         */
+        qint64 memoryUsage() const { return m.dataSize() + d.cacheMemoryUsage(); }
+
         /** Receive key event. */
         void keyEvent(QKeyEvent *event) { keyPressEvent(event); }
         /** Move item to clipboard. */
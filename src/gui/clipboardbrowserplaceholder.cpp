@@ -26,6 +26,7 @@
 #include "gui/iconfactory.h"
 #include "gui/icons.h"
 
+#include <QElapsedTimer>
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QWidget>
@@ -61,6 +62,11 @@ ClipboardBrowser *ClipboardBrowserPlaceholder::createBrowser()
         return nullptr;
     }
 
+    connect( c.get(), &ClipboardBrowser::itemSelectionChanged,
+             this, &ClipboardBrowserPlaceholder::updateLastActivity );
+    connect( c.get(), &ClipboardBrowser::itemsChanged,
+             this, &ClipboardBrowserPlaceholder::updateLastActivity );
+
     if (m_timerExpire.interval() > 0) {
         connect( c.get(), &ClipboardBrowser::itemSelectionChanged,
                  &m_timerExpire, static_cast<void (QTimer::*)()>(&QTimer::start) );
@@ -72,6 +78,7 @@ ClipboardBrowser *ClipboardBrowserPlaceholder::createBrowser()
     setActiveWidget(m_browser);
 
     restartExpiring();
+    updateLastActivity();
 
     return m_browser;
 }
@@ -134,12 +141,14 @@ void ClipboardBrowserPlaceholder::reloadBrowser()
 void ClipboardBrowserPlaceholder::showEvent(QShowEvent *event)
 {
     createBrowser();
+    updateLastActivity();
     QWidget::showEvent(event);
 }
 
 void ClipboardBrowserPlaceholder::hideEvent(QHideEvent *event)
 {
     restartExpiring();
+    updateLastActivity();
     QWidget::hideEvent(event);
 }
 
@@ -199,6 +208,15 @@ void ClipboardBrowserPlaceholder::restartExpiring()
         m_timerExpire.start();
 }
 
+void ClipboardBrowserPlaceholder::updateLastActivity()
+{
+    static QElapsedTimer clock;
+    if ( !clock.isValid() )
+        clock.start();
+
+    m_lastActivity = clock.elapsed();
+}
+
 bool ClipboardBrowserPlaceholder::isEditorOpen() const
 {
     return m_browser && (
@@ -65,6 +65,12 @@ public:
     /// Unload browser and data.
     void expire();
 
+    /// Returns true if browser is loaded and can be unloaded (it's hidden and no editor is open).
+    bool canExpire() const;
+
+    /// Returns time of last activity in browser in milliseconds (monotonic clock).
+    qint64 lastActivity() const { return m_lastActivity; }
+
 signals:
     void browserCreated(ClipboardBrowser *browser);
 
@@ -79,10 +85,10 @@ private:
 
     void unloadBrowser();
 
-    bool canExpire() const;
-
     void restartExpiring();
 
+    void updateLastActivity();
+
     bool isEditorOpen() const;
 
     ClipboardBrowser *m_browser = nullptr;
@@ -92,6 +98,8 @@ private:
     ClipboardBrowserSharedPtr m_sharedData;
 
     QTimer m_timerExpire;
+
+    qint64 m_lastActivity = 0;
 };
 
 #endif // CLIPBOARDBROWSERPLACEHOLDER_H
@@ -49,6 +49,8 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("edit", "edit([row|text] ...)", "Edits items in current tab.");
     addDocumentation("read", "ByteArray read([mimeType])", "Same as `clipboard()`.");
     addDocumentation("read", "ByteArray read(mimeType, row, ...)", "Returns concatenated data from items, or clipboard if row is negative.");
+    addDocumentation("itemsData", "Item[] itemsData([mimeType, ...])", "Returns data of all items in current tab.");
+    addDocumentation("queryItemsIndex", "queryItemsIndex(mimeType, query, [argument, ...])", "Queries index of items in given format kept by a plugin for current tab.");
     addDocumentation("write", "write(row, mimeType, data, [mimeType, data]...)", "Inserts new item to current tab.");
     addDocumentation("change", "change(row, mimeType, data, [mimeType, data]...)", "Changes data in item in current tab.");
     addDocumentation("separator", "String separator()", "Returns item separator (used when concatenating item data).");
@@ -67,6 +69,8 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("config", "String config(optionName, value, ...)", "Sets multiple application options and return list with values in format");
     addDocumentation("toggleConfig", "bool toggleConfig(optionName)", "Toggles an option (true to false and vice versa) and returns the new value.");
     addDocumentation("info", "String info([pathName])", "Returns paths and flags used by the application.");
+    addDocumentation("trace", "ByteArray trace()", "Returns performance trace of clipboard processing in Chrome trace-event JSON format.");
+    addDocumentation("metrics", "ByteArray metrics()", "Returns runtime metrics of the application in Prometheus text format.");
     addDocumentation("eval", "Value eval(script)", "Evaluates script and returns result.");
     addDocumentation("source", "Value source(fileName)", "Evaluates script file and returns result of last expression in the script.");
     addDocumentation("currentPath", "currentPath([path])", "Set current path.");
@@ -90,8 +94,11 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("selectedItems", "int[] selectedItems()", "Returns selected rows in current tab.");
     addDocumentation("selectedItemData", "Item selectedItemData(index)", "Returns data for given selected item.");
     addDocumentation("setSelectedItemData", "bool setSelectedItemData(index, item)", "Set data for given selected item.");
-    addDocumentation("selectedItemsData", "Item[] selectedItemsData()", "Returns data for all selected items.");
+    addDocumentation("selectedItemsData", "Item[] selectedItemsData([mimeType, ...])", "Returns data for all selected items.");
     addDocumentation("setSelectedItemsData", "setSelectedItemsData(item[])", "Set data to all selected items.");
+    addDocumentation("patchSelectedItemsData", "patchSelectedItemsData(item[])", "Set only given formats for all selected items.");
+    addDocumentation("addSelectedItemsListValue", "addSelectedItemsListValue(mimeType, value)", "Adds value to comma-separated list in given format of selected items.");
+    addDocumentation("removeSelectedItemsListValue", "removeSelectedItemsListValue(mimeType, value)", "Removes value from comma-separated list in given format of selected items.");
     addDocumentation("currentItem", "int currentItem(), int index()", "Returns current row in current tab.");
     addDocumentation("escapeHtml", "String escapeHtml(text)", "Returns text with special HTML characters escaped.");
     addDocumentation("unpack", "Item unpack(data)", "Returns deserialized object from serialized items.");
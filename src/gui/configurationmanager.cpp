@@ -208,6 +208,7 @@ void ConfigurationManager::initOptions()
     bind<Config::clipboard_tab>(ui->comboBoxClipboardTab->lineEdit());
     bind<Config::maxitems>(ui->spinBoxItems);
     bind<Config::expire_tab>(ui->spinBoxExpireTab);
+    bind<Config::memory_budget>(ui->spinBoxMemoryBudget);
     bind<Config::editor>(ui->lineEditEditor);
     bind<Config::item_popup_interval>(ui->spinBoxNotificationPopupInterval);
     bind<Config::notification_position>(ui->comboBoxNotificationPosition);
@@ -252,6 +253,8 @@ void ConfigurationManager::initOptions()
 
     /* other options */
     bind<Config::command_history_size>();
+    bind<Config::menu_filter_cache_ttl>();
+    bind<Config::max_running_commands>();
 #ifdef HAS_MOUSE_SELECTIONS
     /* X11 clipboard selection monitoring and synchronization */
     bind<Config::check_selection>(ui->checkBoxSel);
@@ -22,9 +22,13 @@
 #include "common/common.h"
 #include "common/log.h"
 #include "common/timer.h"
+#include "common/trace.h"
 
 #include <QCheckBox>
 #include <QElapsedTimer>
+#include <QFile>
+#include <QFileDialog>
+#include <QPushButton>
 #include <QRegExp>
 #include <QTextBlock>
 #include <QTextCharFormat>
@@ -247,6 +251,12 @@ LogDialog::LogDialog(QWidget *parent)
     addFilterCheckBox(LogTrace, &LogDialog::showTrace);
     ui->layoutFilters->addStretch(1);
 
+    if ( isTracingEnabled() ) {
+        auto buttonSaveTrace = new QPushButton(tr("Save Trace..."), this);
+        QObject::connect(buttonSaveTrace, &QPushButton::clicked, this, &LogDialog::saveTrace);
+        ui->layoutFilters->addWidget(buttonSaveTrace);
+    }
+
     updateLog();
 }
 
@@ -317,6 +327,21 @@ void LogDialog::showTrace(bool show)
     updateLog();
 }
 
+void LogDialog::saveTrace()
+{
+    QString fileName =
+            QFileDialog::getSaveFileName(this, tr("Save Performance Trace"),
+                                          QString(), tr("Chrome Trace (*.json)"));
+    if ( !fileName.isEmpty() ) {
+        if ( !fileName.endsWith(".json") )
+            fileName.append(".json");
+
+        QFile f(fileName);
+        if ( !f.open(QIODevice::WriteOnly) || f.write(readTrace()) == -1 )
+            log( QString("Failed to save trace file: %1").arg(f.errorString()), LogError );
+    }
+}
+
 void LogDialog::addFilterCheckBox(LogLevel level, FilterCheckBoxSlot slot)
 {
     auto checkBox = new QCheckBox(this);
@@ -46,6 +46,8 @@ private:
     void showDebug(bool show);
     void showTrace(bool show);
 
+    void saveTrace();
+
     void addFilterCheckBox(LogLevel level, FilterCheckBoxSlot slot);
 
     Ui::LogDialog *ui;
@@ -93,6 +93,9 @@ namespace {
 const int contextMenuUpdateIntervalMsec = 100;
 const int trayMenuUpdateIntervalMsec = 100;
 
+/// Maximum approximate size of cached display data in KiB.
+const int displayDataCacheSizeKiB = 16 * 1024;
+
 const QIcon iconClipboard() { return getIcon("clipboard", IconPaste); }
 const QIcon iconTabIcon() { return getIconFromResources("tab_icon"); }
 const QIcon iconTabNew() { return getIconFromResources("tab_new"); }
@@ -103,6 +106,28 @@ const char propertyWidgetSizeGuarded[] = "CopyQ_widget_size_guarded";
 
 const char propertyActionFilterCommandFailed[] = "CopyQ_action_filter_command_failed";
 
+/// Maximum number of cached results of menu command filters.
+const int maxMenuFilterCacheSize = 1000;
+
+/// Returns hash of all item data passed to display commands and menu command filters.
+uint itemDataHash(const QVariantMap &data)
+{
+    uint result = 0;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        result = qHash(it.key(), result);
+        result = qHash(it.value().toByteArray(), result);
+    }
+    return result;
+}
+
+int displayDataCost(const QVariantMap &data)
+{
+    int sizeBytes = 0;
+    for (const auto &value : data)
+        sizeBytes += value.toByteArray().size();
+    return 1 + sizeBytes / 1024;
+}
+
 /// Omit size changes of a widget.
 class WidgetSizeGuard final : public QObject {
 public:
@@ -368,6 +393,7 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
     , m_wasMaximized(false)
     , m_showItemPreview(false)
     , m_menuItems(menuItems())
+    , m_displayDataCache(displayDataCacheSizeKiB)
     , m_clipboardManager(m_actionHandler)
 {
     ui->setupUi(this);
@@ -448,6 +474,11 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
     initSingleShotTimer( &m_timerTrayIconSnip, 500, this, &MainWindow::updateIconSnipTimeout );
     initSingleShotTimer( &m_timerSaveTabPositions, 1000, this, &MainWindow::doSaveTabPositions );
     initSingleShotTimer( &m_timerRaiseLastWindowAfterMenuClosed, 50, this, &MainWindow::raiseLastWindowAfterMenuClosed);
+    initSingleShotTimer( &m_timerEnforceMemoryBudget, 1000, this, &MainWindow::enforceMemoryBudget );
+    initSingleShotTimer( &m_timerRunDisplayCommands, 0, this, [this]() {
+        if (!m_currentDisplayAction)
+            runDisplayCommands();
+    } );
     enableHideWindowOnUnfocus();
 
     m_trayMenu->setObjectName("TrayMenu");
@@ -703,7 +734,8 @@ void MainWindow::updateTrayMenuClipboard()
     if (m_trayMenuClipboardAction) {
         const QString format = tr("&Clipboard: %1", "Tray menu clipboard item format");
         const auto font = m_trayMenuClipboardAction->font();
-        const auto clipboardLabel = textLabelForData(m_clipboardData, font, format, true);
+        const auto clipboardLabel = cachedTextLabelForData(
+                    m_clipboardDataHash, m_clipboardData, font, format, true);
         m_trayMenuClipboardAction->setText(clipboardLabel);
     }
 
@@ -983,6 +1015,10 @@ void MainWindow::onBrowserCreated(ClipboardBrowser *browser)
              ui->searchBar, &Utils::FilterLineEdit::hide );
     connect( browser, &ClipboardBrowser::itemWidgetCreated,
              this, &MainWindow::onItemWidgetCreated );
+
+    // Check memory after the items are loaded.
+    if (m_options.memoryBudget > 0)
+        m_timerEnforceMemoryBudget.start();
 }
 
 void MainWindow::onItemSelectionChanged(const ClipboardBrowser *browser)
@@ -993,6 +1029,9 @@ void MainWindow::onItemSelectionChanged(const ClipboardBrowser *browser)
 
 void MainWindow::onItemsChanged(const ClipboardBrowser *browser)
 {
+    if ( m_options.memoryBudget > 0 && !m_timerEnforceMemoryBudget.isActive() )
+        m_timerEnforceMemoryBudget.start();
+
     if (browser == this->browser())
         updateContextMenu(contextMenuUpdateIntervalMsec);
     if (browser == getTabForTrayMenu())
@@ -1024,9 +1063,11 @@ void MainWindow::onItemWidgetCreated(const PersistentDisplayItem &item)
     if ( m_displayCommands.isEmpty() )
         return;
 
+    // Item widget cannot be replaced while it's being created
+    // so even cached display data are set later.
     m_displayItemList.append(item);
     if (!m_currentDisplayAction)
-        runDisplayCommands();
+        m_timerRunDisplayCommands.start();
 }
 
 void MainWindow::onDisplayActionFinished()
@@ -1055,16 +1096,39 @@ void MainWindow::onActionDialogAccepted(const Command &command, const QStringLis
 
 void MainWindow::runDisplayCommands()
 {
+    // Data of items in unloaded tabs are no longer valid.
+    clearHiddenDisplayData();
+    setCachedDisplayData();
     if ( m_displayItemList.isEmpty() )
         return;
 
     m_currentDisplayItem = m_displayItemList.takeFirst();
 
-    m_currentDisplayAction = runScript("runDisplayCommands()", m_currentDisplayItem.data());
+    m_currentDisplayAction = runScript(
+        "runDisplayCommands()", m_currentDisplayItem.data(), ActionPriority::Automatic);
     connect( m_currentDisplayAction.data(), &QObject::destroyed,
              this, &MainWindow::onDisplayActionFinished );
 }
 
+bool MainWindow::setCachedDisplayData(PersistentDisplayItem *item)
+{
+    const auto entry = m_displayDataCache.object( itemDataHash(item->data()) );
+    // Different items can have same hash.
+    if (entry == nullptr || entry->itemData != item->data())
+        return false;
+
+    item->setData(entry->displayData);
+    return true;
+}
+
+void MainWindow::setCachedDisplayData()
+{
+    for (int i = m_displayItemList.size() - 1; i >= 0; --i) {
+        if ( setCachedDisplayData(&m_displayItemList[i]) )
+            m_displayItemList.removeAt(i);
+    }
+}
+
 void MainWindow::clearHiddenDisplayData()
 {
     for (int i = m_displayItemList.size() - 1; i >= 0; --i) {
@@ -1095,10 +1159,19 @@ int MainWindow::findTabIndexExactMatch(const QString &name)
 void MainWindow::setClipboardData(const QVariantMap &data)
 {
     m_clipboardData = data;
+    m_clipboardDataHash = ::hash(data);
+    m_clipboardDataVerifier = labelDataVerifier(data);
     updateContextMenu(contextMenuUpdateIntervalMsec);
     updateTrayMenu();
 }
 
+uint MainWindow::labelDataHash(const QVariantMap &data) const
+{
+    if ( data.keys() == m_clipboardData.keys() && labelDataVerifier(data) == m_clipboardDataVerifier )
+        return m_clipboardDataHash;
+    return ::hash(data);
+}
+
 void MainWindow::setFilter(const QString &text)
 {
     ui->searchBar->setText(text);
@@ -1324,12 +1397,94 @@ void MainWindow::addMenuMatchCommand(MenuMatchCommands *menuMatchCommands, const
 
 void MainWindow::runMenuCommandFilters(MenuMatchCommands *menuMatchCommands, const QVariantMap &data)
 {
+    if ( menuMatchCommands->actions.isEmpty() )
+        return;
+
+    // Apply cached results and run only the remaining filters.
+    // Filters can also depend on current window so its title is part of the key.
+    menuMatchCommands->dataHash = itemDataHash(data);
+    if ( m_lastWindow && !data.contains(mimeWindowTitle) )
+        menuMatchCommands->dataHash = qHash( m_lastWindow->getTitle(), menuMatchCommands->dataHash );
+    bool updateShortcuts = false;
+    for (int i = menuMatchCommands->matchCommands.size() - 1; i >= 0; --i) {
+        bool enabled;
+        if ( !cachedMenuFilterResult(menuMatchCommands->matchCommands[i], menuMatchCommands->dataHash, &enabled) )
+            continue;
+
+        if ( applyMenuFilterResult(*menuMatchCommands, i, enabled) )
+            updateShortcuts = true;
+
+        menuMatchCommands->matchCommands.removeAt(i);
+        menuMatchCommands->actions.remove(i);
+    }
+
+    if (updateShortcuts)
+        updateActionShortcuts();
+
     if ( !menuMatchCommands->actions.isEmpty() ) {
-        const auto act = runScript("runMenuCommandFilters()", data);
+        const auto act = runScript("runMenuCommandFilters()", data, ActionPriority::Immediate);
         menuMatchCommands->actionId = act->id();
     }
 }
 
+bool MainWindow::applyMenuFilterResult(const MenuMatchCommands &menuMatchCommands, int index, bool enabled)
+{
+    auto action = menuMatchCommands.actions.value(index);
+    if (!action)
+        return false;
+
+    action->setEnabled(enabled);
+    action->setProperty(propertyActionFilterCommandFailed, !enabled);
+
+    const bool hasShortcuts = !action->shortcuts().isEmpty();
+
+    if ( !enabled && (&menuMatchCommands == &m_trayMenuMatchCommands || !m_menuItem->isVisible()) )
+        action->deleteLater();
+
+    return hasShortcuts;
+}
+
+bool MainWindow::cachedMenuFilterResult(const QString &matchCommand, uint dataHash, bool *enabled) const
+{
+    if ( m_options.menuFilterCacheMsec <= 0 )
+        return false;
+
+    const auto it = m_menuFilterCache.constFind( qMakePair(matchCommand, dataHash) );
+    if ( it == m_menuFilterCache.constEnd() )
+        return false;
+
+    if ( m_menuFilterCacheClock.elapsed() - it->timeMsec > m_options.menuFilterCacheMsec )
+        return false;
+
+    *enabled = it->enabled;
+    return true;
+}
+
+void MainWindow::cacheMenuFilterResult(const QString &matchCommand, uint dataHash, bool enabled)
+{
+    if ( m_options.menuFilterCacheMsec <= 0 )
+        return;
+
+    if ( !m_menuFilterCacheClock.isValid() )
+        m_menuFilterCacheClock.start();
+
+    const qint64 now = m_menuFilterCacheClock.elapsed();
+
+    if ( m_menuFilterCache.size() >= maxMenuFilterCacheSize ) {
+        for (auto it = m_menuFilterCache.begin(); it != m_menuFilterCache.end(); ) {
+            if ( now - it->timeMsec > m_options.menuFilterCacheMsec )
+                it = m_menuFilterCache.erase(it);
+            else
+                ++it;
+        }
+
+        if ( m_menuFilterCache.size() >= maxMenuFilterCacheSize )
+            m_menuFilterCache.clear();
+    }
+
+    m_menuFilterCache.insert( qMakePair(matchCommand, dataHash), MenuFilterResult{enabled, now} );
+}
+
 bool MainWindow::isItemMenuDefaultActionValid() const
 {
     const auto defaultAction = m_menuItem->defaultAction();
@@ -1491,32 +1646,44 @@ QAction *MainWindow::actionForMenuItem(int id, QWidget *parent, Qt::ShortcutCont
 void MainWindow::addMenuItems(TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText)
 {
     WidgetSizeGuard sizeGuard(menu);
-    menu->clearClipboardItems();
-
-    if (!c)
-        return;
 
-    const int current = c->currentIndex().row();
-    int itemCount = 0;
-    for ( int i = 0; i < c->length() && itemCount < maxItemCount; ++i ) {
-        const QModelIndex index = c->model()->index(i, 0);
-        if ( !searchText.isEmpty() ) {
-            const QString itemText = index.data(contentType::text).toString().toLower();
-            if ( !itemText.contains(searchText.toLower()) )
-                continue;
+    QModelIndexList indexes;
+    QModelIndex current;
+    if (c) {
+        current = c->currentIndex();
+        for ( int i = 0; i < c->length() && indexes.size() < maxItemCount; ++i ) {
+            const QModelIndex index = c->model()->index(i, 0);
+            if ( !searchText.isEmpty() ) {
+                // Skip decoding text of items which are too short to match.
+                if ( index.data(contentType::textLength).toInt() < searchText.size() )
+                    continue;
+                const QString itemText = index.data(contentType::text).toString().toLower();
+                if ( !itemText.contains(searchText.toLower()) )
+                    continue;
+            }
+            indexes.append(index);
         }
-        menu->addClipboardItemAction(index, m_options.trayImages, i == current);
-        ++itemCount;
     }
+
+    menu->setClipboardItems(indexes, m_options.trayImages, current);
 }
 
-void MainWindow::activateMenuItem(ClipboardBrowser *c, const QVariantMap &data, bool omitPaste)
+void MainWindow::activateMenuItem(ClipboardBrowser *c, uint itemHash, bool omitPaste)
 {
-    if ( m_sharedData->moveItemOnReturnKey ) {
-        const auto itemHash = ::hash(data);
-        c->moveToTop(itemHash);
+    if (!c)
+        return;
+
+    const QModelIndex index = c->findItem(itemHash);
+    if ( !index.isValid() ) {
+        COPYQ_LOG("Menu item is no longer available");
+        return;
     }
 
+    const QVariantMap data = index.data(contentType::data).toMap();
+
+    if ( m_sharedData->moveItemOnReturnKey )
+        c->moveToTop(itemHash);
+
     if ( QGuiApplication::queryKeyboardModifiers().testFlag(Qt::ShiftModifier) )
         m_clipboardManager.setClipboard( createDataMap(mimeText, data.value(mimeText) ) );
     else
@@ -1840,10 +2007,13 @@ void MainWindow::updateCommands(QVector<Command> allCommands, bool forceSave)
 
     if (m_displayCommands != displayCommands) {
         m_displayItemList.clear();
+        m_displayDataCache.clear();
         m_displayCommands = displayCommands;
         reloadBrowsers();
     }
 
+    m_menuFilterCache.clear();
+
     updateContextMenu(contextMenuUpdateIntervalMsec);
     if (m_options.trayCommands)
         updateTrayMenu();
@@ -1871,13 +2041,12 @@ const Theme &MainWindow::theme() const
     return m_sharedData->theme;
 }
 
-Action *MainWindow::runScript(const QString &script, const QVariantMap &data)
+Action *MainWindow::runScript(const QString &script, const QVariantMap &data, ActionPriority priority)
 {
     auto act = new Action();
     act->setCommand(QStringList() << "copyq" << "eval" << "--" << script);
     act->setData(data);
-    runInternalAction(act);
-    return act;
+    return runInternalAction(act, priority);
 }
 
 int MainWindow::findTabIndex(const QString &name)
@@ -2178,6 +2347,10 @@ void MainWindow::loadSettings()
     m_sharedData->showSimpleItems = appConfig.option<Config::show_simple_items>();
     m_sharedData->minutesToExpire = appConfig.option<Config::expire_tab>();
 
+    m_options.memoryBudget = 1024 * 1024 * static_cast<qint64>( appConfig.option<Config::memory_budget>() );
+    m_options.menuFilterCacheMsec = appConfig.option<Config::menu_filter_cache_ttl>();
+    m_actionHandler->setMaxRunningActions( appConfig.option<Config::max_running_commands>() );
+
     reloadBrowsers();
 
     // create tabs
@@ -2331,14 +2504,14 @@ bool MainWindow::setCurrentTab(int index)
     return true;
 }
 
-void MainWindow::onMenuActionTriggered(const QVariantMap &data, bool omitPaste)
+void MainWindow::onMenuActionTriggered(uint itemHash, bool omitPaste)
 {
-    activateMenuItem( getTabForMenu(), data, omitPaste );
+    activateMenuItem( getTabForMenu(), itemHash, omitPaste );
 }
 
-void MainWindow::onTrayActionTriggered(const QVariantMap &data, bool omitPaste)
+void MainWindow::onTrayActionTriggered(uint itemHash, bool omitPaste)
 {
-    activateMenuItem( getTabForTrayMenu(), data, omitPaste );
+    activateMenuItem( getTabForTrayMenu(), itemHash, omitPaste );
 }
 
 void MainWindow::trayActivated(QSystemTrayIcon::ActivationReason reason)
@@ -2607,7 +2780,7 @@ QStringList MainWindow::menuItemMatchCommands(int actionId)
     return QStringList();
 }
 
-bool MainWindow::setMenuItemEnabled(int actionId, int menuItemMatchCommandIndex, bool enabled)
+bool MainWindow::setMenuItemsEnabled(int actionId, const QVector<int> &enabled)
 {
     if (actionId != m_trayMenuMatchCommands.actionId && actionId != m_itemMenuMatchCommands.actionId)
         return false;
@@ -2616,22 +2789,16 @@ bool MainWindow::setMenuItemEnabled(int actionId, int menuItemMatchCommandIndex,
             ? m_trayMenuMatchCommands
             : m_itemMenuMatchCommands;
 
-    if (menuMatchCommands.actions.size() <= menuItemMatchCommandIndex)
-        return false;
-
-    auto action = menuMatchCommands.actions[menuItemMatchCommandIndex];
-    if (!action)
-        return true;
-
-    action->setEnabled(enabled);
-    action->setProperty(propertyActionFilterCommandFailed, !enabled);
-
-    const auto shortcuts = action->shortcuts();
-
-    if ( !enabled && (actionId == m_trayMenuMatchCommands.actionId || !m_menuItem->isVisible()) )
-        action->deleteLater();
+    const int count = qMin( enabled.size(), menuMatchCommands.actions.size() );
+    bool updateShortcuts = false;
+    for (int i = 0; i < count; ++i) {
+        const bool isEnabled = enabled[i] != 0;
+        cacheMenuFilterResult(menuMatchCommands.matchCommands[i], menuMatchCommands.dataHash, isEnabled);
+        if ( applyMenuFilterResult(menuMatchCommands, i, isEnabled) )
+            updateShortcuts = true;
+    }
 
-    if ( !shortcuts.isEmpty() )
+    if (updateShortcuts)
         updateActionShortcuts();
 
     return true;
@@ -2643,8 +2810,16 @@ QVariantMap MainWindow::setDisplayData(int actionId, const QVariantMap &data)
         return QVariantMap();
 
     m_currentDisplayItem.setData(data);
+    // Data of items in unloaded tabs are no longer valid.
+    if ( !data.isEmpty() && m_currentDisplayItem.isValid() ) {
+        const QVariantMap itemData = detachedMappedData( m_currentDisplayItem.data() );
+        m_displayDataCache.insert(
+            itemDataHash(itemData), new DisplayDataCacheEntry{itemData, data},
+            displayDataCost(itemData) + displayDataCost(data) );
+    }
 
     clearHiddenDisplayData();
+    setCachedDisplayData();
 
     if ( m_displayItemList.isEmpty() )
         return QVariantMap();
@@ -2754,7 +2929,7 @@ void MainWindow::disableClipboardStoring(bool disable)
     updateIconSnip();
 
     if (m_clipboardStoringDisabled)
-        runScript("setTitle(); showDataNotification()");
+        runScript("setTitle(); showDataNotification()", QVariantMap(), ActionPriority::Background);
 
     COPYQ_LOG( QString("Clipboard monitoring %1.")
                .arg(m_clipboardStoringDisabled ? "disabled" : "enabled") );
@@ -3197,6 +3372,64 @@ bool MainWindow::exportData()
     return true;
 }
 
+void MainWindow::enforceMemoryBudget()
+{
+    if (m_options.memoryBudget <= 0)
+        return;
+
+    // Tabs receiving new clipboard content or shown in tray menu would be
+    // loaded again on next clipboard change.
+    QStringList keptTabs(m_options.clipboardTab);
+    const auto currentPlaceholder = getPlaceholder();
+    if (m_options.trayCurrentTab && currentPlaceholder)
+        keptTabs.append( currentPlaceholder->tabName() );
+    else if ( !m_options.trayTabName.isEmpty() )
+        keptTabs.append(m_options.trayTabName);
+
+    qint64 memoryUsage = 0;
+    QList<ClipboardBrowserPlaceholder*> placeholders;
+    for( int i = 0; i < ui->tabWidget->count(); ++i ) {
+        const auto placeholder = getPlaceholder(i);
+        const auto c = placeholder->browser();
+        if (c) {
+            memoryUsage += c->memoryUsage();
+            if ( placeholder->canExpire() && !keptTabs.contains(placeholder->tabName()) )
+                placeholders.append(placeholder);
+        }
+    }
+
+    if ( memoryUsage <= m_options.memoryBudget || placeholders.isEmpty() )
+        return;
+
+    std::sort( placeholders.begin(), placeholders.end(),
+        [](const ClipboardBrowserPlaceholder *lhs, const ClipboardBrowserPlaceholder *rhs) {
+            return lhs->lastActivity() < rhs->lastActivity();
+        });
+
+    for (const auto placeholder : placeholders) {
+        const qint64 tabMemoryUsage = placeholder->browser()->memoryUsage();
+        COPYQ_LOG( QString("Tab \"%1\": Unloading to free %2 KiB (memory budget exceeded)")
+                   .arg(placeholder->tabName())
+                   .arg(tabMemoryUsage / 1024) );
+        placeholder->expire();
+
+        memoryUsage -= tabMemoryUsage;
+        if (memoryUsage <= m_options.memoryBudget)
+            return;
+    }
+}
+
+QList<ClipboardBrowser*> MainWindow::loadedBrowsers() const
+{
+    QList<ClipboardBrowser*> browsers;
+    for( int i = 0; i < ui->tabWidget->count(); ++i ) {
+        auto c = getPlaceholder(i)->browser();
+        if ( c && c->isLoaded() )
+            browsers.append(c);
+    }
+    return browsers;
+}
+
 void MainWindow::saveTabs()
 {
     for( int i = 0; i < ui->tabWidget->count(); ++i ) {
@@ -3332,9 +3565,9 @@ Action *MainWindow::action(const QVariantMap &data, const Command &cmd, const QM
     return nullptr;
 }
 
-void MainWindow::runInternalAction(Action *action)
+Action *MainWindow::runInternalAction(Action *action, ActionPriority priority)
 {
-    m_actionHandler->internalAction(action);
+    return m_actionHandler->internalAction(action, priority);
 }
 
 bool MainWindow::isInternalActionId(int id) const
@@ -21,6 +21,8 @@
 #define MAINWINDOW_H
 
 #include "app/clipboardmanager.h"
+#include "app/clipboardsnapshot.h"
+#include "common/actionhandlerenums.h"
 #include "common/clipboardmode.h"
 #include "common/command.h"
 #include "gui/clipboardbrowsershared.h"
@@ -29,6 +31,9 @@
 
 #include "platform/platformnativeinterface.h"
 
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMainWindow>
 #include <QModelIndex>
 #include <QPointer>
@@ -49,6 +54,7 @@ class Notification;
 class NotificationDaemon;
 class QAction;
 class QMimeData;
+class ScriptableProxy;
 class Theme;
 class TrayMenu;
 struct MainWindowOptions;
@@ -104,6 +110,12 @@ struct MainWindowOptions {
     bool trayItemPaste = true;
 
     QString clipboardTab;
+
+    /// Maximum memory for items in all tabs in bytes (0 for no limit).
+    qint64 memoryBudget = 0;
+
+    /// Time in milliseconds to reuse results of menu command filters (0 to disable).
+    int menuFilterCacheMsec = 0;
 };
 
 /**
@@ -156,6 +168,9 @@ public:
     /** Return browser containing item or nullptr. */
     ClipboardBrowser *browserForItem(const QModelIndex &index);
 
+    /** Return browser widgets of tabs with loaded items. */
+    QList<ClipboardBrowser*> loadedBrowsers() const;
+
     /**
      * Find tab with given @a name.
      * @return found tab index or -1
@@ -268,7 +283,8 @@ public:
     void setTrayTooltip(const QString &tooltip);
 
     QStringList menuItemMatchCommands(int actionId);
-    bool setMenuItemEnabled(int actionId, int menuItemMatchCommandIndex, bool enabled);
+    /// Enables menu items for non-zero filter results (in order of menuItemMatchCommands()).
+    bool setMenuItemsEnabled(int actionId, const QVector<int> &enabled);
 
     QVariantMap setDisplayData(int actionId, const QVariantMap &data);
 
@@ -352,7 +368,7 @@ public:
             const Command &cmd,
             const QModelIndex &outputIndex);
 
-    void runInternalAction(Action *action);
+    Action *runInternalAction(Action *action, ActionPriority priority = ActionPriority::Immediate);
     bool isInternalActionId(int id) const;
 
     void setClipboard(const QVariantMap &data, ClipboardMode mode);
@@ -401,6 +417,20 @@ public:
 
     void setClipboardData(const QVariantMap &data);
 
+    /**
+     * Return hash of data for label cache.
+     *
+     * Hash of current clipboard is computed only once when clipboard changes
+     * and reused if @a data have the same size and beginning of text.
+     */
+    uint labelDataHash(const QVariantMap &data) const;
+
+    /// Last known clipboard and selection data.
+    ClipboardSnapshot *clipboardSnapshot() { return &m_clipboardSnapshot; }
+
+    void setClipboardProvider(ScriptableProxy *provider) { m_clipboardManager.setProvider(provider); }
+    void unsetClipboardProvider(ScriptableProxy *provider) { m_clipboardManager.unsetProvider(provider); }
+
     /** Set text for filtering items. */
     void setFilter(const QString &text);
     QString filter() const;
@@ -439,12 +469,15 @@ private:
     void filterMenuItems(const QString &searchText);
     void filterTrayMenuItems(const QString &searchText);
     void trayActivated(QSystemTrayIcon::ActivationReason reason);
-    void onMenuActionTriggered(const QVariantMap &data, bool omitPaste);
-    void onTrayActionTriggered(const QVariantMap &data, bool omitPaste);
+    void onMenuActionTriggered(uint itemHash, bool omitPaste);
+    void onTrayActionTriggered(uint itemHash, bool omitPaste);
     void findNextOrPrevious();
     void tabChanged(int current, int previous);
     void saveTabPositions();
     void doSaveTabPositions();
+
+    /// Unloads least recently used tabs if items use more memory than allowed.
+    void enforceMemoryBudget();
     void tabsMoved(const QString &oldPrefix, const QString &newPrefix);
     void tabBarMenuRequested(QPoint pos, int tab);
     void tabTreeMenuRequested(QPoint pos, const QString &groupPath);
@@ -523,12 +556,31 @@ private:
         QStringList matchCommands;
         QVector< QPointer<QAction> > actions;
         QMenu *menu = nullptr;
+        uint dataHash = 0;
+    };
+
+    struct MenuFilterResult {
+        bool enabled;
+        qint64 timeMsec;
+    };
+
+    struct DisplayDataCacheEntry {
+        /// Item data passed to display commands (compared on cache hit).
+        QVariantMap itemData;
+        /// Result of display commands.
+        QVariantMap displayData;
     };
 
     void runDisplayCommands();
 
     void clearHiddenDisplayData();
 
+    /// Sets display data from cache if available.
+    bool setCachedDisplayData(PersistentDisplayItem *item);
+
+    /// Sets display data from cache for all pending items.
+    void setCachedDisplayData();
+
     void reloadBrowsers();
 
     ClipboardBrowserPlaceholder *createTab(const QString &name, TabNameMatching nameMatch);
@@ -590,6 +642,12 @@ private:
     void addMenuMatchCommand(MenuMatchCommands *menuMatchCommands, const QString &matchCommand, QAction *act);
     void runMenuCommandFilters(MenuMatchCommands *menuMatchCommands, const QVariantMap &data);
 
+    /// Enables or disables menu item, returns true if the item has shortcuts.
+    bool applyMenuFilterResult(const MenuMatchCommands &menuMatchCommands, int index, bool enabled);
+
+    bool cachedMenuFilterResult(const QString &matchCommand, uint dataHash, bool *enabled) const;
+    void cacheMenuFilterResult(const QString &matchCommand, uint dataHash, bool enabled);
+
     bool isItemMenuDefaultActionValid() const;
 
     void updateToolBar();
@@ -607,7 +665,7 @@ private:
     QAction *actionForMenuItem(int id, QWidget *parent, Qt::ShortcutContext context);
 
     void addMenuItems(TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText);
-    void activateMenuItem(ClipboardBrowser *c, const QVariantMap &data, bool omitPaste);
+    void activateMenuItem(ClipboardBrowser *c, uint itemHash, bool omitPaste);
     bool toggleMenu(TrayMenu *menu, QPoint pos);
     bool toggleMenu(TrayMenu *menu);
 
@@ -617,7 +675,7 @@ private:
 
     const Theme &theme() const;
 
-    Action *runScript(const QString &script, const QVariantMap &data = QVariantMap());
+    Action *runScript(const QString &script, const QVariantMap &data, ActionPriority priority);
 
     void activateCurrentItemHelper();
 
@@ -652,12 +710,16 @@ private:
     QTimer m_timerSaveTabPositions;
     QTimer m_timerHideWindowIfNotActive;
     QTimer m_timerRaiseLastWindowAfterMenuClosed;
+    QTimer m_timerEnforceMemoryBudget;
+    QTimer m_timerRunDisplayCommands;
 
     NotificationDaemon *m_notifications;
 
     ActionHandler *m_actionHandler;
 
     QVariantMap m_clipboardData;
+    uint m_clipboardDataHash = 0;
+    QByteArray m_clipboardDataVerifier;
 
     TrayMenu *m_menu;
     QString m_menuTabName;
@@ -681,10 +743,18 @@ private:
     PersistentDisplayItem m_currentDisplayItem;
     QPointer<Action> m_currentDisplayAction;
 
+    /// Results of display commands for item data (cost is size in KiB).
+    QCache<uint, DisplayDataCacheEntry> m_displayDataCache;
+
     MenuMatchCommands m_trayMenuMatchCommands;
     MenuMatchCommands m_itemMenuMatchCommands;
 
+    /// Results of menu command filters for command and data hash.
+    QHash<QPair<QString, uint>, MenuFilterResult> m_menuFilterCache;
+    QElapsedTimer m_menuFilterCacheClock;
+
     ClipboardManager m_clipboardManager;
+    ClipboardSnapshot m_clipboardSnapshot;
 
     bool m_isActiveWindow = false;
 };
@@ -22,7 +22,7 @@
 #include "common/contenttype.h"
 #include "common/common.h"
 #include "common/display.h"
-#include "common/textdata.h"
+#include "common/mimetypes.h"
 #include "common/timer.h"
 #include "gui/icons.h"
 #include "gui/iconfactory.h"
@@ -31,12 +31,27 @@
 #include <QApplication>
 #include <QKeyEvent>
 #include <QModelIndex>
+#include <QMultiHash>
 #include <QPixmap>
 
 namespace {
 
 const QIcon iconClipboard() { return getIcon("clipboard", IconPaste); }
 
+/// Returns hash of item text without decoding it (zero if there is no text).
+uint textHash(const QVariantMap &data)
+{
+    for (const auto &mime : {mimeText, mimeUriList}) {
+        const auto it = data.find(mime);
+        if ( it != data.constEnd() ) {
+            const QByteArray bytes = it->toByteArray();
+            return bytes.isEmpty() ? 0 : qHash(bytes);
+        }
+    }
+
+    return 0;
+}
+
 bool canActivate(const QAction &action)
 {
     return !action.isSeparator() && action.isEnabled();
@@ -72,6 +87,7 @@ TrayMenu::TrayMenu(QWidget *parent)
     , m_clipboardItemActionsSeparator()
     , m_customActionsSeparator()
     , m_clipboardItemActionCount(0)
+    , m_showImages(false)
     , m_omitPaste(false)
     , m_viMode(false)
     , m_numberSearch(false)
@@ -79,79 +95,83 @@ TrayMenu::TrayMenu(QWidget *parent)
     initSingleShotTimer( &m_timerUpdateActiveAction, 0, this, &TrayMenu::updateActiveAction );
 }
 
-void TrayMenu::addClipboardItemAction(const QModelIndex &index, bool showImages, bool isCurrent)
+void TrayMenu::setClipboardItems(
+        const QModelIndexList &indexes, bool showImages, const QModelIndex &current)
 {
     resetSeparators();
 
     // Show search text at top of the menu.
-    if ( m_clipboardItemActionCount == 0 && m_searchText.isEmpty() )
+    if ( !m_searchText.isEmpty() )
+        setSearchMenuItem(m_searchText);
+    else if ( !indexes.isEmpty() )
         setSearchMenuItem( m_viMode ? tr("Press '/' to search") : tr("Type to search") );
 
-    const QVariantMap data = index.data(contentType::data).toMap();
-    QAction *act = addAction(QString());
-
-    act->setData(index.data(contentType::data));
-
-    insertAction(m_clipboardItemActionsSeparator, act);
-
-    QString format;
+    // Item icons need to be recreated if the image option changes.
+    const bool reuseActions = m_showImages == showImages;
+    m_showImages = showImages;
 
-    // Add number key hint.
-    if (m_clipboardItemActionCount < 10) {
-        format = tr("&%1. %2",
-                    "Key hint (number shortcut) for items in tray menu (%1 is number, %2 is item label)")
-                .arg(m_clipboardItemActionCount);
+    QMultiHash<uint, ClipboardItemAction> unusedActions;
+    for (const auto &itemAction : m_clipboardItemActions) {
+        if ( !itemAction.action.isNull() )
+            unusedActions.insert(reuseActions ? itemAction.itemHash : 0, itemAction);
     }
 
-    m_clipboardItemActionCount++;
-
-    const QString label = textLabelForData( data, act->font(), format, true );
-    act->setText(label);
-
-    // Menu item icon from image.
-    if (showImages) {
-        const QStringList formats = data.keys();
-        const int imageIndex = formats.indexOf( QRegExp("^image/.*") );
-        if (imageIndex != -1) {
-            const auto &mime = formats[imageIndex];
-            QPixmap pix;
-            pix.loadFromData( data.value(mime).toByteArray(), mime.toLatin1().data() );
-            const int iconSize = smallIconSize();
-            int x = 0;
-            int y = 0;
-            if (pix.width() > pix.height()) {
-                pix = pix.scaledToHeight(iconSize);
-                x = (pix.width() - iconSize) / 2;
-            } else {
-                pix = pix.scaledToWidth(iconSize);
-                y = (pix.height() - iconSize) / 2;
+    std::vector<ClipboardItemAction> itemActions;
+    itemActions.reserve( static_cast<size_t>(indexes.size()) );
+    QAction *currentAction = nullptr;
+
+    for (const auto &index : indexes) {
+        const uint itemHash = index.data(contentType::hash).toUInt();
+        const int row = static_cast<int>( itemActions.size() );
+        const int keyHint = row < 10 ? row : -1;
+
+        const auto it = reuseActions ? unusedActions.find(itemHash) : unusedActions.end();
+        if ( it == unusedActions.end() ) {
+            itemActions.push_back( createClipboardItemAction(index, itemHash, keyHint, showImages) );
+        } else {
+            auto itemAction = it.value();
+            unusedActions.erase(it);
+            if (itemAction.keyHint != keyHint) {
+                const QVariantMap data = index.data(contentType::data).toMap();
+                setClipboardItemActionLabel(&itemAction, index, data, keyHint);
             }
-            pix = pix.copy(x, y, iconSize, iconSize);
-            act->setIcon(pix);
+            itemActions.push_back(itemAction);
         }
-    }
 
-    connect(act, &QAction::triggered, this, &TrayMenu::onClipboardItemActionTriggered);
-
-    if (isCurrent)
-        setActiveAction(act);
-}
+        if (index == current)
+            currentAction = itemActions.back().action;
+    }
 
-void TrayMenu::clearClipboardItems()
-{
-    resetSeparators();
+    for (const auto &itemAction : unusedActions) {
+        removeAction(itemAction.action);
+        itemAction.action->deleteLater();
+    }
 
+    // Move or insert only actions which are not already at correct position.
+    QList<QAction*> menuItemActions;
     for ( auto action : actions() ) {
-        if (action->isSeparator())
+        if (action == m_clipboardItemActionsSeparator)
             break;
         if (action != m_searchAction)
-            removeAction(action);
+            menuItemActions.append(action);
     }
-    m_clipboardItemActionCount = 0;
 
-    // Show search text at top of the menu.
-    if ( !m_searchText.isEmpty() )
-        setSearchMenuItem(m_searchText);
+    size_t i = 0;
+    while ( i < itemActions.size()
+            && static_cast<int>(i) < menuItemActions.size()
+            && menuItemActions[static_cast<int>(i)] == itemActions[i].action )
+    {
+        ++i;
+    }
+
+    for ( ; i < itemActions.size(); ++i )
+        insertAction(m_clipboardItemActionsSeparator, itemActions[i].action);
+
+    m_clipboardItemActions = std::move(itemActions);
+    m_clipboardItemActionCount = static_cast<int>( m_clipboardItemActions.size() );
+
+    if (currentAction)
+        setActiveAction(currentAction);
 }
 
 void TrayMenu::addCustomAction(QAction *action)
@@ -162,6 +182,12 @@ void TrayMenu::addCustomAction(QAction *action)
 
 void TrayMenu::clearAllActions()
 {
+    // Keep clipboard item actions (owned by the menu) from being deleted.
+    for (const auto &itemAction : m_clipboardItemActions) {
+        if ( !itemAction.action.isNull() )
+            removeAction(itemAction.action);
+    }
+
     clear();
     m_clipboardItemActionCount = 0;
     m_searchText.clear();
@@ -305,13 +331,12 @@ void TrayMenu::search(const QString &text)
 
 void TrayMenu::markItemInClipboard(const QVariantMap &clipboardData)
 {
-    const auto text = getTextData(clipboardData);
+    const auto clipboardTextHash = textHash(clipboardData);
 
-    for ( auto action : actions() ) {
-        const auto actionData = action->data().toMap();
-        const auto itemText = getTextData(actionData);
-        if ( !itemText.isEmpty() ) {
-            const auto hideIcon = itemText != text;
+    for (const auto &itemAction : m_clipboardItemActions) {
+        QAction *action = itemAction.action;
+        if ( action && itemAction.textHash != 0 ) {
+            const auto hideIcon = itemAction.textHash != clipboardTextHash;
             const auto isIconHidden = action->icon().isNull();
             if ( isIconHidden != hideIcon )
                 action->setIcon(hideIcon ? QIcon() : iconClipboard());
@@ -333,13 +358,79 @@ void TrayMenu::setSearchMenuItem(const QString &text)
     }
 }
 
+TrayMenu::ClipboardItemAction TrayMenu::createClipboardItemAction(
+        const QModelIndex &index, uint itemHash, int keyHint, bool showImages)
+{
+    const QVariantMap data = index.data(contentType::data).toMap();
+
+    // Action keeps only item hash; item data are looked up when triggered.
+    QAction *act = new QAction(this);
+    act->setData(itemHash);
+
+    ClipboardItemAction itemAction;
+    itemAction.action = act;
+    itemAction.itemHash = itemHash;
+
+    itemAction.textHash = textHash(data);
+
+    setClipboardItemActionLabel(&itemAction, index, data, keyHint);
+
+    // Menu item icon from image.
+    if (showImages) {
+        const QStringList formats = data.keys();
+        const int imageIndex = formats.indexOf( QRegExp("^image/.*") );
+        if (imageIndex != -1) {
+            const auto &mime = formats[imageIndex];
+            QPixmap pix;
+            pix.loadFromData( data.value(mime).toByteArray(), mime.toLatin1().data() );
+            const int iconSize = smallIconSize();
+            int x = 0;
+            int y = 0;
+            if (pix.width() > pix.height()) {
+                pix = pix.scaledToHeight(iconSize);
+                x = (pix.width() - iconSize) / 2;
+            } else {
+                pix = pix.scaledToWidth(iconSize);
+                y = (pix.height() - iconSize) / 2;
+            }
+            pix = pix.copy(x, y, iconSize, iconSize);
+            act->setIcon(pix);
+        }
+    }
+
+    connect(act, &QAction::triggered, this, &TrayMenu::onClipboardItemActionTriggered);
+
+    return itemAction;
+}
+
+void TrayMenu::setClipboardItemActionLabel(
+        ClipboardItemAction *itemAction, const QModelIndex &index, const QVariantMap &data,
+        int keyHint)
+{
+    QString format;
+
+    // Add number key hint.
+    if (keyHint != -1) {
+        format = tr("&%1. %2",
+                    "Key hint (number shortcut) for items in tray menu (%1 is number, %2 is item label)")
+                .arg(keyHint);
+    }
+
+    QAction *act = itemAction->action;
+    // Line count is stored with item so the whole text is not scanned.
+    const int lineCount = index.data(contentType::textLineCount).toInt();
+    const QString label = cachedTextLabelForData(
+                itemAction->itemHash, data, act->font(), format, true, -1, 1, lineCount);
+    act->setText(label);
+    itemAction->keyHint = keyHint;
+}
+
 void TrayMenu::onClipboardItemActionTriggered()
 {
     QAction *act = qobject_cast<QAction *>(sender());
     Q_ASSERT(act != nullptr);
 
-    const auto actionData = act->data().toMap();
-    emit clipboardItemActionTriggered(actionData, m_omitPaste);
+    emit clipboardItemActionTriggered(act->data().toUInt(), m_omitPaste);
     close();
 }
 
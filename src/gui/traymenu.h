@@ -21,11 +21,13 @@
 #define TRAYMENU_H
 
 #include <QMenu>
+#include <QModelIndex>
 #include <QPointer>
 #include <QTimer>
 
+#include <vector>
+
 class QAction;
-class QModelIndex;
 
 class TrayMenu : public QMenu
 {
@@ -34,18 +36,25 @@ public:
     explicit TrayMenu(QWidget *parent = nullptr);
 
     /**
-     * Add clipboard item action with number key hint.
+     * Set clipboard item actions with number key hints.
+     *
+     * Actions are identified by item hash so only actions for new items are
+     * created and only removed items are deleted. Existing actions are
+     * relabeled only if their number key hint changes.
      *
-     * Triggering this action emits clipboardItemActionTriggered() signal.
+     * Triggering these actions emits clipboardItemActionTriggered() signal.
      */
-    void addClipboardItemAction(const QModelIndex &index, bool showImages, bool isCurrent);
-
-    void clearClipboardItems();
+    void setClipboardItems(const QModelIndexList &indexes, bool showImages, const QModelIndex &current);
 
     /** Add custom action. */
     void addCustomAction(QAction *action);
 
-    /** Clear clipboard item actions and curstom actions. */
+    /**
+     * Clear custom actions.
+     *
+     * Clipboard item actions are only detached from menu so they can be
+     * reused in next setClipboardItems() call.
+     */
     void clearAllActions();
 
     /** Handle Vi shortcuts. */
@@ -61,7 +70,7 @@ public:
 
 signals:
     /** Emitted if numbered action triggered. */
-    void clipboardItemActionTriggered(const QVariantMap &itemData, bool omitPaste);
+    void clipboardItemActionTriggered(uint itemHash, bool omitPaste);
 
     void searchRequest(const QString &text);
 
@@ -76,6 +85,22 @@ protected:
     void leaveEvent(QEvent *event) override;
 
 private:
+    struct ClipboardItemAction {
+        QPointer<QAction> action;
+        uint itemHash;
+        /// Hash of item text (zero if item has no text).
+        uint textHash;
+        /// Number key hint in label (-1 if none).
+        int keyHint;
+    };
+
+    ClipboardItemAction createClipboardItemAction(
+            const QModelIndex &index, uint itemHash, int keyHint, bool showImages);
+
+    void setClipboardItemActionLabel(
+            ClipboardItemAction *itemAction, const QModelIndex &index, const QVariantMap &data,
+            int keyHint);
+
     void onClipboardItemActionTriggered();
 
     void updateActiveAction();
@@ -86,7 +111,9 @@ private:
     QPointer<QAction> m_clipboardItemActionsSeparator;
     QPointer<QAction> m_customActionsSeparator;
     QPointer<QAction> m_searchAction;
+    std::vector<ClipboardItemAction> m_clipboardItemActions;
     int m_clipboardItemActionCount;
+    bool m_showImages;
 
     bool m_omitPaste;
     bool m_viMode;
@@ -30,28 +30,67 @@
 #include <QStringList>
 #include <QVariant>
 
+#include <algorithm>
+
 namespace {
 
-void clearDataExceptInternal(QVariantMap *data)
+/// Atoms for formats used in hot paths (interned once).
+struct KnownAtoms {
+    MimeAtom text = mimeAtom(mimeText);
+    MimeAtom html = mimeAtom(mimeHtml);
+    MimeAtom uriList = mimeAtom(mimeUriList);
+    MimeAtom windowTitle = mimeAtom(mimeWindowTitle);
+    MimeAtom owner = mimeAtom(mimeOwner);
+    MimeAtom clipboardMode = mimeAtom(mimeClipboardMode);
+    MimeAtom notes = mimeAtom(mimeItemNotes);
+    MimeAtom color = mimeAtom(mimeColor);
+    MimeAtom hidden = mimeAtom(mimeHidden);
+};
+
+const KnownAtoms &knownAtoms()
 {
-    for ( const auto &format : data->keys() ) {
-        if ( !format.startsWith(COPYQ_MIME_PREFIX) )
-            data->remove(format);
-    }
+    static const KnownAtoms atoms;
+    return atoms;
+}
+
+/// Returns MIME type to keep with format if it's not interned.
+QString uninternedMime(MimeAtom atom, const QString &mime)
+{
+    return isInternedMimeAtom(atom) ? QString() : mime;
+}
+
+/// Returns atom for looking up format without interning new MIME type.
+MimeAtom findFormatAtom(const QString &mime)
+{
+    const MimeAtom atom = findMimeAtom(mime);
+    return atom != 0 ? atom : uninternedMimeAtom(mime);
+}
+
+template <typename Format>
+bool formatLessThan(const Format &format, MimeAtom atom, const QString &mime)
+{
+    return format.atom < atom || (format.atom == atom && format.mime < mime);
 }
 
 } // namespace
 
 ClipboardItem::ClipboardItem()
-    : m_data()
+    : m_formats()
     , m_hash(0)
+    , m_dataSize(-1)
+    , m_mappedDataSize(-1)
+    , m_textMetadata()
 {
 }
 
 ClipboardItem::ClipboardItem(const QVariantMap &data)
-    : m_data(data)
+    : m_formats()
     , m_hash(0)
+    , m_dataSize(-1)
+    , m_mappedDataSize(-1)
+    , m_textMetadata()
 {
+    setData(data);
 }
 
 bool ClipboardItem::operator ==(const ClipboardItem &item) const
@@ -61,47 +100,57 @@ bool ClipboardItem::operator ==(const ClipboardItem &item) const
 
 void ClipboardItem::setText(const QString &text)
 {
-    for ( const auto &format : m_data.keys() ) {
-        if ( format.startsWith("text/") )
-            m_data.remove(format);
-    }
+    const auto isText = [](const Format &format) { return isTextMimeAtom(format.atom); };
+    m_formats.erase(
+        std::remove_if(std::begin(m_formats), std::end(m_formats), isText),
+        std::end(m_formats) );
 
-    setTextData(&m_data, text);
+    setFormat( knownAtoms().text, QString(), text.toUtf8() );
 
     invalidateDataHash();
 }
 
 bool ClipboardItem::setData(const QVariantMap &data)
 {
-    if (m_data == data)
+    if ( hasSameData(data) )
         return false;
 
-    m_data = data;
+    m_formats.clear();
+    m_formats.reserve( static_cast<size_t>(data.size()) );
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        const MimeAtom atom = mimeAtom(it.key());
+        m_formats.push_back( Format{atom, uninternedMime(atom, it.key()), it.value().toByteArray()} );
+    }
+
+    std::sort( std::begin(m_formats), std::end(m_formats),
+               [](const Format &lhs, const Format &rhs) { return formatLessThan(lhs, rhs.atom, rhs.mime); } );
+
     invalidateDataHash();
     return true;
 }
 
 bool ClipboardItem::updateData(const QVariantMap &data)
 {
-    const int oldSize = m_data.size();
-    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        const auto &format = it.key();
-        if ( !format.startsWith(COPYQ_MIME_PREFIX) ) {
-            clearDataExceptInternal(&m_data);
-            break;
-        }
-    }
+    bool changed = false;
 
-    bool changed = (oldSize != m_data.size());
+    std::vector<MimeAtom> atoms;
+    atoms.reserve( static_cast<size_t>(data.size()) );
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it)
+        atoms.push_back( mimeAtom(it.key()) );
 
-    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        const auto &format = it.key();
+    const bool hasUserFormats = std::any_of(
+        std::begin(atoms), std::end(atoms), isUserMimeAtom );
+    if (hasUserFormats)
+        changed = removeUserFormats();
+
+    auto atom = std::begin(atoms);
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it, ++atom) {
         const auto &value = it.value();
+        const auto mime = uninternedMime(*atom, it.key());
         if ( !value.isValid() ) {
-            m_data.remove(format);
-            changed = true;
-        } else if ( m_data.value(format) != value ) {
-            m_data.insert(format, value);
+            if ( removeFormat(*atom, mime) )
+                changed = true;
+        } else if ( setFormat(*atom, mime, value.toByteArray()) ) {
             changed = true;
         }
     }
@@ -113,8 +162,9 @@ bool ClipboardItem::updateData(const QVariantMap &data)
 
 void ClipboardItem::removeData(const QString &mimeType)
 {
-    m_data.remove(mimeType);
-    invalidateDataHash();
+    const MimeAtom atom = findFormatAtom(mimeType);
+    if ( removeFormat(atom, uninternedMime(atom, mimeType)) )
+        invalidateDataHash();
 }
 
 bool ClipboardItem::removeData(const QStringList &mimeTypeList)
@@ -122,10 +172,9 @@ bool ClipboardItem::removeData(const QStringList &mimeTypeList)
     bool removed = false;
 
     for (const auto &mimeType : mimeTypeList) {
-        if ( m_data.contains(mimeType) ) {
-            m_data.remove(mimeType);
+        const MimeAtom atom = findFormatAtom(mimeType);
+        if ( removeFormat(atom, uninternedMime(atom, mimeType)) )
             removed = true;
-        }
     }
 
     if (removed)
@@ -136,53 +185,217 @@ bool ClipboardItem::removeData(const QStringList &mimeTypeList)
 
 void ClipboardItem::setData(const QString &mimeType, const QByteArray &data)
 {
-    m_data.insert(mimeType, data);
+    const MimeAtom atom = mimeAtom(mimeType);
+    setFormat( atom, uninternedMime(atom, mimeType), data );
     invalidateDataHash();
 }
 
 QVariant ClipboardItem::data(int role) const
 {
+    const auto &atoms = knownAtoms();
+
     switch(role) {
     case Qt::DisplayRole:
     case Qt::EditRole:
-        if ( m_data.contains(mimeText) )
-            return getTextData(m_data);
-        if ( m_data.contains(mimeUriList) )
-            return getTextData(m_data, mimeUriList);
+        if ( formatData(atoms.text) )
+            return textData(atoms.text);
+        if ( formatData(atoms.uriList) )
+            return textData(atoms.uriList);
         break;
 
     case contentType::data:
-        return m_data; // copy-on-write, so this should be fast
+        return dataMap();
     case contentType::hash:
         return dataHash();
     case contentType::hasText:
-        return m_data.contains(mimeText) || m_data.contains(mimeUriList);
+        return formatData(atoms.text) || formatData(atoms.uriList);
     case contentType::hasHtml:
-        return m_data.contains(mimeHtml);
+        return formatData(atoms.html) != nullptr;
     case contentType::text:
-        return getTextData(m_data);
+        return formatData(atoms.text) ? textData(atoms.text) : textData(atoms.uriList);
     case contentType::html:
-        return getTextData(m_data, mimeHtml);
+        return textData(atoms.html);
     case contentType::notes:
-        return getTextData(m_data, mimeItemNotes);
+        return textData(atoms.notes);
     case contentType::color:
-        return getTextData(m_data, mimeColor);
+        return textData(atoms.color);
     case contentType::isHidden:
-        return m_data.contains(mimeHidden);
+        return formatData(atoms.hidden) != nullptr;
+    case contentType::textLength:
+        return textMetadata().length;
+    case contentType::textLineCount:
+        return textMetadata().lineCount;
     }
 
     return QVariant();
 }
 
+QByteArray ClipboardItem::data(const QString &format) const
+{
+    const auto bytes = formatData(format);
+    return bytes ? *bytes : QByteArray();
+}
+
 unsigned int ClipboardItem::dataHash() const
 {
-    if (m_hash == 0)
-        m_hash = hash(m_data);
+    if (m_hash == 0) {
+        // Same as hash(dataMap()) but without creating the map.
+        const auto &atoms = knownAtoms();
+        for (const auto &format : m_formats) {
+            // Skip some special data.
+            if ( format.atom == atoms.windowTitle
+              || format.atom == atoms.owner
+              || format.atom == atoms.clipboardMode )
+            {
+                continue;
+            }
+            m_hash ^= qHash(format.bytes) + qHash( format.name() );
+        }
+    }
 
     return m_hash;
 }
 
+qint64 ClipboardItem::dataSize() const
+{
+    updateDataSize();
+    return m_dataSize;
+}
+
+qint64 ClipboardItem::mappedDataSize() const
+{
+    updateDataSize();
+    return m_mappedDataSize;
+}
+
+ClipboardItem::Formats::iterator ClipboardItem::findFormat(MimeAtom atom, const QString &mime)
+{
+    return std::lower_bound(
+        std::begin(m_formats), std::end(m_formats), atom,
+        [&mime](const Format &format, MimeAtom atom) { return formatLessThan(format, atom, mime); } );
+}
+
+ClipboardItem::Formats::const_iterator ClipboardItem::findFormat(MimeAtom atom, const QString &mime) const
+{
+    return std::lower_bound(
+        std::begin(m_formats), std::end(m_formats), atom,
+        [&mime](const Format &format, MimeAtom atom) { return formatLessThan(format, atom, mime); } );
+}
+
+const QByteArray *ClipboardItem::formatData(MimeAtom atom, const QString &mime) const
+{
+    const auto it = findFormat(atom, mime);
+    if ( it == std::end(m_formats) || it->atom != atom || it->mime != mime )
+        return nullptr;
+    return &it->bytes;
+}
+
+const QByteArray *ClipboardItem::formatData(const QString &mimeType) const
+{
+    const MimeAtom atom = findFormatAtom(mimeType);
+    return formatData( atom, uninternedMime(atom, mimeType) );
+}
+
+bool ClipboardItem::setFormat(MimeAtom atom, const QString &mime, const QByteArray &bytes)
+{
+    const auto it = findFormat(atom, mime);
+    if ( it != std::end(m_formats) && it->atom == atom && it->mime == mime ) {
+        if (it->bytes == bytes)
+            return false;
+        it->bytes = bytes;
+        return true;
+    }
+
+    m_formats.insert( it, Format{atom, mime, bytes} );
+    return true;
+}
+
+bool ClipboardItem::removeFormat(MimeAtom atom, const QString &mime)
+{
+    const auto it = findFormat(atom, mime);
+    if ( it == std::end(m_formats) || it->atom != atom || it->mime != mime )
+        return false;
+
+    m_formats.erase(it);
+    return true;
+}
+
+bool ClipboardItem::removeUserFormats()
+{
+    // Internal formats are sorted after user formats.
+    const auto it = std::find_if(
+        std::begin(m_formats), std::end(m_formats),
+        [](const Format &format) { return !isUserMimeAtom(format.atom); } );
+
+    if ( it == std::begin(m_formats) )
+        return false;
+
+    m_formats.erase( std::begin(m_formats), it );
+    return true;
+}
+
+bool ClipboardItem::hasSameData(const QVariantMap &data) const
+{
+    if ( static_cast<size_t>(data.size()) != m_formats.size() )
+        return false;
+
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        const auto bytes = formatData( it.key() );
+        if ( !bytes || *bytes != it.value().toByteArray() )
+            return false;
+    }
+
+    return true;
+}
+
+QVariantMap ClipboardItem::dataMap() const
+{
+    QVariantMap data;
+    for (const auto &format : m_formats)
+        data.insert( format.name(), format.bytes );
+    return data;
+}
+
+QString ClipboardItem::textData(MimeAtom atom) const
+{
+    const auto bytes = formatData(atom);
+    return bytes ? getTextData(*bytes) : QString();
+}
+
+const TextMetadata &ClipboardItem::textMetadata() const
+{
+    if (!m_textMetadata) {
+        // Computed from UTF-8 data so huge texts are never fully decoded.
+        const auto &atoms = knownAtoms();
+        auto bytes = formatData(atoms.text);
+        if (!bytes)
+            bytes = formatData(atoms.uriList);
+        m_textMetadata = std::make_shared<const TextMetadata>(
+            bytes ? ::textMetadata(*bytes) : TextMetadata() );
+    }
+
+    return *m_textMetadata;
+}
+
+void ClipboardItem::updateDataSize() const
+{
+    if (m_dataSize != -1)
+        return;
+
+    m_dataSize = static_cast<qint64>( m_formats.size() * sizeof(Format) );
+    m_mappedDataSize = 0;
+    for (const auto &format : m_formats) {
+        if ( isMappedData(format.bytes) )
+            m_mappedDataSize += format.bytes.size();
+        else
+            m_dataSize += format.bytes.size();
+    }
+}
+
 void ClipboardItem::invalidateDataHash()
 {
     m_hash = 0;
+    m_dataSize = -1;
+    m_mappedDataSize = -1;
+    m_textMetadata.reset();
 }
@@ -20,16 +20,25 @@
 #ifndef CLIPBOARDITEM_H
 #define CLIPBOARDITEM_H
 
+#include "common/mimeatoms.h"
+
+#include <QByteArray>
+#include <QString>
 #include <QVariant>
 
-class QByteArray;
-class QString;
+#include <memory>
+#include <vector>
+
+struct TextMetadata;
 
 /**
  * Class for clipboard items in ClipboardModel.
  *
  * Clipboard item stores data of different MIME types and has single default
  * MIME type for displaying the contents.
+ *
+ * Data are kept in small vector sorted by interned MIME type so user formats
+ * precede internal formats. QVariantMap is created only when requested.
  */
 class ClipboardItem
 {
@@ -72,16 +81,54 @@ public:
     QVariant data(int role) const;
 
     /** Return data for format. */
-    QByteArray data(const QString &format) const { return m_data.value(format).toByteArray(); }
+    QByteArray data(const QString &format) const;
 
     /** Return hash for item's data. */
     unsigned int dataHash() const;
 
+    /** Return approximate number of bytes used by item's data in memory. */
+    qint64 dataSize() const;
+
+    /**
+     * Return number of bytes of item's data in memory-mapped tab file.
+     *
+     * The data are read from the file only when accessed and can be dropped
+     * from memory by the system, so these are not included in dataSize().
+     */
+    qint64 mappedDataSize() const;
+
 private:
+    struct Format {
+        MimeAtom atom;
+        /// MIME type, set only if the atom is not interned.
+        QString mime;
+        QByteArray bytes;
+
+        QString name() const { return mime.isEmpty() ? mimeAtomName(atom) : mime; }
+    };
+
+    using Formats = std::vector<Format>;
+
+    Formats::iterator findFormat(MimeAtom atom, const QString &mime);
+    Formats::const_iterator findFormat(MimeAtom atom, const QString &mime) const;
+    const QByteArray *formatData(MimeAtom atom, const QString &mime = QString()) const;
+    const QByteArray *formatData(const QString &mimeType) const;
+    bool setFormat(MimeAtom atom, const QString &mime, const QByteArray &bytes);
+    bool removeFormat(MimeAtom atom, const QString &mime);
+    bool removeUserFormats();
+    bool hasSameData(const QVariantMap &data) const;
+    QVariantMap dataMap() const;
+    QString textData(MimeAtom atom) const;
+    const TextMetadata &textMetadata() const;
+
+    void updateDataSize() const;
     void invalidateDataHash();
 
-    QVariantMap m_data;
+    Formats m_formats;
     mutable unsigned int m_hash;
+    mutable qint64 m_dataSize;
+    mutable qint64 m_mappedDataSize;
+    mutable std::shared_ptr<const TextMetadata> m_textMetadata;
 };
 
 #endif // CLIPBOARDITEM_H
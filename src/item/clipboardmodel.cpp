@@ -21,17 +21,19 @@
 
 #include "common/contenttype.h"
 #include "common/mimetypes.h"
+#include "item/serialize.h"
 
 #include <QStringList>
 
 #include <algorithm>
 #include <functional>
+#include <utility>
 
 namespace {
 
-QList<QPersistentModelIndex> validIndeces(const QModelIndexList &indexList)
+QModelIndexList validIndeces(const QModelIndexList &indexList)
 {
-    QList<QPersistentModelIndex> list;
+    QModelIndexList list;
     list.reserve(indexList.size());
 
     for (const auto &index : indexList) {
@@ -42,16 +44,6 @@ QList<QPersistentModelIndex> validIndeces(const QModelIndexList &indexList)
     return list;
 }
 
-int topMostRow(const QList<QPersistentModelIndex> &indexList)
-{
-    int row = indexList.value(0).row();
-
-    for (const auto &index : indexList)
-        row = qMin(row, index.row());
-
-    return row;
-}
-
 } // namespace
 
 void ClipboardItemList::move(int from, int count, int to)
@@ -68,8 +60,21 @@ void ClipboardItemList::move(int from, int count, int to)
     std::rotate(start1, start2, end2);
 }
 
+void ClipboardItemList::permute(const QVector<int> &sourceRows)
+{
+    Q_ASSERT( sourceRows.size() == size() );
+
+    std::deque<ClipboardItem> items;
+    for (const int row : sourceRows)
+        items.push_back( std::move(m_items[static_cast<size_t>(row)]) );
+
+    m_items.swap(items);
+}
+
 ClipboardModel::ClipboardModel(QObject *parent)
     : QAbstractListModel(parent)
+    , m_dataSize(0)
+    , m_mappedDataSize(0)
 {
 }
 
@@ -100,6 +105,8 @@ bool ClipboardModel::setData(const QModelIndex &index, const QVariant &value, in
         return false;
 
     int row = index.row();
+    const qint64 oldDataSize = m_clipboardList[row].dataSize();
+    const qint64 oldMappedDataSize = m_clipboardList[row].mappedDataSize();
 
     if (role == Qt::EditRole) {
         m_clipboardList[row].setText(value.toString());
@@ -124,6 +131,9 @@ bool ClipboardModel::setData(const QModelIndex &index, const QVariant &value, in
         return false;
     }
 
+    m_dataSize += m_clipboardList[row].dataSize() - oldDataSize;
+    m_mappedDataSize += m_clipboardList[row].mappedDataSize() - oldMappedDataSize;
+
     emit dataChanged(index, index);
 
     return true;
@@ -131,12 +141,15 @@ bool ClipboardModel::setData(const QModelIndex &index, const QVariant &value, in
 
 void ClipboardModel::insertItem(const QVariantMap &data, int row)
 {
+    // Data can come from other tab which can be unloaded later.
     ClipboardItem item;
-    item.setData(data);
+    item.setData( detachedMappedData(data) );
 
     beginInsertRows(QModelIndex(), row, row);
 
     m_clipboardList.insert(row, item);
+    m_dataSize += item.dataSize();
+    m_mappedDataSize += item.mappedDataSize();
 
     endInsertRows();
 }
@@ -147,12 +160,14 @@ void ClipboardModel::insertItems(const QList<QVariantMap> &dataList, int row)
         return;
 
     int targetRow = row;
-    m_clipboardList.reserve( m_clipboardList.size() + dataList.size() );
 
     beginInsertRows(QModelIndex(), row, row + dataList.size() - 1);
 
     for ( auto it = std::begin(dataList); it != std::end(dataList); ++it ) {
-        m_clipboardList.insert(targetRow, ClipboardItem(*it));
+        const ClipboardItem item( detachedMappedData(*it) );
+        m_clipboardList.insert(targetRow, item);
+        m_dataSize += item.dataSize();
+        m_mappedDataSize += item.mappedDataSize();
         ++targetRow;
     }
 
@@ -183,6 +198,11 @@ bool ClipboardModel::removeRows(int position, int rows, const QModelIndex&)
 
     beginRemoveRows(QModelIndex(), position, last);
 
+    for (int row = position; row <= last; ++row) {
+        m_dataSize -= m_clipboardList[row].dataSize();
+        m_mappedDataSize -= m_clipboardList[row].mappedDataSize();
+    }
+
     m_clipboardList.remove(position, last - position + 1);
 
     endRemoveRows();
@@ -216,29 +236,64 @@ bool ClipboardModel::moveRows(
 
 void ClipboardModel::sortItems(const QModelIndexList &indexList, CompareItems *compare)
 {
-    QList<QPersistentModelIndex> list = validIndeces(indexList);
-    std::sort( list.begin(), list.end(), compare );
+    QVector<bool> isSorted(rowCount(), false);
+    int topMostRow = rowCount();
+    QModelIndexList list;
+    for ( const auto &index : validIndeces(indexList) ) {
+        if ( !isSorted[index.row()] ) {
+            isSorted[index.row()] = true;
+            topMostRow = qMin(topMostRow, index.row());
+            list.append(index);
+        }
+    }
 
-    int targetRow = topMostRow(list);
+    if ( list.isEmpty() )
+        return;
 
-    for (const auto &ind : list) {
-        if (ind.isValid()) {
-            const int sourceRow = ind.row();
+    std::sort( list.begin(), list.end(), compare );
 
-            if (targetRow != sourceRow) {
-                beginMoveRows(QModelIndex(), sourceRow, sourceRow, QModelIndex(), targetRow);
-                m_clipboardList.move(sourceRow, targetRow);
-                endMoveRows();
+    // Rows above sorted items keep position, sorted items follow and
+    // other items below keep order.
+    QVector<int> sourceRows;
+    sourceRows.reserve( rowCount() );
+    for (int row = 0; row < topMostRow; ++row)
+        sourceRows.append(row);
+    for (const auto &index : list)
+        sourceRows.append( index.row() );
+    for (int row = topMostRow; row < rowCount(); ++row) {
+        if ( !isSorted[row] )
+            sourceRows.append(row);
+    }
 
-                // If the moved item was removed or moved further (as reaction on moving the item),
-                // stop sorting.
-                if (!ind.isValid() || ind.row() != targetRow)
-                    break;
-            }
+    permuteRows(sourceRows);
+}
 
-            ++targetRow;
-        }
+void ClipboardModel::permuteRows(const QVector<int> &sourceRows)
+{
+    Q_ASSERT( sourceRows.size() == rowCount() );
+
+    bool changed = false;
+    QVector<int> targetRows( sourceRows.size() );
+    for (int row = 0; row < sourceRows.size(); ++row) {
+        targetRows[ sourceRows[row] ] = row;
+        changed = changed || sourceRows[row] != row;
     }
+
+    if (!changed)
+        return;
+
+    emit layoutAboutToBeChanged( QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint );
+
+    m_clipboardList.permute(sourceRows);
+
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    newIndexes.reserve( oldIndexes.size() );
+    for (const auto &oldIndex : oldIndexes)
+        newIndexes.append( index(targetRows[oldIndex.row()]) );
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit layoutChanged( QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint );
 }
 
 int ClipboardModel::findItem(uint itemHash) const
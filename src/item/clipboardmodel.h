@@ -24,66 +24,61 @@
 
 #include <QAbstractListModel>
 #include <QList>
+#include <QVector>
+
+#include <deque>
 
 /**
  * Container with clipboard items.
  *
- * Item prepending is optimized.
+ * Item prepending is optimized (constant time) and moving or reordering
+ * items only moves item handles.
  */
 class ClipboardItemList {
 public:
     ClipboardItem &operator [](int i)
     {
-        return m_items[i];
+        return m_items[static_cast<size_t>(i)];
     }
 
     const ClipboardItem &operator [](int i) const
     {
-        return m_items[i];
+        return m_items[static_cast<size_t>(i)];
     }
 
     void insert(int row, const ClipboardItem &item)
     {
-        m_items.insert(row, item);
+        if (row == 0)
+            m_items.push_front(item);
+        else
+            m_items.insert(std::begin(m_items) + row, item);
     }
 
     void remove(int row, int count)
     {
-        const QList<ClipboardItem>::iterator from = m_items.begin() + row;
-        const QList<ClipboardItem>::iterator to = from + count;
+        const auto from = std::begin(m_items) + row;
+        const auto to = from + count;
         m_items.erase(from, to);
     }
 
     int size() const
     {
-        return m_items.size();
-    }
-
-    void move(int from, int to)
-    {
-        const ClipboardItem item = m_items[from];
-        m_items.removeAt(from);
-        m_items.insert(to, item);
+        return static_cast<int>(m_items.size());
     }
 
+    /// Moves items similarly to QAbstractItemModel::moveRows().
     void move(int from, int count, int to);
 
-    void reserve(int maxItems)
-    {
-        m_items.reserve(maxItems);
-    }
+    /// Reorders items so that row i contains item from row sourceRows[i].
+    void permute(const QVector<int> &sourceRows);
 
     void resize(int size)
     {
-        if (size < this->size())
-            remove(size, this->size());
-
-        while (size > this->size())
-            m_items.append(ClipboardItem());
+        m_items.resize( static_cast<size_t>(size) );
     }
 
 private:
-    QList<ClipboardItem> m_items;
+    std::deque<ClipboardItem> m_items;
 };
 
 /**
@@ -127,17 +122,36 @@ public:
 
     /**
      * Sort items in ascending order.
+     *
+     * Sorted items are placed from the top-most row of the items and
+     * the model layout is changed at once.
      */
     void sortItems(const QModelIndexList &indexList, CompareItems *compare);
 
+    /**
+     * Reorders rows so that row i contains item from row sourceRows[i].
+     *
+     * Emits layoutAboutToBeChanged() and layoutChanged() only once
+     * and updates persistent indexes.
+     */
+    void permuteRows(const QVector<int> &sourceRows);
+
     /**
      * Find item with given @a hash.
      * @return Row number with found item or -1 if no item was found.
      */
     int findItem(uint itemHash) const;
 
+    /** Return approximate number of bytes used by data of all items in memory. */
+    qint64 dataSize() const { return m_dataSize; }
+
+    /** Return number of bytes of item data in memory-mapped tab file. */
+    qint64 mappedDataSize() const { return m_mappedDataSize; }
+
 private:
     ClipboardItemList m_clipboardList;
+    qint64 m_dataSize;
+    qint64 m_mappedDataSize;
 };
 
 #endif // CLIPBOARDMODEL_H
@@ -23,6 +23,7 @@
 #include "common/contenttype.h"
 #include "common/mimetypes.h"
 #include "common/textdata.h"
+#include "common/trace.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/iconfactory.h"
 #include "item/itemfactory.h"
@@ -127,6 +128,31 @@ void ItemDelegate::rowsMoved(const QModelIndex &, int sourceStart, int sourceEnd
     std::rotate(start1, start2, end2);
 }
 
+void ItemDelegate::layoutAboutToBeChanged()
+{
+    m_layoutCache.clear();
+    for (size_t row = 0; row < m_cache.size(); ++row) {
+        if (m_cache[row]) {
+            const auto index = m_view->index( static_cast<int>(row) );
+            m_layoutCache.emplace_back( QPersistentModelIndex(index), m_cache[row] );
+        }
+    }
+}
+
+void ItemDelegate::layoutChanged()
+{
+    for (auto &item : m_cache)
+        item.reset();
+
+    for (const auto &indexWidget : m_layoutCache) {
+        const auto &index = indexWidget.first;
+        if ( index.isValid() )
+            m_cache[static_cast<size_t>(index.row())] = indexWidget.second;
+    }
+
+    m_layoutCache.clear();
+}
+
 void ItemDelegate::rowsInserted(const QModelIndex &, int start, int end)
 {
     const auto count = static_cast<size_t>(end - start + 1);
@@ -172,6 +198,25 @@ bool ItemDelegate::hasCache(const QModelIndex &index) const
     return cacheOrNull(row) != nullptr;
 }
 
+int ItemDelegate::cacheSize() const
+{
+    return static_cast<int>( std::count_if(
+        std::begin(m_cache), std::end(m_cache),
+        [](const std::shared_ptr<ItemWidget> &w) { return w != nullptr; }) );
+}
+
+qint64 ItemDelegate::cacheMemoryUsage() const
+{
+    qint64 size = 0;
+    for (const auto &w : m_cache) {
+        if (w) {
+            const QSize widgetSize = w->widget()->size();
+            size += 4 * static_cast<qint64>(widgetSize.width()) * widgetSize.height();
+        }
+    }
+    return size;
+}
+
 void ItemDelegate::setItemSizes(QSize size, int idealWidth)
 {
     const auto margins = m_sharedData->theme.margins();
@@ -345,6 +390,8 @@ int ItemDelegate::findWidgetRow(const QObject *obj) const
 
 ItemWidget *ItemDelegate::updateCache(const QModelIndex &index, const QVariantMap &data)
 {
+    COPYQ_TRACE("ItemDelegate::updateCache");
+
     const bool antialiasing = m_sharedData->theme.isAntialiasingEnabled();
     QWidget *parent = m_view->viewport();
 
@@ -23,9 +23,11 @@
 #include "gui/clipboardbrowsershared.h"
 
 #include <QItemDelegate>
+#include <QPersistentModelIndex>
 #include <QRegExp>
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 class Item;
@@ -85,6 +87,16 @@ class ItemDelegate : public QItemDelegate
         /** Return true only if item at index is already in cache. */
         bool hasCache(const QModelIndex &index) const;
 
+        /** Return number of cached item widgets. */
+        int cacheSize() const;
+
+        /**
+         * Return approximate number of bytes used by cached item widgets.
+         *
+         * Assumes each widget keeps 32-bit pixel data for its whole area.
+         */
+        qint64 cacheMemoryUsage() const;
+
         /** Set maximum size for all items. */
         void setItemSizes(QSize size, int idealWidth);
 
@@ -118,6 +130,8 @@ class ItemDelegate : public QItemDelegate
         void rowsInserted(const QModelIndex &parent, int start, int end);
         void rowsMoved(const QModelIndex &parent, int sourceStart, int sourceEnd,
                        const QModelIndex &destination, int destinationRow);
+        void layoutAboutToBeChanged();
+        void layoutChanged();
 
     signals:
         void itemWidgetCreated(const PersistentDisplayItem &selection);
@@ -145,6 +159,9 @@ class ItemDelegate : public QItemDelegate
         int m_idealWidth;
 
         std::vector<std::shared_ptr<ItemWidget>> m_cache;
+
+        /// Cached widgets with their indexes while model layout changes.
+        std::vector<std::pair<QPersistentModelIndex, std::shared_ptr<ItemWidget>>> m_layoutCache;
 };
 
 #endif // ITEMDELEGATE_H
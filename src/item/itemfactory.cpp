@@ -113,6 +113,7 @@ public:
         , ItemWidget(this)
         , m_hasText( data.contains(mimeText) || data.contains(mimeUriList) )
         , m_data(data)
+        , m_dataHash(0)
     {
         setMargin(0);
         setWordWrap(true);
@@ -137,6 +138,7 @@ public:
         }
 
         m_data.remove(mimeItemNotes);
+        m_dataHash = hash(m_data);
     }
 
     void updateSize(QSize, int idealWidth) override
@@ -145,8 +147,8 @@ public:
 
         if (!pixmap()) {
             const int width = contentsRect().width();
-            const QString label =
-                    textLabelForData(m_data, font(), QString(), false, width, 1);
+            const QString label = cachedTextLabelForData(
+                        m_dataHash, m_data, font(), QString(), false, width, 1);
             setText(label);
         }
     }
@@ -159,6 +161,7 @@ public:
 private:
     bool m_hasText;
     QVariantMap m_data;
+    uint m_dataHash;
     QString m_imageFormat;
 };
 
@@ -167,7 +170,8 @@ class DummySaver : public ItemSaverInterface
 public:
     bool saveItems(const QString & /* tabName */, const QAbstractItemModel &model, QIODevice *file) override
     {
-        return serializeData(model, file);
+        // Tab files are private to the app, data for other apps use the older format.
+        return serializeData(model, file, DataVersion::V3);
     }
 };
 
@@ -191,7 +195,7 @@ public:
     ItemSaverPtr loadItems(const QString &, QAbstractItemModel *model, QIODevice *file, int maxItems) override
     {
         if ( file->size() > 0 ) {
-            if ( !deserializeData(model, file, maxItems) ) {
+            if ( !deserializeMappedData(model, file, maxItems) ) {
                 model->removeRows(0, model->rowCount());
                 return nullptr;
             }
@@ -25,8 +25,10 @@
 #include "item/itemfactory.h"
 
 #include <QAbstractItemModel>
+#include <QBuffer>
 #include <QDir>
 #include <QFile>
+#include <QSaveFile>
 
 namespace {
 
@@ -53,7 +55,7 @@ bool createItemDirectory()
 }
 
 void printItemFileError(
-        const QString &action, const QString &id, const QFile &file)
+        const QString &action, const QString &id, const QFileDevice &file)
 {
     log( QString("Tab %1: Failed to %2, file %3: %4").arg(
              quoteString(id),
@@ -78,6 +80,32 @@ ItemSaverPtr loadItems(
     return itemFactory->loadItems(tabName, &model, &tabFile, maxItems);
 }
 
+/**
+ * Loads items from a copy of the file in memory.
+ *
+ * Used for files which can be overwritten later so their content cannot
+ * be memory-mapped.
+ */
+ItemSaverPtr loadItemsFromCopy(
+        const QString &tabName, const QString &fileName,
+        QAbstractItemModel &model, ItemFactory *itemFactory, int maxItems)
+{
+    COPYQ_LOG( QString("Tab \"%1\": Loading items from copy").arg(tabName) );
+
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        printItemFileError("load tab", tabName, file);
+        return nullptr;
+    }
+
+    QBuffer buffer;
+    buffer.setData( file.readAll() );
+    file.close();
+    buffer.open(QIODevice::ReadOnly);
+
+    return itemFactory->loadItems(tabName, &model, &buffer, maxItems);
+}
+
 ItemSaverPtr createTab(
         const QString &tabName, QAbstractItemModel &model, ItemFactory *itemFactory, int maxItems)
 {
@@ -112,7 +140,7 @@ ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel &model, ItemFa
         if ( tmpFile.exists() ) {
             log( QString("Tab \"%1\": Restoring items (previous save failed)").arg(tabName), LogWarning );
 
-            saver = loadItems(tabName, tmpFile.fileName(), model, itemFactory, maxItems);
+            saver = loadItemsFromCopy(tabName, tmpFile.fileName(), model, itemFactory, maxItems);
             if ( saver && !tmpFile.rename(tabFileName) )
                 printItemFileError("overwrite original file", tabName, tmpFile);
         }
@@ -141,38 +169,25 @@ bool saveItems(const QString &tabName, const QAbstractItemModel &model, const It
     if ( !createItemDirectory() )
         return false;
 
-    // Save to temp file.
-    QFile tmpFile( tabFileName + ".tmp" );
-    if ( !tmpFile.open(QIODevice::WriteOnly) ) {
-        printItemFileError("save tab (open temporary file)", tabName, tmpFile);
+    // Save to new temporary file and replace the tab file only after all is written.
+    // The old file is never truncated since its content can be still mapped
+    // to memory by the loaded items.
+    QSaveFile tabFile(tabFileName);
+    if ( !tabFile.open(QIODevice::WriteOnly) ) {
+        printItemFileError("save tab (open temporary file)", tabName, tabFile);
         return false;
     }
 
     COPYQ_LOG( QString("Tab \"%1\": Saving %2 items").arg(tabName).arg(model.rowCount()) );
 
-    if ( !saver->saveItems(tabName, model, &tmpFile) ) {
-        printItemFileError("save tab (save items to temporary file)", tabName, tmpFile);
-        return false;
-    }
-
-    // 1. Safely flush all data to temporary file.
-    if ( !tmpFile.flush() ) {
-        printItemFileError("save tab (flush temporary file)", tabName, tmpFile);
+    if ( !saver->saveItems(tabName, model, &tabFile) ) {
+        printItemFileError("save tab (save items to temporary file)", tabName, tabFile);
+        tabFile.cancelWriting();
         return false;
     }
 
-    // 2. Remove old tab file.
-    {
-        QFile oldTabFile(tabFileName);
-        if (oldTabFile.exists() && !oldTabFile.remove()) {
-            printItemFileError("save tab (remove file)", tabName, oldTabFile);
-            return false;
-        }
-    }
-
-    // 3. Overwrite previous file.
-    if ( !tmpFile.rename(tabFileName) ) {
-        printItemFileError("save tab (overwrite original file)", tabName, tmpFile);
+    if ( !tabFile.commit() ) {
+        printItemFileError("save tab (overwrite original file)", tabName, tabFile);
         return false;
     }
 
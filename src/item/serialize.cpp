@@ -26,16 +26,62 @@
 #include <QAbstractItemModel>
 #include <QByteArray>
 #include <QDataStream>
+#include <QFile>
 #include <QIODevice>
 #include <QList>
 #include <QObject>
 #include <QPair>
 #include <QStringList>
 
+#include <limits>
 #include <unordered_map>
+#include <vector>
 
 namespace {
 
+/// Smaller tab files are read to memory instead of mapping them.
+const qint64 minMappedFileSize = 1024 * 1024;
+
+/**
+ * Formats stored as single byte ID in data format version 3.
+ *
+ * IDs are stored in files so new formats must be only appended.
+ *
+ * Decoded formats share the MIME strings (these are not interned as atoms
+ * so that serializing unusual formats doesn't grow the atom registry).
+ */
+const std::vector<QString> &persistentMimes()
+{
+    static const std::vector<QString> mimes({
+        QString(mimeText),
+        QString(mimeHtml),
+        QString(mimeUriList),
+        QString(mimeWindowTitle),
+        QString(mimeItemNotes),
+        QString(mimeOwner),
+        QString(mimeHidden),
+        QString(mimeColor),
+        QString("image/png"),
+        QString("image/bmp"),
+        QString("image/jpeg"),
+        QString("image/gif"),
+        QString("image/svg+xml"),
+        QString("text/x-moz-url"),
+        QString("application/x-qt-image"),
+    });
+    return mimes;
+}
+
+quint8 persistentMimeId(const QString &mime)
+{
+    const auto &mimes = persistentMimes();
+    for (size_t i = 0; i < mimes.size(); ++i) {
+        if (mimes[i] == mime)
+            return static_cast<quint8>(i + 1);
+    }
+    return 0;
+}
+
 const std::unordered_map<int, QString> &idToMime()
 {
     static const std::unordered_map<int, QString> map({
@@ -57,6 +103,40 @@ const std::unordered_map<int, QString> &idToMime()
     return map;
 }
 
+/**
+ * Reads byte array from stream.
+ *
+ * If the stream reads memory-mapped file (mappedData is not null),
+ * the returned bytes reference the mapped memory without copying.
+ */
+void readBytes(QDataStream *out, const QByteArray *mappedData, QByteArray *bytes)
+{
+    if (mappedData == nullptr) {
+        *out >> *bytes;
+        return;
+    }
+
+    // Same format as QDataStream::operator>>(QByteArray&).
+    quint32 size;
+    *out >> size;
+    if ( out->status() != QDataStream::Ok )
+        return;
+
+    if (size == 0xffffffff) {
+        *bytes = QByteArray();
+        return;
+    }
+
+    const qint64 pos = out->device()->pos();
+    if ( pos + size > mappedData->size() ) {
+        out->setStatus(QDataStream::ReadPastEnd);
+        return;
+    }
+
+    *bytes = QByteArray::fromRawData( mappedData->constData() + pos, static_cast<int>(size) );
+    out->skipRawData( static_cast<int>(size) );
+}
+
 QString decompressMime(QDataStream *out)
 {
     QString mime;
@@ -94,7 +174,7 @@ QString compressMime(const QString &mime)
     return "0" + mime;
 }
 
-bool deserializeDataV2(QDataStream *out, QVariantMap *data)
+bool deserializeDataV2(QDataStream *out, const QByteArray *mappedData, QVariantMap *data)
 {
     qint32 size;
     *out >> size;
@@ -106,7 +186,8 @@ bool deserializeDataV2(QDataStream *out, QVariantMap *data)
         if ( out->status() != QDataStream::Ok )
             return false;
 
-        *out >> compress >> tmpBytes;
+        *out >> compress;
+        readBytes(out, compress ? nullptr : mappedData, &tmpBytes);
         if ( out->status() != QDataStream::Ok )
             return false;
 
@@ -123,26 +204,41 @@ bool deserializeDataV2(QDataStream *out, QVariantMap *data)
     return out->status() == QDataStream::Ok;
 }
 
-} // namespace
-
-void serializeData(QDataStream *stream, const QVariantMap &data)
+bool deserializeDataV3(QDataStream *out, const QByteArray *mappedData, QVariantMap *data)
 {
-    *stream << static_cast<qint32>(-2);
+    qint32 size;
+    *out >> size;
 
-    const qint32 size = data.size();
-    *stream << size;
+    const auto &mimes = persistentMimes();
+    QByteArray tmpBytes;
+    quint8 mimeId;
+    for (qint32 i = 0; i < size && out->status() == QDataStream::Ok; ++i) {
+        *out >> mimeId;
+        if ( out->status() != QDataStream::Ok )
+            return false;
 
-    QByteArray bytes;
-    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        const auto &mime = it.key();
-        bytes = data[mime].toByteArray();
-        *stream << compressMime(mime)
-                << /* compressData = */ false
-                << bytes;
+        QString mime;
+        if (mimeId == 0) {
+            mime = decompressMime(out);
+        } else if (mimeId <= mimes.size()) {
+            // Shares MIME string with other items.
+            mime = mimes[mimeId - 1];
+        } else {
+            out->setStatus(QDataStream::ReadCorruptData);
+            return false;
+        }
+
+        readBytes(out, mappedData, &tmpBytes);
+        if ( out->status() != QDataStream::Ok )
+            return false;
+
+        data->insert(mime, tmpBytes);
     }
+
+    return out->status() == QDataStream::Ok;
 }
 
-void deserializeData(QDataStream *stream, QVariantMap *data)
+void deserializeData(QDataStream *stream, const QByteArray *mappedData, QVariantMap *data)
 {
     try {
         qint32 length;
@@ -151,8 +247,13 @@ void deserializeData(QDataStream *stream, QVariantMap *data)
         if ( stream->status() != QDataStream::Ok )
             return;
 
+        if (length == -3) {
+            deserializeDataV3(stream, mappedData, data);
+            return;
+        }
+
         if (length == -2) {
-            deserializeDataV2(stream, data);
+            deserializeDataV2(stream, mappedData, data);
             return;
         }
 
@@ -182,6 +283,67 @@ void deserializeData(QDataStream *stream, QVariantMap *data)
     }
 }
 
+bool deserializeData(
+        QAbstractItemModel *model, QDataStream *stream, const QByteArray *mappedData, int maxItems)
+{
+    qint32 length;
+    *stream >> length;
+
+    if ( stream->status() != QDataStream::Ok )
+        return false;
+
+    if (length < 0) {
+        stream->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    // Limit the loaded number of items to model's maximum.
+    length = qMin(length, maxItems) - model->rowCount();
+
+    if ( length != 0 && !model->insertRows(0, length) )
+        return false;
+
+    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
+        QVariantMap data;
+        deserializeData(stream, mappedData, &data);
+        model->setData( model->index(i, 0), data, contentType::data );
+    }
+
+    return stream->status() == QDataStream::Ok;
+}
+
+} // namespace
+
+void serializeData(QDataStream *stream, const QVariantMap &data, DataVersion version)
+{
+    *stream << static_cast<qint32>(version == DataVersion::V3 ? -3 : -2);
+
+    const qint32 size = data.size();
+    *stream << size;
+
+    QByteArray bytes;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        const auto &mime = it.key();
+        if (version == DataVersion::V3) {
+            const quint8 mimeId = persistentMimeId(mime);
+            *stream << mimeId;
+            if (mimeId == 0)
+                *stream << compressMime(mime);
+        } else {
+            *stream << compressMime(mime)
+                    << /* compressData = */ false;
+        }
+
+        bytes = it.value().toByteArray();
+        *stream << bytes;
+    }
+}
+
+void deserializeData(QDataStream *stream, QVariantMap *data)
+{
+    deserializeData(stream, nullptr, data);
+}
+
 QByteArray serializeData(const QVariantMap &data)
 {
     QByteArray bytes;
@@ -197,55 +359,98 @@ bool deserializeData(QVariantMap *data, const QByteArray &bytes)
     return out.status() == QDataStream::Ok;
 }
 
-bool serializeData(const QAbstractItemModel &model, QDataStream *stream)
+bool serializeData(const QAbstractItemModel &model, QDataStream *stream, DataVersion version)
 {
     qint32 length = model.rowCount();
     *stream << length;
 
     for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i)
-        serializeData( stream, model.data(model.index(i, 0), contentType::data).toMap() );
+        serializeData( stream, model.data(model.index(i, 0), contentType::data).toMap(), version );
 
     return stream->status() == QDataStream::Ok;
 }
 
 bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItems)
 {
-    qint32 length;
-    *stream >> length;
+    return deserializeData(model, stream, nullptr, maxItems);
+}
 
-    if ( stream->status() != QDataStream::Ok )
-        return false;
+bool serializeData(const QAbstractItemModel &model, QIODevice *file, DataVersion version)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    return serializeData(model, &stream, version);
+}
 
-    if (length < 0) {
-        stream->setStatus(QDataStream::ReadCorruptData);
-        return false;
-    }
+bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    return deserializeData(model, &stream, maxItems);
+}
 
-    // Limit the loaded number of items to model's maximum.
-    length = qMin(length, maxItems) - model->rowCount();
+bool deserializeMappedData(QAbstractItemModel *model, QIODevice *file, int maxItems)
+{
+#ifdef Q_OS_UNIX
+    // Mapped file can be removed and replaced safely only on UNIX
+    // (the mapped data are kept until unmapped).
+    const auto tabFile = qobject_cast<QFile*>(file);
+    if ( tabFile == nullptr
+         || tabFile->size() < minMappedFileSize
+         || tabFile->size() > std::numeric_limits<int>::max() )
+    {
+        return deserializeData(model, file, maxItems);
+    }
 
-    if ( length != 0 && !model->insertRows(0, length) )
-        return false;
+    // Mapping is removed once the file object is destroyed with the model.
+    auto mappedFile = new QFile(tabFile->fileName(), model);
+    uchar *mapped = nullptr;
+    if ( mappedFile->open(QIODevice::ReadOnly) )
+        mapped = mappedFile->map( 0, mappedFile->size() );
 
-    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
-        QVariantMap data;
-        deserializeData(stream, &data);
-        model->setData( model->index(i, 0), data, contentType::data );
+    if (mapped == nullptr) {
+        log( QString("Failed to map tab file: %1").arg(mappedFile->errorString()), LogWarning );
+        delete mappedFile;
+        return deserializeData(model, file, maxItems);
     }
 
-    return stream->status() == QDataStream::Ok;
+    const QByteArray mappedData = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(mapped), static_cast<int>(mappedFile->size()) );
+
+    QDataStream stream(mappedData);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream.skipRawData( static_cast<int>(file->pos()) );
+    if ( deserializeData(model, &stream, &mappedData, maxItems) )
+        return true;
+
+    model->removeRows( 0, model->rowCount() );
+    delete mappedFile;
+    return false;
+#else
+    return deserializeData(model, file, maxItems);
+#endif
 }
 
-bool serializeData(const QAbstractItemModel &model, QIODevice *file)
+bool isMappedData(const QByteArray &bytes)
 {
-    QDataStream stream(file);
-    stream.setVersion(QDataStream::Qt_4_7);
-    return serializeData(model, &stream);
+    // Only data created with QByteArray::fromRawData() are not mutable.
+    return !bytes.isEmpty() && !bytes.data_ptr()->isMutable();
 }
 
-bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems)
+QByteArray detachedMappedData(const QByteArray &bytes)
 {
-    QDataStream stream(file);
-    stream.setVersion(QDataStream::Qt_4_7);
-    return deserializeData(model, &stream, maxItems);
+    if ( isMappedData(bytes) )
+        return QByteArray( bytes.constData(), bytes.size() );
+
+    return bytes;
+}
+
+QVariantMap detachedMappedData(const QVariantMap &data)
+{
+    QVariantMap result = data;
+    for (auto it = result.begin(); it != result.end(); ++it) {
+        if ( isMappedData(it.value().toByteArray()) )
+            it.value() = detachedMappedData( it.value().toByteArray() );
+    }
+    return result;
 }
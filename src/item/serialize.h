@@ -27,14 +27,50 @@ class QByteArray;
 class QDataStream;
 class QIODevice;
 
-void serializeData(QDataStream *stream, const QVariantMap &data);
+/**
+ * Version of serialized item data.
+ *
+ * All versions are read, written is only version passed to serializeData().
+ */
+enum class DataVersion {
+    /// Readable by older app versions (default, used for data passed to other apps and processes).
+    V2,
+    /// Stores common formats as single byte IDs (used for tab files).
+    V3
+};
+
+void serializeData(QDataStream *stream, const QVariantMap &data, DataVersion version = DataVersion::V2);
 void deserializeData(QDataStream *stream, QVariantMap *data);
 QByteArray serializeData(const QVariantMap &data);
 bool deserializeData(QVariantMap *data, const QByteArray &bytes);
 
-bool serializeData(const QAbstractItemModel &model, QDataStream *stream);
+bool serializeData(const QAbstractItemModel &model, QDataStream *stream, DataVersion version = DataVersion::V2);
 bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItems);
-bool serializeData(const QAbstractItemModel &model, QIODevice *file);
+bool serializeData(const QAbstractItemModel &model, QIODevice *file, DataVersion version = DataVersion::V2);
 bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems);
 
+/**
+ * Loads items from large tab file mapped to memory.
+ *
+ * Loaded item data reference the mapped file without copying so these
+ * don't take additional memory until accessed. The mapping is owned
+ * by the model (it's removed when the model is destroyed).
+ *
+ * Falls back to deserializeData() if the file cannot be mapped.
+ */
+bool deserializeMappedData(QAbstractItemModel *model, QIODevice *file, int maxItems);
+
+/// Returns true if data reference memory-mapped tab file (see deserializeMappedData()).
+bool isMappedData(const QByteArray &bytes);
+
+/**
+ * Returns deep copy of data referencing memory-mapped tab file.
+ *
+ * Item data from model can be passed around freely while the model exists.
+ * Data which can outlive the model (set to clipboard, passed to commands
+ * or cached) must be detached first.
+ */
+QByteArray detachedMappedData(const QByteArray &bytes);
+QVariantMap detachedMappedData(const QVariantMap &data);
+
 #endif // SERIALIZE_H
@@ -166,6 +166,12 @@ bool needsTests(const QString &arg)
     return arg == "--tests" ||
            arg == "tests";
 }
+
+bool needsBenchmarks(const QString &arg)
+{
+    return arg == "--benchmarks" ||
+           arg == "benchmarks";
+}
 #endif
 
 QString getSessionName(const QStringList &arguments, int *skipArguments)
@@ -230,6 +236,11 @@ int startApplication(int argc, char **argv)
             // Skip the "tests" argument and pass the rest to tests.
             return runTests(argc - skipArguments - 1, argv + skipArguments + 1);
         }
+
+        if ( needsBenchmarks(arg) ) {
+            // Skip the "benchmarks" argument and pass the rest to benchmarks.
+            return runBenchmarks(argc - skipArguments - 1, argv + skipArguments + 1);
+        }
 #endif
     }
 
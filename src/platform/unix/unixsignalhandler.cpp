@@ -53,6 +53,18 @@ void exitSignalHandler(int)
         log("Failed to handle signal!", LogError);
 }
 
+/**
+ * Write pending log messages before the application crashes.
+ *
+ * The default handler is restored (SA_RESETHAND) so raising the signal again
+ * terminates the application as usual.
+ */
+void crashSignalHandler(int signal)
+{
+    flushLogOnCrash();
+    ::raise(signal);
+}
+
 void handleSignal()
 {
     signalFdNotifier->setEnabled(false);
@@ -90,6 +102,16 @@ bool initUnixSignalHandler()
         return false;
     }
 
+    struct sigaction crashSigact{};
+    crashSigact.sa_handler = crashSignalHandler;
+    sigemptyset(&crashSigact.sa_mask);
+    crashSigact.sa_flags = SA_RESETHAND;
+
+    for ( const int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT} ) {
+        if ( sigaction(signal, &crashSigact, nullptr) > 0 )
+            log("sigaction() failed for crash signal!", LogWarning);
+    }
+
     if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalFd)) {
         log("socketpair() failed!", LogError);
         return false;
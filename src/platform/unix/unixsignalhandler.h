@@ -23,6 +23,8 @@
 /**
  * Gracefully exit application on Unix signals SIGHUP, SIGINT and SIGTERM.
  *
+ * Pending log messages are written on fatal signals (SIGSEGV, SIGABRT etc.).
+ *
  * More info at http://qt-project.org/doc/qt-4.8/unix-signals.html
  */
 
@@ -25,6 +25,7 @@
 #include "common/mimetypes.h"
 #include "common/log.h"
 #include "common/timer.h"
+#include "common/trace.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
@@ -157,6 +158,11 @@ void X11PlatformClipboard::check()
 
 bool X11PlatformClipboard::updateClipboardData(X11PlatformClipboard::ClipboardData *clipboardData)
 {
+    if ( clipboardData->traceEventId.isEmpty() && isTracingEnabled() )
+        clipboardData->traceEventId = createTraceEventId();
+    TraceEventScope traceEventScope(clipboardData->traceEventId);
+    COPYQ_TRACE("X11PlatformClipboard::updateClipboardData");
+
     const auto data = ::clipboardData(clipboardData->mode);
     if (!data) {
         m_timerCheckAgain.start(maxCheckAgainIntervalMs);
@@ -169,8 +175,10 @@ bool X11PlatformClipboard::updateClipboardData(X11PlatformClipboard::ClipboardDa
         clipboardData->newData = cloneData(*data, clipboardData->formats);
     }
 
-    if (clipboardData->data == clipboardData->newData)
+    if (clipboardData->data == clipboardData->newData) {
+        clipboardData->traceEventId.clear();
         return false;
+    }
 
     clipboardData->timerEmitChange.start();
     return true;
@@ -178,6 +186,10 @@ bool X11PlatformClipboard::updateClipboardData(X11PlatformClipboard::ClipboardDa
 
 void X11PlatformClipboard::useNewClipboardData(X11PlatformClipboard::ClipboardData *clipboardData)
 {
+    // Clipboard monitor handles the change with the same trace event.
+    TraceEventScope traceEventScope(clipboardData->traceEventId);
+    clipboardData->traceEventId.clear();
+
     clipboardData->data = clipboardData->newData;
     clipboardData->owner = clipboardData->newOwner;
     clipboardData->timerEmitChange.stop();
@@ -51,6 +51,8 @@ private:
         QTimer timerEmitChange;
         QStringList formats;
         QByteArray newDataTimestamp;
+        /// Correlates trace spans of a clipboard change with other processes.
+        QByteArray traceEventId;
         ClipboardMode mode;
     };
 
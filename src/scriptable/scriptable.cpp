@@ -29,6 +29,7 @@
 #include "common/sleeptimer.h"
 #include "common/version.h"
 #include "common/textdata.h"
+#include "common/trace.h"
 #include "gui/icons.h"
 #include "item/itemfactory.h"
 #include "item/serialize.h"
@@ -64,6 +65,9 @@
 #include <QThread>
 #include <QTimer>
 
+#include <memory>
+#include <vector>
+
 Q_DECLARE_METATYPE(QByteArray*)
 Q_DECLARE_METATYPE(QFile*)
 
@@ -72,6 +76,18 @@ namespace {
 const char *const programName = "CopyQ Clipboard Manager";
 const char *const mimeIgnore = COPYQ_MIME_PREFIX "ignore";
 
+/// Time to keep clipboard provider running after it lost clipboard ownership.
+int clipboardProviderIdleTimeoutMs()
+{
+#ifdef HAS_TESTS
+    bool ok;
+    const int timeoutMs = qgetenv("COPYQ_TESTS_CLIPBOARD_PROVIDER_IDLE_TIMEOUT").toInt(&ok);
+    if (ok)
+        return timeoutMs;
+#endif
+    return 30000;
+}
+
 QString helpHead()
 {
     return Scriptable::tr("Usage: copyq [%1]").arg(Scriptable::tr("COMMAND")) + "\n\n"
@@ -478,7 +494,9 @@ bool isInternalDataFormat(const QString &format)
         || format == mimeSelectedItems
         || format == mimeCurrentItem
         || format == mimeShortcut
-        || format == mimeOutputTab;
+        || format == mimeOutputTab
+        || format == mimeTraceEventId
+        || format == mimeClipboardSequence;
 }
 
 QVariantMap copyWithoutInternalData(const QVariantMap &data) {
@@ -521,6 +539,16 @@ QScriptValue checksumForArgument(Scriptable *scriptable, QCryptographicHash::Alg
     return QString::fromUtf8(hash);
 }
 
+/// Returns true if command can run in current Scriptable instead of spawning new process.
+bool isScriptCommand(const QList<QList<QStringList>> &cmd)
+{
+    const auto cmd1 = cmd.value(0).value(0);
+    return cmd.size() == 1 && cmd[0].size() == 1
+        && cmd1.size() >= 2
+        && cmd1[0] == "copyq"
+        && (!cmd1[1].startsWith("-") || cmd1[1] == "-e");
+}
+
 } // namespace
 
 Scriptable::Scriptable(
@@ -1182,6 +1210,26 @@ QScriptValue Scriptable::read()
     return newByteArray(result);
 }
 
+QScriptValue Scriptable::itemsData()
+{
+    m_skipArguments = -1;
+    return toScriptValue( m_proxy->browserItemsFormats(m_tabName, arguments()), this );
+}
+
+QScriptValue Scriptable::queryItemsIndex()
+{
+    auto args = currentArguments();
+    if (args.size() < 2) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    const auto format = args.takeFirst().toString();
+    const auto query = args.takeFirst().toString();
+    const auto result = m_proxy->browserItemsIndexQuery(m_tabName, format, query, args);
+    return result.isValid() ? toScriptValue(result, this) : QScriptValue();
+}
+
 void Scriptable::write()
 {
     m_skipArguments = -1;
@@ -1401,6 +1449,7 @@ QScriptValue Scriptable::info()
     info.insert("config", QSettings().fileName());
     info.insert("exe", QCoreApplication::applicationFilePath());
     info.insert("log", logFileName());
+    info.insert("trace", traceFileName());
 
     info.insert("plugins",
 #ifdef COPYQ_PLUGIN_PREFIX
@@ -1490,6 +1539,18 @@ QScriptValue Scriptable::info()
     return result;
 }
 
+QScriptValue Scriptable::trace()
+{
+    m_skipArguments = 0;
+    return newByteArray( readTrace() );
+}
+
+QScriptValue Scriptable::metrics()
+{
+    m_skipArguments = 0;
+    return newByteArray( m_proxy->metrics() );
+}
+
 QScriptValue Scriptable::eval()
 {
     const auto script = arg(0);
@@ -1776,6 +1837,11 @@ QScriptValue Scriptable::setSelectedItemData()
 
 QScriptValue Scriptable::selectedItemsData()
 {
+    if ( argumentCount() > 0 ) {
+        m_skipArguments = -1;
+        return toScriptValue( m_proxy->selectedItemsFormats(arguments()), this );
+    }
+
     return toScriptValue( m_proxy->selectedItemsData(), this );
 }
 
@@ -1786,6 +1852,34 @@ void Scriptable::setSelectedItemsData()
     m_proxy->setSelectedItemsData(dataList);
 }
 
+void Scriptable::patchSelectedItemsData()
+{
+    m_skipArguments = 1;
+    auto patches = fromScriptValue<QVector<QVariantMap>>( argument(0), this );
+
+    // Null values remove formats (send these as invalid values).
+    for (auto &patch : patches) {
+        for (auto &value : patch) {
+            if ( value.userType() == QMetaType::Nullptr )
+                value = QVariant();
+        }
+    }
+
+    m_proxy->patchSelectedItemsData(patches);
+}
+
+void Scriptable::addSelectedItemsListValue()
+{
+    m_skipArguments = 2;
+    m_proxy->addSelectedItemsListValue( arg(0), arg(1) );
+}
+
+void Scriptable::removeSelectedItemsListValue()
+{
+    m_skipArguments = 2;
+    m_proxy->removeSelectedItemsListValue( arg(0), arg(1) );
+}
+
 QScriptValue Scriptable::escapeHtml()
 {
     m_skipArguments = 1;
@@ -2243,6 +2337,9 @@ QScriptValue Scriptable::iconTagColor()
 
 void Scriptable::onClipboardChanged()
 {
+    TraceEventScope traceEventScope( m_data.value(mimeTraceEventId).toByteArray() );
+    COPYQ_TRACE("Scriptable::onClipboardChanged");
+
     eval(R"(
     if (!hasData()) {
         updateClipboardData();
@@ -2352,6 +2449,7 @@ void Scriptable::clearClipboardData()
 
 QScriptValue Scriptable::runAutomaticCommands()
 {
+    COPYQ_TRACE("Scriptable::runAutomaticCommands");
     return runCommands(CommandType::Automatic);
 }
 
@@ -2364,12 +2462,50 @@ void Scriptable::runDisplayCommands()
 void Scriptable::runMenuCommandFilters()
 {
     const auto matchCommands = m_proxy->menuItemMatchCommands(m_actionId);
+    if ( matchCommands.isEmpty() )
+        return;
 
-    for (int i = 0; i < matchCommands.length(); ++i) {
-        const bool enabled = canExecuteCommandFilter(matchCommands[i]);
-        if ( !m_proxy->enableMenuItem(m_actionId, i, enabled) )
-            return;
+    // Filters are independent so external commands run concurrently
+    // (scripts run in this process one by one).
+    const int maxRunningFilters = qMax(2, QThread::idealThreadCount());
+    int runningFilters = 0;
+    QVector<int> enabled(matchCommands.size(), 0);
+    std::vector< std::unique_ptr<Action> > actions;
+
+    QEventLoop loop;
+    connect(this, &Scriptable::finished, &loop, &QEventLoop::quit);
+
+    setActionData();
+
+    for (int i = 0; i < matchCommands.size() && canContinue(); ++i) {
+        std::unique_ptr<Action> action(new Action());
+        initCommandFilterAction(action.get(), matchCommands[i]);
+
+        if ( isScriptCommand(action->command()) ) {
+            enabled[i] = runAction(action.get()) && action->exitCode() == 0;
+            continue;
+        }
+
+        while ( runningFilters >= maxRunningFilters && canContinue() )
+            loop.exec();
+
+        connect( action.get(), &Action::actionFinished, &loop, [&, i](Action *act) {
+            enabled[i] = !act->actionFailed() && act->exitCode() == 0;
+            --runningFilters;
+            loop.quit();
+        });
+
+        action->setWorkingDirectory( m_dirClass->getCurrentPath() );
+        ++runningFilters;
+        action->start();
+        actions.push_back( std::move(action) );
     }
+
+    while ( runningFilters > 0 && canContinue() )
+        loop.exec();
+
+    if ( canContinue() )
+        m_proxy->enableMenuItems(m_actionId, enabled);
 }
 
 void Scriptable::monitorClipboard()
@@ -2415,6 +2551,8 @@ void Scriptable::onExecuteOutput(const QByteArray &output)
 
 void Scriptable::onMonitorClipboardChanged(const QVariantMap &data, ClipboardOwnership ownership)
 {
+    COPYQ_TRACE("Scriptable::onMonitorClipboardChanged");
+
     COPYQ_LOG( QString("onMonitorClipboardChanged: %1 %2, owner is \"%3\"")
                .arg(ownership == ClipboardOwnership::Own ? "own"
                   : ownership == ClipboardOwnership::Foreign ? "foreign"
@@ -2427,7 +2565,7 @@ void Scriptable::onMonitorClipboardChanged(const QVariantMap &data, ClipboardOwn
       : ownership == ClipboardOwnership::Hidden ? "copyq onHiddenClipboardChanged"
       : "copyq onClipboardChanged";
 
-    m_proxy->runInternalAction(data, command);
+    m_proxy->clipboardChanged(data, command);
 }
 
 void Scriptable::onSynchronizeSelection(ClipboardMode sourceMode, const QString &text, uint targetTextHash)
@@ -2810,12 +2948,8 @@ bool Scriptable::runAction(Action *action)
     // Shortcut to run script in current Scriptable
     // instead of spawning new process.
     const auto &cmd = action->command();
-    const auto cmd1 = cmd.value(0).value(0);
-    if ( cmd.size() == 1 && cmd[0].size() == 1
-         && cmd1.size() >= 2
-         && cmd1[0] == "copyq"
-         && (!cmd1[1].startsWith("-") || cmd1[1] == "-e") )
-    {
+    if ( isScriptCommand(cmd) ) {
+        const auto cmd1 = cmd[0][0];
         const auto oldInput = m_input;
         m_input = newByteArray(action->input());
 
@@ -2950,15 +3084,18 @@ bool Scriptable::canExecuteCommandFilter(const QString &matchCommand)
         return true;
 
     Action action;
+    initCommandFilterAction(&action, matchCommand);
+    return runAction(&action) && action.exitCode() == 0;
+}
 
+void Scriptable::initCommandFilterAction(Action *action, const QString &matchCommand)
+{
     const QString text = getTextData(m_data);
-    action.setInput(text.toUtf8());
-    action.setData(m_data);
+    action->setInput(text.toUtf8());
+    action->setData(m_data);
 
-    const QString arg = getTextData(action.input());
-    action.setCommand(matchCommand, QStringList(arg));
-
-    return runAction(&action) && action.exitCode() == 0;
+    const QString arg = getTextData(action->input());
+    action->setCommand(matchCommand, QStringList(arg));
 }
 
 bool Scriptable::verifyClipboardAccess()
@@ -2975,34 +3112,81 @@ void Scriptable::provideClipboard(ClipboardMode mode)
     if (!verifyClipboardAccess())
         return;
 
-    const auto owner = makeClipboardOwnerData();
-    m_data.insert(mimeOwner, owner);
+    QEventLoop loop;
+    connect( this, &Scriptable::finished, &loop, &QEventLoop::quit );
+
+    // Keep running for a while after losing clipboard ownership
+    // so server can pass new data without starting new process.
+    QTimer timerIdle;
+    timerIdle.setSingleShot(true);
+    timerIdle.setInterval(clipboardProviderIdleTimeoutMs());
+
+    QByteArray clipboardOwner;
+    QByteArray selectionOwner;
+    bool registered = false;
+    const auto ownerForMode = [&](ClipboardMode mode) -> QByteArray& {
+        return mode == ClipboardMode::Clipboard ? clipboardOwner : selectionOwner;
+    };
+
+    const auto provide = [&](QVariantMap data, ClipboardMode mode) {
+        const auto owner = makeClipboardOwnerData();
+        data.insert(mimeOwner, owner);
+        ownerForMode(mode) = owner;
+        timerIdle.stop();
 
-    createPlatformNativeInterface()->clipboard()->setData(mode, m_data);
+        createPlatformNativeInterface()->clipboard()->setData(mode, data);
 
-    QEventLoop loop;
+        COPYQ_LOG( QString("Started providing %1")
+                   .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection") );
+    };
 
     const auto checkClipboardOwnership = [&]() {
-        if ( clipboardOwnerData(mode) != owner )
+        for ( const auto mode : {ClipboardMode::Clipboard, ClipboardMode::Selection} ) {
+            auto &owner = ownerForMode(mode);
+            if ( !owner.isEmpty() && clipboardOwnerData(mode) != owner ) {
+                owner.clear();
+                COPYQ_LOG( QString("Finished providing %1")
+                           .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection") );
+            }
+        }
+
+        if ( !clipboardOwner.isEmpty() || !selectionOwner.isEmpty() )
+            return;
+
+        if (!registered)
             loop.quit();
+        else if ( !timerIdle.isActive() )
+            timerIdle.start();
     };
 
+    // Server must stop sending new data before the process exits, otherwise
+    // the data would be lost. Data sent before the server handled the request
+    // arrive while waiting for the call to finish and are still provided here.
+    const auto unregister = [&]() {
+        registered = false;
+        m_proxy->unregisterClipboardProvider();
+        COPYQ_LOG("Clipboard provider unregistered");
+        checkClipboardOwnership();
+    };
+    connect( &timerIdle, &QTimer::timeout, &loop, unregister );
+
     QTimer t;
     t.setInterval(8000);
     connect(&t, &QTimer::timeout, this, checkClipboardOwnership);
     t.start();
 
-    connect( this, &Scriptable::finished, &loop, &QEventLoop::quit );
     connect( QGuiApplication::clipboard(), &QClipboard::changed,
              &t, checkClipboardOwnership );
+    connect( m_proxy, &ScriptableProxy::provideClipboardRequested,
+             &t, provide );
 
-    COPYQ_LOG( QString("Started providing %1")
-               .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection") );
+    provide(m_data, mode);
+    m_proxy->registerClipboardProvider();
+    registered = true;
 
     loop.exec();
 
-    COPYQ_LOG( QString("Finished providing %1")
-               .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection") );
+    COPYQ_LOG("Clipboard provider finished");
 }
 
 void Scriptable::insert(int argumentsEnd)
@@ -3152,7 +3336,12 @@ void Scriptable::synchronizeSelection(ClipboardMode targetMode)
 
 void Scriptable::saveData(const QString &tab)
 {
-    const auto data = copyWithoutInternalData(m_data);
+    auto data = copyWithoutInternalData(m_data);
+
+    const QByteArray traceEventId = currentTraceEventId();
+    if ( !traceEventId.isEmpty() )
+        data.insert(mimeTraceEventId, traceEventId);
+
     const auto clipboardMode = isClipboardData(m_data)
             ? ClipboardMode::Clipboard
             : ClipboardMode::Selection;
@@ -209,6 +209,8 @@ public slots:
     void edit();
 
     QScriptValue read();
+    QScriptValue itemsData();
+    QScriptValue queryItemsIndex();
     void write();
     void change();
     void separator();
@@ -230,6 +232,10 @@ public slots:
 
     QScriptValue info();
 
+    QScriptValue trace();
+
+    QScriptValue metrics();
+
     QScriptValue eval();
 
     QScriptValue source();
@@ -271,6 +277,9 @@ public slots:
     QScriptValue setSelectedItemData();
     QScriptValue selectedItemsData();
     void setSelectedItemsData();
+    void patchSelectedItemsData();
+    void addSelectedItemsListValue();
+    void removeSelectedItemsListValue();
 
     QScriptValue escapeHtml();
     QScriptValue escapeHTML() { return escapeHtml(); }
@@ -389,6 +398,7 @@ private:
     bool runCommands(CommandType::CommandType type);
     bool canExecuteCommand(const Command &command);
     bool canExecuteCommandFilter(const QString &matchCommand);
+    void initCommandFilterAction(Action *action, const QString &matchCommand);
     bool verifyClipboardAccess();
     void provideClipboard(ClipboardMode mode);
 
@@ -20,6 +20,7 @@
 #include "scriptableproxy.h"
 
 #include "common/action.h"
+#include "common/actionhandlerenums.h"
 #include "common/appconfig.h"
 #include "common/command.h"
 #include "common/commandstatus.h"
@@ -29,9 +30,11 @@
 #include "common/contenttype.h"
 #include "common/display.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
 #include "common/settings.h"
 #include "common/textdata.h"
+#include "common/trace.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/filedialog.h"
 #include "gui/iconfactory.h"
@@ -272,6 +275,9 @@ namespace {
 const char propertyWidgetName[] = "CopyQ_widget_name";
 const char propertyWidgetProperty[] = "CopyQ_widget_property";
 
+/// Maximum line length decoded for notifications (lines are elided later).
+const int maxNotificationLineLength = 16 * 1024;
+
 struct InputDialog {
     QDialog *dialog = nullptr;
     QString defaultChoice; /// Default text for list widgets.
@@ -634,6 +640,77 @@ void raiseWindow(QPointer<QWidget> window)
         platformWindow->raise();
 }
 
+QVariantMap itemFormats(const QVariantMap &data, const QStringList &formats)
+{
+    QVariantMap formatData;
+    for (const auto &format : formats) {
+        const auto it = data.constFind(format);
+        if ( it != data.constEnd() )
+            formatData.insert( format, it.value() );
+    }
+    return formatData;
+}
+
+/**
+ * Applies patch to item data.
+ *
+ * Formats with invalid value are removed. Returns true if data changed.
+ */
+bool patchItemData(const QVariantMap &patch, QVariantMap *data)
+{
+    bool changed = false;
+    for (auto it = patch.constBegin(); it != patch.constEnd(); ++it) {
+        if ( !it.value().isValid() ) {
+            if ( data->remove(it.key()) > 0 )
+                changed = true;
+        } else if ( data->value(it.key()) != it.value() ) {
+            data->insert( it.key(), it.value() );
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/**
+ * Adds value to or removes value from sorted comma-separated list in given format.
+ *
+ * Format is removed if the list becomes empty. Returns true if data changed.
+ */
+bool changeItemList(const QString &format, const QString &value, bool add, QVariantMap *data)
+{
+    QStringList list = getTextData( data->value(format).toByteArray() )
+            .split(',', QString::SkipEmptyParts);
+
+    if (add) {
+        if ( list.contains(value) )
+            return false;
+        list.append(value);
+        list.sort();
+    } else if ( list.removeAll(value) == 0 ) {
+        return false;
+    }
+
+    if ( list.isEmpty() )
+        data->remove(format);
+    else
+        data->insert( format, list.join(",").toUtf8() );
+
+    return true;
+}
+
+MetricCounter &functionCallCounter(const QMetaMethod &method, int slotIndex)
+{
+    // Slots are called only from main thread.
+    static QHash<int, MetricCounter*> counters;
+    auto &counter = counters[slotIndex];
+    if (counter == nullptr) {
+        counter = &metricCounter(
+            "copyq_ipc_calls_total", "Number of scriptable function calls from clients.",
+            metricLabel("method", QString::fromUtf8(method.name())) );
+    }
+    return *counter;
+}
+
 } // namespace
 
 #ifdef HAS_TESTS
@@ -907,6 +984,8 @@ QByteArray ScriptableProxy::callFunctionHelper(const QByteArray &serializedFunct
     }
 
     const auto metaMethod = metaObject()->method(slotIndex);
+    functionCallCounter(metaMethod, slotIndex).add();
+
     const auto typeId = metaMethod.returnType();
 
     QGenericArgument args[9];
@@ -986,6 +1065,31 @@ void ScriptableProxy::setInputDialogResult(const QByteArray &bytes)
     emit inputDialogFinished(dialogId, result);
 }
 
+void ScriptableProxy::setProvideClipboardData(const QByteArray &bytes)
+{
+    QDataStream stream(bytes);
+    int mode;
+    QVariantMap data;
+    stream >> mode >> data;
+    if (stream.status() != QDataStream::Ok) {
+        log("Failed to read clipboard provider data", LogError);
+        Q_ASSERT(false);
+        return;
+    }
+    emit provideClipboardRequested(data, static_cast<ClipboardMode>(mode));
+}
+
+void ScriptableProxy::sendProvideClipboardData(const QVariantMap &data, ClipboardMode mode)
+{
+    QByteArray bytes;
+    {
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream << static_cast<int>(mode) << data;
+    }
+
+    emit sendMessage(bytes, CommandProvideClipboard);
+}
+
 void ScriptableProxy::safeDeleteLater()
 {
     m_shouldBeDeleted = true;
@@ -1157,13 +1261,44 @@ void ScriptableProxy::action(const QVariantMap &arg1, const Command &arg2)
     m_wnd->action(arg1, arg2, QModelIndex());
 }
 
+void ScriptableProxy::clipboardChanged(const QVariantMap &data, const QString &command)
+{
+    INVOKE_NO_SNIP2(clipboardChanged, (data, command));
+
+    const auto mode = isClipboardData(data) ? ClipboardMode::Clipboard : ClipboardMode::Selection;
+    m_wnd->clipboardSnapshot()->setData(data, mode);
+    runInternalAction(data, command);
+}
+
+void ScriptableProxy::registerClipboardProvider()
+{
+    INVOKE_NO_SNIP2(registerClipboardProvider, ());
+    m_wnd->setClipboardProvider(this);
+
+    // Provider process can crash or get killed without unregistering.
+    connect( this, &ScriptableProxy::clientDisconnected,
+             this, &ScriptableProxy::unregisterClipboardProvider,
+             Qt::UniqueConnection );
+}
+
+void ScriptableProxy::unregisterClipboardProvider()
+{
+    INVOKE_NO_SNIP2(unregisterClipboardProvider, ());
+    m_wnd->unsetClipboardProvider(this);
+}
+
 void ScriptableProxy::runInternalAction(const QVariantMap &data, const QString &command)
 {
     INVOKE_NO_SNIP2(runInternalAction, (data, command));
+
+    TraceEventScope traceEventScope( data.value(mimeTraceEventId).toByteArray() );
+    COPYQ_TRACE("ScriptableProxy::runInternalAction");
+
     auto action = new Action();
     action->setCommand(command);
     action->setData(data);
-    m_wnd->runInternalAction(action);
+    // Slow automatic commands must not delay handling other clipboard changes.
+    m_wnd->runInternalAction(action, ActionPriority::Immediate);
 }
 
 void ScriptableProxy::showMessage(const QString &title,
@@ -1351,21 +1486,18 @@ QVariant ScriptableProxy::toggleConfig(const QString &optionName)
 QByteArray ScriptableProxy::getClipboardData(const QString &mime, ClipboardMode mode)
 {
     INVOKE(getClipboardData, (mime, mode));
-    const QMimeData *data = clipboardData(mode);
-    if (!data)
-        return QByteArray();
+    auto snapshot = m_wnd->clipboardSnapshot();
 
     if (mime == "?")
-        return data->formats().join("\n").toUtf8() + '\n';
+        return snapshot->formats(mode).join("\n").toUtf8() + '\n';
 
-    return cloneData(*data, QStringList(mime)).value(mime).toByteArray();
+    return snapshot->data(mime, mode);
 }
 
 bool ScriptableProxy::hasClipboardFormat(const QString &mime, ClipboardMode mode)
 {
     INVOKE(hasClipboardFormat, (mime, mode));
-    const QMimeData *data = clipboardData(mode);
-    return data && data->hasFormat(mime);
+    return m_wnd->clipboardSnapshot()->hasFormat(mime, mode);
 }
 
 int ScriptableProxy::browserLength(const QString &tabName)
@@ -1432,6 +1564,45 @@ QVariantMap ScriptableProxy::browserItemData(const QString &tabName, int arg1)
     return itemData(tabName, arg1);
 }
 
+QVector<QVariantMap> ScriptableProxy::browserItemsFormats(const QString &tabName, const QStringList &formats)
+{
+    INVOKE(browserItemsFormats, (tabName, formats));
+
+    QVector<QVariantMap> dataList;
+    ClipboardBrowser *c = fetchBrowser(tabName);
+    if (!c)
+        return dataList;
+
+    dataList.reserve( c->length() );
+    for (int row = 0; row < c->length(); ++row) {
+        const auto data = c->copyIndex( c->index(row) );
+        dataList.append( formats.isEmpty() ? data : itemFormats(data, formats) );
+    }
+
+    return dataList;
+}
+
+QVariant ScriptableProxy::browserItemsIndexQuery(
+        const QString &tabName, const QString &format, const QString &query, const QVariantList &arguments)
+{
+    INVOKE(browserItemsIndexQuery, (tabName, format, query, arguments));
+
+    ClipboardBrowser *c = fetchBrowser(tabName);
+    if (!c)
+        return QVariant();
+
+    // Plugins can keep index of items in a format as child of the model named after the format.
+    QObject *index = c->model()->findChild<QObject*>(format, Qt::FindDirectChildrenOnly);
+    if (!index)
+        return QVariant();
+
+    QVariant result;
+    QMetaObject::invokeMethod(
+        index, "query", Qt::DirectConnection,
+        Q_RETURN_ARG(QVariant, result), Q_ARG(QString, query), Q_ARG(QVariantList, arguments) );
+    return result;
+}
+
 void ScriptableProxy::setCurrentTab(const QString &tabName)
 {
     INVOKE2(setCurrentTab, (tabName));
@@ -1567,6 +1738,65 @@ void ScriptableProxy::setSelectedItemsData(const QVector<QVariantMap> &dataList)
     }
 }
 
+QVector<QVariantMap> ScriptableProxy::selectedItemsFormats(const QStringList &formats)
+{
+    INVOKE(selectedItemsFormats, (formats));
+
+    auto c = currentBrowser();
+    if (!c)
+        return QVector<QVariantMap>();
+
+    const auto model = c->model();
+
+    QVector<QVariantMap> dataList;
+    const auto selected = selectedIndexes();
+    dataList.reserve(selected.size());
+
+    for (const auto &index : selected) {
+        if ( index.isValid() ) {
+            Q_ASSERT( index.model() == model );
+            dataList.append( itemFormats(c->copyIndex(index), formats) );
+        }
+    }
+
+    return dataList;
+}
+
+void ScriptableProxy::patchSelectedItemsData(const QVector<QVariantMap> &patches)
+{
+    INVOKE2(patchSelectedItemsData, (patches));
+
+    auto c = currentBrowser();
+    if (!c)
+        return;
+
+    const auto model = c->model();
+
+    const auto indexes = selectedIndexes();
+    const auto count = std::min( indexes.size(), patches.size() );
+    for ( int i = 0; i < count; ++i ) {
+        const auto &index = indexes[i];
+        if ( index.isValid() ) {
+            Q_ASSERT( index.model() == model );
+            auto data = model->data(index, contentType::data).toMap();
+            if ( patchItemData(patches[i], &data) )
+                model->setData(index, data, contentType::data);
+        }
+    }
+}
+
+void ScriptableProxy::addSelectedItemsListValue(const QString &format, const QString &value)
+{
+    INVOKE2(addSelectedItemsListValue, (format, value));
+    changeSelectedItemsList(format, value, true);
+}
+
+void ScriptableProxy::removeSelectedItemsListValue(const QString &format, const QString &value)
+{
+    INVOKE2(removeSelectedItemsListValue, (format, value));
+    changeSelectedItemsList(format, value, false);
+}
+
 #ifdef HAS_TESTS
 void ScriptableProxy::sendKeys(const QString &expectedWidgetName, const QString &keys, int delay)
 {
@@ -1867,6 +2097,32 @@ Qt::KeyboardModifiers ScriptableProxy::queryKeyboardModifiers()
     return QApplication::queryKeyboardModifiers();
 }
 
+QByteArray ScriptableProxy::metrics()
+{
+    INVOKE(metrics, ());
+
+    QVector<MetricSample> items;
+    QVector<MetricSample> bytes;
+    QVector<MetricSample> mappedBytes;
+    QVector<MetricSample> memory;
+    QVector<MetricSample> widgets;
+    for ( const auto c : m_wnd->loadedBrowsers() ) {
+        const auto label = metricLabel("tab", c->tabName());
+        items.append( MetricSample{label, c->length()} );
+        bytes.append( MetricSample{label, c->itemDataSize()} );
+        mappedBytes.append( MetricSample{label, c->itemMappedDataSize()} );
+        memory.append( MetricSample{label, c->memoryUsage()} );
+        widgets.append( MetricSample{label, c->itemWidgetCount()} );
+    }
+
+    return formatMetric("copyq_tab_items", "gauge", "Number of items in loaded tab.", items)
+         + formatMetric("copyq_tab_data_bytes", "gauge", "Size of item data in memory in loaded tab.", bytes)
+         + formatMetric("copyq_tab_mapped_data_bytes", "gauge", "Size of item data in memory-mapped tab file in loaded tab.", mappedBytes)
+         + formatMetric("copyq_tab_memory_bytes", "gauge", "Approximate memory used by items and item widgets in loaded tab.", memory)
+         + formatMetric("copyq_tab_item_widgets", "gauge", "Number of created item widgets in loaded tab.", widgets)
+         + metricsSnapshot();
+}
+
 QString ScriptableProxy::pluginsPath()
 {
     INVOKE_NO_SNIP(pluginsPath, ());
@@ -1965,7 +2221,7 @@ void ScriptableProxy::setTitleForData(const QVariantMap &data)
 {
     INVOKE2(setTitleForData, (data));
 
-    const QString clipboardContent = textLabelForData(data);
+    const QString clipboardContent = cachedTextLabelForData( m_wnd->labelDataHash(data), data, QFont(), QString() );
     setTitle(clipboardContent);
 }
 
@@ -1973,9 +2229,14 @@ void ScriptableProxy::saveData(const QString &tab, const QVariantMap &data, Clip
 {
     INVOKE2(saveData, (tab, data, mode));
 
+    TraceEventScope traceEventScope( data.value(mimeTraceEventId).toByteArray() );
+    COPYQ_TRACE("ScriptableProxy::saveData");
+
     auto c = m_wnd->tab(tab);
     if (c) {
-        c->addUnique(data, mode);
+        auto itemData = data;
+        itemData.remove(mimeTraceEventId);
+        c->addUnique(itemData, mode);
         c->setCurrent(0);
     }
 }
@@ -2008,21 +2269,30 @@ void ScriptableProxy::showDataNotification(const QVariantMap &data)
     if (data.isEmpty()) {
         notification->setInterval(0);
     } if ( !isHidden && data.contains(mimeText) ) {
-        QString text = getTextData(data);
-        const int n = text.count('\n') + 1;
-
-        QString format;
-        if (n > 1) {
-            format = QObject::tr("%1<div align=\"right\"><small>&mdash; %n lines &mdash;</small></div>",
-                                 "Notification label for multi-line text in clipboard", n);
-        } else {
-            format = QObject::tr("%1", "Notification label for single-line text in clipboard");
-        }
+        const QByteArray key = "notification:" + QByteArray::number( m_wnd->labelDataHash(data) )
+                + ':' + labelDataVerifier(data)
+                + ':' + font.key().toUtf8()
+                + ':' + QByteArray::number(width)
+                + ':' + QByteArray::number(maxLines);
+        const QString message = cachedLabel(key, [&]() {
+            const QByteArray bytes = data.value(mimeText).toByteArray();
+            const int n = bytes.count('\n') + 1;
+
+            QString format;
+            if (n > 1) {
+                format = QObject::tr("%1<div align=\"right\"><small>&mdash; %n lines &mdash;</small></div>",
+                                     "Notification label for multi-line text in clipboard", n);
+            } else {
+                format = QObject::tr("%1", "Notification label for single-line text in clipboard");
+            }
 
-        text = elideText(text, font, QString(), false, width, maxLines);
-        text = escapeHtml(text);
-        text.replace( QString("\n"), QString("<br />") );
-        notification->setMessage( format.arg(text), Qt::RichText );
+            QString text = getTextPreview(bytes, maxLines, maxNotificationLineLength);
+            text = elideText(text, font, QString(), false, width, maxLines);
+            text = escapeHtml(text);
+            text.replace( QString("\n"), QString("<br />") );
+            return format.arg(text);
+        });
+        notification->setMessage(message, Qt::RichText);
     } else if (!isHidden && imageIndex != -1) {
         QPixmap pix;
         const QString &imageFormat = formats[imageIndex];
@@ -2034,7 +2304,8 @@ void ScriptableProxy::showDataNotification(const QVariantMap &data)
 
         notification->setPixmap(pix);
     } else {
-        const QString text = textLabelForData(data, font, QString(), false, width, maxLines);
+        const QString text = cachedTextLabelForData(
+                    m_wnd->labelDataHash(data), data, font, QString(), false, width, maxLines);
         notification->setMessage(text, Qt::PlainText);
     }
 }
@@ -2045,10 +2316,10 @@ QStringList ScriptableProxy::menuItemMatchCommands(int actionId)
     return m_wnd->menuItemMatchCommands(actionId);
 }
 
-bool ScriptableProxy::enableMenuItem(int actionId, int menuItemMatchCommandIndex, bool enabled)
+bool ScriptableProxy::enableMenuItems(int actionId, const QVector<int> &enabled)
 {
-    INVOKE_NO_SNIP(enableMenuItem, (actionId, menuItemMatchCommandIndex, enabled));
-    return m_wnd->setMenuItemEnabled(actionId, menuItemMatchCommandIndex, enabled);
+    INVOKE_NO_SNIP(enableMenuItems, (actionId, enabled));
+    return m_wnd->setMenuItemsEnabled(actionId, enabled);
 }
 
 QVariantMap ScriptableProxy::setDisplayData(int actionId, const QVariantMap &displayData)
@@ -2120,6 +2391,24 @@ QByteArray ScriptableProxy::itemData(const QString &tabName, int i, const QStrin
     return data.value(mime).toByteArray();
 }
 
+void ScriptableProxy::changeSelectedItemsList(const QString &format, const QString &value, bool add)
+{
+    auto c = currentBrowser();
+    if (!c)
+        return;
+
+    const auto model = c->model();
+
+    for ( const auto &index : selectedIndexes() ) {
+        if ( index.isValid() ) {
+            Q_ASSERT( index.model() == model );
+            auto data = model->data(index, contentType::data).toMap();
+            if ( changeItemList(format, value, add, &data) )
+                model->setData(index, data, contentType::data);
+        }
+    }
+}
+
 ClipboardBrowser *ScriptableProxy::currentBrowser() const
 {
     const QString currentTabName = m_actionData.value(mimeCurrentTab).toString();
@@ -88,6 +88,10 @@ public:
 
     void setFunctionCallReturnValue(const QByteArray &bytes);
     void setInputDialogResult(const QByteArray &bytes);
+    void setProvideClipboardData(const QByteArray &bytes);
+
+    /// Sends new clipboard data to client running clipboard provider.
+    void sendProvideClipboardData(const QVariantMap &data, ClipboardMode mode);
 
     void safeDeleteLater();
 
@@ -121,7 +125,13 @@ public slots:
 
     void action(const QVariantMap &arg1, const Command &arg2);
 
+    /// Updates clipboard snapshot with data from monitor and runs command.
+    void clipboardChanged(const QVariantMap &data, const QString &command);
     void runInternalAction(const QVariantMap &data, const QString &command);
+    /// Registers calling client to receive new data to provide as clipboard.
+    void registerClipboardProvider();
+    /// Stops sending new clipboard data to calling client.
+    void unregisterClipboardProvider();
 
     void showMessage(const QString &title,
             const QString &msg,
@@ -166,6 +176,9 @@ public slots:
 
     QByteArray browserItemData(const QString &tabName, int arg1, const QString &arg2);
     QVariantMap browserItemData(const QString &tabName, int arg1);
+    QVector<QVariantMap> browserItemsFormats(const QString &tabName, const QStringList &formats);
+    QVariant browserItemsIndexQuery(
+            const QString &tabName, const QString &format, const QString &query, const QVariantList &arguments);
 
     void setCurrentTab(const QString &tabName);
 
@@ -182,6 +195,15 @@ public slots:
     QVector<QVariantMap> selectedItemsData();
     void setSelectedItemsData(const QVector<QVariantMap> &dataList);
 
+    /// Returns only given formats of selected items.
+    QVector<QVariantMap> selectedItemsFormats(const QStringList &formats);
+    /// Changes formats of selected items; invalid values remove formats.
+    void patchSelectedItemsData(const QVector<QVariantMap> &patches);
+    /// Adds value to sorted comma-separated list in given format of selected items.
+    void addSelectedItemsListValue(const QString &format, const QString &value);
+    /// Removes value from comma-separated list in given format of selected items.
+    void removeSelectedItemsListValue(const QString &format, const QString &value);
+
 #ifdef HAS_TESTS
     void sendKeys(const QString &expectedWidgetName, const QString &keys, int delay);
     bool sendKeysSucceeded();
@@ -212,6 +234,8 @@ public slots:
 
     Qt::KeyboardModifiers queryKeyboardModifiers();
 
+    QByteArray metrics();
+
     QString pluginsPath();
     QString themesPath();
     QString translationsPath();
@@ -232,7 +256,7 @@ public slots:
     void showDataNotification(const QVariantMap &data);
 
     QStringList menuItemMatchCommands(int actionId);
-    bool enableMenuItem(int actionId, int menuItemMatchCommandIndex, bool enabled);
+    bool enableMenuItems(int actionId, const QVector<int> &enabled);
 
     QVariantMap setDisplayData(int actionId, const QVariantMap &displayData);
 
@@ -245,6 +269,7 @@ public slots:
 signals:
     void functionCallFinished(int functionCallId, const QVariant &returnValue);
     void inputDialogFinished(int dialogId, const NamedValueList &result);
+    void provideClipboardRequested(const QVariantMap &data, ClipboardMode mode);
     void sendMessage(const QByteArray &message, int messageCode);
     void clientDisconnected();
 
@@ -256,6 +281,7 @@ private:
 
     ClipboardBrowser *currentBrowser() const;
     QList<QPersistentModelIndex> selectedIndexes() const;
+    void changeSelectedItemsList(const QString &format, const QString &value, bool add);
 
     QVariant waitForFunctionCallFinished(int functionId);
 
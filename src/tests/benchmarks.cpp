@@ -0,0 +1,333 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "benchmarks.h"
+#include "test_utils.h"
+
+#include "common/common.h"
+#include "common/mimetypes.h"
+#include "common/textdata.h"
+#include "gui/clipboardbrowser.h"
+#include "gui/clipboardbrowsershared.h"
+#include "item/clipboardmodel.h"
+#include "item/itemfactory.h"
+#include "item/itemstore.h"
+#include "item/serialize.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QMimeData>
+#include <QRegExp>
+
+#include <memory>
+
+namespace {
+
+/// Number of items in large tabs.
+const int largeTabItemCount = 10000;
+
+const auto benchmarkTabName = "BENCHMARK";
+
+QByteArray repeatedText(const QByteArray &text, int size)
+{
+    QByteArray result;
+    result.reserve(size);
+    while (result.size() < size)
+        result.append(text);
+    result.truncate(size);
+    return result;
+}
+
+/// Returns item data similar to data copied by users.
+QVariantMap createItemData(const QString &itemMix, int i)
+{
+    const QByteArray text = "Item " + QByteArray::number(i) + ": ";
+
+    QVariantMap data;
+    if (itemMix == "text") {
+        data.insert( mimeText, text + "Lorem ipsum dolor sit amet" );
+    } else if (itemMix == "html") {
+        data.insert( mimeText, repeatedText(text + "Lorem ipsum dolor sit amet. ", 1024) );
+        data.insert( mimeHtml, repeatedText("<p><b>" + text + "</b>Lorem ipsum dolor sit amet.</p>", 4096) );
+        data.insert( mimeWindowTitle, QByteArray("Web Browser") );
+    } else if (itemMix == "image") {
+        data.insert( "image/png", repeatedText(text + "\x89PNG\r\n\x1a\n", 256 * 1024) );
+        data.insert( mimeWindowTitle, QByteArray("Image Editor") );
+    } else if (itemMix == "formats") {
+        for (int j = 0; j < 10; ++j) {
+            data.insert( COPYQ_MIME_PREFIX "benchmark-" + QString::number(j),
+                         repeatedText(text, 100) );
+        }
+        data.insert( mimeText, text );
+    } else {
+        Q_ASSERT(false);
+    }
+
+    return data;
+}
+
+QList<QVariantMap> createItemDataList(const QString &itemMix, int count)
+{
+    QList<QVariantMap> dataList;
+    dataList.reserve(count);
+    for (int i = 0; i < count; ++i)
+        dataList.append( createItemData(itemMix, i) );
+    return dataList;
+}
+
+bool reverseRows(const QModelIndex &lhs, const QModelIndex &rhs)
+{
+    return lhs.row() > rhs.row();
+}
+
+void addItemMixRows()
+{
+    QTest::addColumn<QString>("itemMix");
+
+    for ( const auto &itemMix : {"text", "html", "image", "formats"} )
+        QTest::newRow(itemMix) << QString(itemMix);
+}
+
+} // namespace
+
+Benchmarks::Benchmarks(const TestInterfacePtr &test, QObject *parent)
+    : QObject(parent)
+    , m_test(test)
+{
+}
+
+void Benchmarks::serializeItem_data()
+{
+    addItemMixRows();
+}
+
+void Benchmarks::serializeItem()
+{
+    QFETCH(QString, itemMix);
+    const auto data = createItemData(itemMix, 0);
+
+    QByteArray bytes;
+    QBENCHMARK {
+        bytes = serializeData(data);
+    }
+
+    QVERIFY( !bytes.isEmpty() );
+}
+
+void Benchmarks::deserializeItem_data()
+{
+    addItemMixRows();
+}
+
+void Benchmarks::deserializeItem()
+{
+    QFETCH(QString, itemMix);
+    const auto data = createItemData(itemMix, 0);
+    const auto bytes = serializeData(data);
+
+    QVariantMap data2;
+    QBENCHMARK {
+        data2.clear();
+        deserializeData(&data2, bytes);
+    }
+
+    QCOMPARE( data2, data );
+}
+
+void Benchmarks::serializeTab()
+{
+    ClipboardModel model;
+    model.insertItems( createItemDataList("html", largeTabItemCount), 0 );
+
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY( serializeData(model, &buffer) );
+    }
+}
+
+void Benchmarks::deserializeTab()
+{
+    ClipboardModel model;
+    model.insertItems( createItemDataList("html", largeTabItemCount), 0 );
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY( serializeData(model, &buffer) );
+    buffer.close();
+
+    QBENCHMARK {
+        ClipboardModel model2;
+        buffer.open(QIODevice::ReadOnly);
+        QVERIFY( deserializeData(&model2, &buffer, largeTabItemCount) );
+        buffer.close();
+        QCOMPARE( model2.rowCount(), largeTabItemCount );
+    }
+}
+
+void Benchmarks::hashItem_data()
+{
+    addItemMixRows();
+}
+
+void Benchmarks::hashItem()
+{
+    QFETCH(QString, itemMix);
+    const auto data = createItemData(itemMix, 0);
+
+    uint result = 0;
+    QBENCHMARK {
+        result ^= hash(data);
+    }
+
+    Q_UNUSED(result);
+}
+
+void Benchmarks::cloneMimeData_data()
+{
+    addItemMixRows();
+}
+
+void Benchmarks::cloneMimeData()
+{
+    QFETCH(QString, itemMix);
+    const auto data = createItemData(itemMix, 0);
+    std::unique_ptr<QMimeData> mimeData( createMimeData(data) );
+    const QStringList formats = data.keys();
+
+    QVariantMap data2;
+    QBENCHMARK {
+        data2 = cloneData(*mimeData, formats);
+    }
+
+    QVERIFY( !data2.isEmpty() );
+}
+
+void Benchmarks::modelInsertAtTop()
+{
+    const auto dataList = createItemDataList("text", largeTabItemCount);
+
+    QBENCHMARK {
+        ClipboardModel model;
+        for (const auto &data : dataList)
+            model.insertItem(data, 0);
+        QCOMPARE( model.rowCount(), largeTabItemCount );
+    }
+}
+
+void Benchmarks::modelMoveToTop()
+{
+    ClipboardModel model;
+    model.insertItems( createItemDataList("text", largeTabItemCount), 0 );
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i)
+            model.moveRows(QModelIndex(), largeTabItemCount - 1, 1, QModelIndex(), 0);
+    }
+
+    QCOMPARE( model.rowCount(), largeTabItemCount );
+}
+
+void Benchmarks::modelRemoveFromTop()
+{
+    ClipboardModel model;
+    model.insertItems( createItemDataList("text", largeTabItemCount), 0 );
+
+    QBENCHMARK_ONCE {
+        while ( model.rowCount() > 0 )
+            model.removeRows(0, 1);
+    }
+}
+
+void Benchmarks::modelReverseItems()
+{
+    ClipboardModel model;
+    model.insertItems( createItemDataList("text", largeTabItemCount), 0 );
+
+    QModelIndexList indexes;
+    for (int row = 0; row < largeTabItemCount; ++row)
+        indexes.append( model.index(row) );
+
+    QBENCHMARK {
+        model.sortItems(indexes, &reverseRows);
+    }
+
+    QCOMPARE( model.rowCount(), largeTabItemCount );
+}
+
+void Benchmarks::filterItems_data()
+{
+    QTest::addColumn<QString>("pattern");
+
+    QTest::newRow("match one") << QString("Item 9999:");
+    QTest::newRow("match all") << QString("Lorem");
+    QTest::newRow("match none") << QString("xxx");
+}
+
+void Benchmarks::filterItems()
+{
+    QFETCH(QString, pattern);
+
+    ItemFactory itemFactory;
+    itemFactory.loadPlugins();
+
+    const auto sharedData = std::make_shared<ClipboardBrowserShared>();
+    sharedData->itemFactory = &itemFactory;
+    sharedData->maxItems = largeTabItemCount;
+
+    removeItems(benchmarkTabName);
+
+    {
+        ClipboardBrowser browser(benchmarkTabName, sharedData);
+        QVERIFY( browser.loadItems() );
+
+        for (int i = 0; i < largeTabItemCount; ++i)
+            QVERIFY( browser.add(createItemData("text", i), 0) );
+
+        const QRegExp re(pattern, Qt::CaseInsensitive);
+        QBENCHMARK {
+            browser.filterItems(re);
+            browser.filterItems(QRegExp());
+        }
+    }
+
+    removeItems(benchmarkTabName);
+}
+
+void Benchmarks::proxyCalls_data()
+{
+    QTest::addColumn<int>("callCount");
+
+    QTest::newRow("client only") << 0;
+    QTest::newRow("1000 calls") << 1000;
+}
+
+void Benchmarks::proxyCalls()
+{
+    QFETCH(int, callCount);
+
+    TEST( m_test->init() );
+
+    const auto script = QString("for (var i = 0; i < %1; ++i) tabs()").arg(callCount);
+    QBENCHMARK {
+        QCOMPARE( m_test->run(Args("eval") << script), 0 );
+    }
+
+    TEST( m_test->stopServer() );
+}
@@ -0,0 +1,70 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include "tests/testinterface.h"
+
+#include <QObject>
+
+/**
+ * Performance benchmarks for core data paths.
+ *
+ * Run with "copyq benchmarks" (results are printed as CSV by default).
+ */
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Benchmarks(const TestInterfacePtr &test, QObject *parent = nullptr);
+
+private slots:
+    void serializeItem_data();
+    void serializeItem();
+
+    void deserializeItem_data();
+    void deserializeItem();
+
+    void serializeTab();
+    void deserializeTab();
+
+    void hashItem_data();
+    void hashItem();
+
+    void cloneMimeData_data();
+    void cloneMimeData();
+
+    void modelInsertAtTop();
+    void modelMoveToTop();
+    void modelRemoveFromTop();
+    void modelReverseItems();
+
+    void filterItems_data();
+    void filterItems();
+
+    void proxyCalls_data();
+    void proxyCalls();
+
+private:
+    TestInterfacePtr m_test;
+};
+
+#endif // BENCHMARKS_H
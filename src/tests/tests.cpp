@@ -19,16 +19,20 @@
 
 #include "tests.h"
 #include "test_utils.h"
+#include "benchmarks.h"
 
+#include "app/clipboardsnapshot.h"
 #include "common/appconfig.h"
 #include "common/client_server.h"
 #include "common/common.h"
 #include "common/config.h"
+#include "common/contenttype.h"
 #include "common/mimetypes.h"
 #include "common/settings.h"
 #include "common/shortcuts.h"
 #include "common/textdata.h"
 #include "common/version.h"
+#include "item/clipboarditem.h"
 #include "item/itemfactory.h"
 #include "item/itemwidget.h"
 #include "item/serialize.h"
@@ -36,12 +40,15 @@
 #include "gui/tabicons.h"
 #include "platform/platformnativeinterface.h"
 
+#include <QApplication>
 #include <QClipboard>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
+#include <QFont>
 #include <QGuiApplication>
 #include <QMap>
 #include <QMimeData>
@@ -70,6 +77,9 @@ const auto clipboardTabName = "CLIPBOARD";
 const auto defaultSessionColor = "#ff8800";
 const auto defaultTagColor = "#000000";
 
+/// Short idle interval so tests can wait for clipboard provider to exit.
+const int clipboardProviderIdleTimeoutMs = 2000;
+
 const auto clipboardBrowserId = "focus:ClipboardBrowser";
 const auto trayMenuId = "focus:TrayMenu";
 const auto menuId = "focus:Menu";
@@ -186,6 +196,8 @@ public:
     {
         m_env.insert("COPYQ_LOG_LEVEL", "DEBUG");
         m_env.insert("COPYQ_SESSION_COLOR", defaultSessionColor);
+        m_env.insert("COPYQ_TESTS_CLIPBOARD_PROVIDER_IDLE_TIMEOUT",
+                     QString::number(clipboardProviderIdleTimeoutMs));
     }
 
     ~TestInterfaceImpl()
@@ -687,6 +699,91 @@ void Tests::commandVersion()
     QVERIFY( version.contains(QRegExp("\\bQt:\\s+\\d")) );
 }
 
+void Tests::commandTrace()
+{
+    QByteArray stdoutActual;
+    QByteArray stderrActual;
+    QCOMPARE( run(Args("trace"), &stdoutActual, &stderrActual), 0 );
+    QVERIFY2( testStderr(stderrActual), stderrActual );
+    QVERIFY( stdoutActual.startsWith("{\"traceEvents\":[") );
+}
+
+void Tests::commandMetrics()
+{
+    RUN("add" << "A" << "B", "");
+
+    QByteArray stdoutActual;
+    QByteArray stderrActual;
+    QCOMPARE( run(Args("metrics"), &stdoutActual, &stderrActual), 0 );
+    QVERIFY2( testStderr(stderrActual), stderrActual );
+    QVERIFY2( stdoutActual.contains("\ncopyq_tab_items{tab=\"" + QByteArray(clipboardTabName) + "\"} 2\n"), stdoutActual );
+    QVERIFY2( stdoutActual.contains("\ncopyq_ipc_calls_total{method=\"metrics\"} "), stdoutActual );
+}
+
+void Tests::memoryBudget()
+{
+    RUN("config" << "memory_budget" << "1", "1\n");
+
+    const auto tab = testTab(1);
+    const QByteArray tabMetric = "copyq_tab_items{tab=\"" + tab.toUtf8() + "\"}";
+
+    // Tab with items exceeding memory budget is unloaded.
+    RUN("tab" << tab << "eval" << "add(Array(2 * 1024 * 1024).join('x'))", "");
+    QByteArray out;
+    WAIT_UNTIL(Args("metrics"), !out.contains(tabMetric), out);
+
+    // Items are loaded again when needed.
+    RUN("tab" << tab << "size", "1\n");
+}
+
+void Tests::memoryBudgetExcludesMappedData()
+{
+#ifndef Q_OS_UNIX
+    SKIP("Tab files are memory-mapped only on UNIX");
+#endif
+
+    const auto tab = testTab(1);
+    const QByteArray tabMetric = "copyq_tab_items{tab=\"" + tab.toUtf8() + "\"} 1\n";
+    const QByteArray mappedMetric = "copyq_tab_mapped_data_bytes{tab=\"" + tab.toUtf8() + "\"} ";
+
+    // Tab file large enough to be memory-mapped when loaded.
+    RUN("tab" << tab << "eval" << "add(Array(2 * 1024 * 1024).join('x'))", "");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    RUN("config" << "memory_budget" << "1", "1\n");
+    RUN("tab" << tab << "size", "1\n");
+
+    // Mapped item data are not counted to memory budget so the tab is kept.
+    waitFor(2000);
+    QByteArray stdoutActual;
+    QByteArray stderrActual;
+    QCOMPARE( run(Args("metrics"), &stdoutActual, &stderrActual), 0 );
+    QVERIFY2( testStderr(stderrActual), stderrActual );
+    QVERIFY2( stdoutActual.contains(tabMetric), stdoutActual );
+    QVERIFY2( stdoutActual.contains(mappedMetric), stdoutActual );
+    QVERIFY2( !stdoutActual.contains(mappedMetric + "0\n"), stdoutActual );
+}
+
+void Tests::memoryBudgetKeepsClipboardTab()
+{
+    RUN("hide", "");
+    RUN("config" << "memory_budget" << "1", "1\n");
+
+    const QByteArray tabMetric = "copyq_tab_items{tab=\"" + QByteArray(clipboardTabName) + "\"} 1\n";
+
+    // Clipboard tab is not unloaded even if it alone exceeds memory budget.
+    RUN("eval" << "add(Array(2 * 1024 * 1024).join('x'))", "");
+    waitFor(2000);
+
+    QByteArray stdoutActual;
+    QByteArray stderrActual;
+    QCOMPARE( run(Args("metrics"), &stdoutActual, &stderrActual), 0 );
+    QVERIFY2( testStderr(stderrActual), stderrActual );
+    QVERIFY2( stdoutActual.contains(tabMetric), stdoutActual );
+}
+
 void Tests::badCommand()
 {
     RUN_EXPECT_ERROR_WITH_STDERR("xxx", CommandException, "xxx");
@@ -1026,6 +1123,181 @@ void Tests::commandsPackUnpack()
     }
 }
 
+void Tests::serializeDataVersions()
+{
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("plain text") );
+    data.insert( mimeHtml, QByteArray("<b>HTML text</b>") );
+    data.insert( "image/png", QByteArray("PNG") );
+    data.insert( "application/x-copyq-test-unknown", QByteArray("unknown") );
+    data.insert( "x-test/unknown", QByteArray() );
+
+    for ( const auto version : {DataVersion::V2, DataVersion::V3} ) {
+        QByteArray bytes;
+        {
+            QDataStream stream(&bytes, QIODevice::WriteOnly);
+            serializeData(&stream, data, version);
+        }
+
+        QDataStream stream(bytes);
+        qint32 header;
+        stream >> header;
+        QCOMPARE( header, version == DataVersion::V3 ? -3 : -2 );
+
+        QVariantMap data2;
+        QVERIFY( deserializeData(&data2, bytes) );
+        QCOMPARE( data2, data );
+    }
+
+    // Data passed to other processes and apps can be read by older versions.
+    {
+        QDataStream stream( serializeData(data) );
+        qint32 header;
+        stream >> header;
+        QCOMPARE( header, -2 );
+    }
+
+    // Unknown format ID.
+    QByteArray bytes;
+    {
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream << static_cast<qint32>(-3) << static_cast<qint32>(1)
+               << static_cast<quint8>(255) << QByteArray("data");
+    }
+    QVariantMap data3;
+    QVERIFY( !deserializeData(&data3, bytes) );
+}
+
+void Tests::mimeAtomLimit()
+{
+    // Formats over the limit of interned MIME types are kept with items.
+    QVariantMap data;
+    for (int i = 0; i < maxMimeAtomCount + 10; ++i)
+        data.insert( QString("x-test/atom-limit-%1").arg(i), QByteArray::number(i) );
+
+    ClipboardItem item(data);
+    QCOMPARE( item.data(contentType::data).toMap(), data );
+
+    const QString lastFormat = QString("x-test/atom-limit-%1").arg(maxMimeAtomCount + 9);
+    QVERIFY( !isInternedMimeAtom(mimeAtom(lastFormat)) );
+    QCOMPARE( item.data(lastFormat), QByteArray::number(maxMimeAtomCount + 9) );
+
+    item.setData( lastFormat, QByteArray("changed") );
+    QCOMPARE( item.data(lastFormat), QByteArray("changed") );
+
+    item.removeData(lastFormat);
+    QCOMPARE( item.data(lastFormat), QByteArray() );
+    QCOMPARE( item.data(contentType::data).toMap().size(), data.size() - 1 );
+}
+
+void Tests::textDataPreview()
+{
+    // Leading empty lines are kept and not counted.
+    QCOMPARE( getTextPreview("\n\nA\nB\nC", 2, 100), QString("\n\nA\nB\n") );
+    QCOMPARE( getTextPreview("A\nB", 2, 100), QString("A\nB") );
+    QCOMPARE( getTextPreview("A\nB\n", 2, 100), QString("A\nB\n") );
+
+    // Lines are cut without splitting multi-byte characters.
+    const QByteArray bytes = "\xc3\xa9\xc3\xa9\xc3\xa9\nx\xe2\x82\xac\xe2\x82\xac";
+    QCOMPARE( getTextPreview(bytes, 10, 2), QString::fromUtf8("\xc3\xa9\xc3\xa9\nx\xe2\x82\xac") );
+
+    const QString text = QString::fromUtf8("a\n\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\nb");
+    const TextMetadata metadata = textMetadata( text.toUtf8() );
+    QCOMPARE( metadata.length, text.size() );
+    QCOMPARE( metadata.lineCount, 3 );
+
+    QCOMPARE( textMetadata(QByteArray()).length, 0 );
+    QCOMPARE( textMetadata(QByteArray()).lineCount, 1 );
+
+    // Metadata is stored with item and updated when data changes.
+    ClipboardItem item( createDataMap(mimeText, text.toUtf8()) );
+    QCOMPARE( item.data(contentType::textLength).toInt(), text.size() );
+    QCOMPARE( item.data(contentType::textLineCount).toInt(), 3 );
+
+    item.setData( mimeText, QByteArray("X\nY") );
+    QCOMPARE( item.data(contentType::textLength).toInt(), 3 );
+    QCOMPARE( item.data(contentType::textLineCount).toInt(), 2 );
+
+    // Label uses given line count instead of counting lines in data.
+    const QVariantMap data = createDataMap(mimeText, QByteArray("X\nY"));
+    QCOMPARE( textLabelForData(data, QFont(), QString(), false, -1, 1, 2),
+              textLabelForData(data, QFont(), QString(), false, -1, 1) );
+}
+
+void Tests::textDataChunks()
+{
+    // Multi-byte characters (2, 3 and 4 bytes) are never split between chunks.
+    const QString text = QString::fromUtf8("ab\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80" "c\xe2\x82\xac\xc3\xa9");
+    const QByteArray bytes = text.toUtf8();
+
+    for (int maxSize = 1; maxSize <= bytes.size(); ++maxSize) {
+        QString decoded;
+        int position = 0;
+        while ( position < bytes.size() ) {
+            const int oldPosition = position;
+            const QString chunk = getTextDataChunk(bytes, &position, maxSize);
+            QVERIFY2( position > oldPosition, qPrintable(QString::number(maxSize)) );
+            QVERIFY( !chunk.contains(QChar::ReplacementCharacter) );
+            decoded.append(chunk);
+        }
+        QCOMPARE( position, bytes.size() );
+        QCOMPARE( decoded, text );
+    }
+
+    QCOMPARE( getTextData(bytes, 3), text.left(3) );
+    QCOMPARE( getTextData(bytes, 100), text );
+}
+
+void Tests::cachedLabelSameHash()
+{
+    // Colliding data hash must not return label for other data.
+    const uint dataHash = 0xC0FFEE;
+    const QVariantMap data1 = createDataMap(mimeText, QByteArray("A"));
+    const QVariantMap data2 = createDataMap(mimeText, QByteArray("B"));
+    QCOMPARE( cachedTextLabelForData(dataHash, data1, QFont(), QString()), QString("A") );
+    QCOMPARE( cachedTextLabelForData(dataHash, data2, QFont(), QString()), QString("B") );
+    QVERIFY( labelDataVerifier(data1) != labelDataVerifier(data2) );
+
+    // Labels for big data are cached too.
+    const QVariantMap bigData = createDataMap(mimeText, QByteArray(16 * 1024 * 1024, 'x'));
+    const QByteArray key = "test:cachedLabelSameHash:" + labelDataVerifier(bigData);
+    int created = 0;
+    QCOMPARE( cachedLabel(key, [&]() { ++created; return QString("X"); }), QString("X") );
+    QCOMPARE( cachedLabel(key, [&]() { ++created; return QString("Y"); }), QString("X") );
+    QCOMPARE( created, 1 );
+}
+
+void Tests::clipboardSnapshotDropsStaleData()
+{
+    ClipboardSnapshot snapshot;
+    const auto mode = ClipboardMode::Clipboard;
+
+    QVariantMap data = createDataMap(mimeText, QByteArray("OLD"));
+    const qint64 oldSequence = clipboardChangeSequence();
+    data.insert( mimeClipboardSequence, QByteArray::number(oldSequence) );
+
+    QVariantMap newData = createDataMap(mimeText, QByteArray("NEW"));
+    newData.insert( mimeClipboardSequence, QByteArray::number(oldSequence + 1) );
+
+    snapshot.setData(newData, mode);
+    QCOMPARE( snapshot.data(mimeText, mode), QByteArray("NEW") );
+
+    // Report delayed by monitor must not replace newer data.
+    snapshot.setData(data, mode);
+    QCOMPARE( snapshot.data(mimeText, mode), QByteArray("NEW") );
+
+    // Data read before clipboard changed are stale too.
+    TEST( m_test->setClipboard("CURRENT") );
+    snapshot.invalidate(mode);
+    newData[mimeClipboardSequence] = QByteArray::number(oldSequence + 2);
+    snapshot.setData(newData, mode);
+    QCOMPARE( snapshot.data(mimeText, mode), QByteArray("CURRENT") );
+
+    newData[mimeClipboardSequence] = QByteArray::number(clipboardChangeSequence() + 1);
+    snapshot.setData(newData, mode);
+    QCOMPARE( snapshot.data(mimeText, mode), QByteArray("NEW") );
+}
+
 void Tests::commandsBase64()
 {
     const QByteArray data = "0123456789\001\002\003\004\005\006\007abcdefghijklmnopqrstuvwxyz!";
@@ -1996,6 +2268,35 @@ void Tests::itemToClipboard()
     RUN("clipboard", "TESTING1");
 }
 
+void Tests::pasteAfterClipboardProviderIdle()
+{
+    RUN("copy" << "A", "true\n");
+    WAIT_FOR_CLIPBOARD("A");
+
+    // Wait for clipboard provider process to take over the clipboard.
+    waitFor(5000);
+    RUN("clipboard", "A");
+
+    // Provider loses clipboard ownership and exits after idle timeout.
+    TEST( m_test->setClipboard("B") );
+    WAIT_FOR_CLIPBOARD("B");
+    waitFor(clipboardProviderIdleTimeoutMs + 1000);
+
+    RUN("copy" << "C", "true\n");
+    WAIT_FOR_CLIPBOARD("C");
+    RUN("clipboard", "C");
+
+    // New provider process must take over the clipboard.
+    waitFor(5000);
+    RUN("clipboard", "C");
+
+    // The new provider receives data right away.
+    RUN("copy" << "D", "true\n");
+    WAIT_FOR_CLIPBOARD("D");
+    waitFor(waitMsPasteClipboard);
+    RUN("clipboard", "D");
+}
+
 void Tests::tabAdd()
 {
     const QString tab = testTab(1);
@@ -2017,6 +2318,52 @@ void Tests::tabAdd()
     RUN(args << "read" << "0" << "1" << "2", "abc def ghi");
 }
 
+void Tests::tabMappedSaveAndReload()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab << "separator" << " ";
+
+    // Tab file large enough to be memory-mapped when loaded.
+    RUN(args << "eval" << "add(Array(2 * 1024 * 1024).join('x') + 'END')", "");
+    RUN(args << "add" << "B" << "A", "");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    // Saving tab replaces the mapped file with new one.
+    RUN(args << "add" << "C", "");
+    RUN(args << "read" << "0" << "1" << "2", "C A B");
+    RUN(args << "-e" << "str(read(3)).slice(-3)", "END\n");
+
+    RUN(args << "remove" << "1", "");
+    RUN(args << "-e" << "str(read(2)).slice(-3)", "END\n");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    RUN(args << "size", "3\n");
+    RUN(args << "read" << "0" << "1", "C B");
+    RUN(args << "-e" << "str(read(2)).length", QString::number(2 * 1024 * 1024 - 1 + 3) + "\n");
+}
+
+void Tests::tabMappedCopyToClipboard()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab;
+
+    // Tab file large enough to be memory-mapped when loaded.
+    RUN(args << "eval" << "add(Array(2 * 1024 * 1024).join('x') + 'END')", "");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    // Clipboard keeps the data after the tab with mapped file is removed.
+    RUN(args << "select" << "0", "");
+    RUN("removetab" << tab, "");
+    WAIT_ON_OUTPUT("-e" << "str(clipboard()).slice(-3)", "END\n");
+    RUN("-e" << "str(clipboard()).length", QString::number(2 * 1024 * 1024 - 1 + 3) + "\n");
+}
+
 void Tests::tabRemove()
 {
     const QString tab = testTab(1);
@@ -2070,6 +2417,28 @@ void Tests::action()
     RUN(args << "read" << "0" << "1" << "2", "C\nB\nA");
 }
 
+void Tests::actionQueue()
+{
+    // Run commands one by one.
+    RUN("config" << "max_running_commands" << "1", "1\n");
+
+    const Args args = Args("tab") << testTab(1);
+    const QString command = "copyq eval 'sleep(1000); print(\"%1\")'";
+    for (int i = 1; i <= 4; ++i)
+        RUN(Args(args) << "action" << command.arg(i) << "", "");
+
+    // Commands over the limit wait in queue.
+    QByteArray out;
+    TEST( m_test->getClientOutput(Args("metrics"), &out) );
+    QRegExp queuedRe("\ncopyq_actions_queued\\{priority=\"interactive\"\\} ([0-9]+)\n");
+    QVERIFY2( queuedRe.indexIn(QString::fromUtf8(out)) != -1, out );
+    QVERIFY2( queuedRe.cap(1).toInt() > 0, out );
+
+    // Queued commands start in order.
+    WAIT_ON_OUTPUT(args << "size", "4\n");
+    RUN(args << "read" << "0" << "1" << "2" << "3", "4\n3\n2\n1");
+}
+
 void Tests::insertRemoveItems()
 {
     const Args args = Args("tab") << testTab(1) << "separator" << ",";
@@ -2616,6 +2985,64 @@ void Tests::shortcutCommandMatchCmd()
     WAIT_ON_OUTPUT(args << "keys('Ctrl+F1'); read(0)", "test2");
 }
 
+void Tests::shortcutCommandMatchCmdCached()
+{
+    const auto tab = testTab(1);
+    const Args args = Args("tab") << tab;
+
+    RUN("config" << "menu_filter_cache_ttl" << "60000", "60000\n");
+
+    // Filter adds an item to other tab each time it runs for item "A".
+    const auto script = R"(
+        setCommands([{
+            name: 'test',
+            inMenu: true,
+            shortcuts: ['Ctrl+F1'],
+            matchCmd: 'copyq: if (str(data(mimeText)) == "A") { tab(")" + tab + R"("); add("filter") }',
+            cmd: 'copyq tab )" + tab + R"( add done'
+        }])
+        )";
+    RUN(script, "");
+
+    RUN("add" << "B" << "A", "");
+    RUN("selectItems" << "0", "true\n");
+    WAIT_ON_OUTPUT(args << "size", "1\n");
+
+    // Cached result is used when the item is selected again.
+    RUN("selectItems" << "1", "true\n");
+    waitFor(1000);
+    RUN("selectItems" << "0", "true\n");
+    waitFor(1000);
+    RUN("keys" << "CTRL+F1", "");
+    WAIT_ON_OUTPUT(args << "read" << "0", "done");
+    RUN(args << "size", "2\n");
+}
+
+void Tests::shortcutCommandMatchCmdConcurrent()
+{
+    const auto tab = testTab(1);
+    const Args args = Args("tab") << tab;
+
+    // External filters add an item to other tab and run for a long time.
+    const auto script = R"(
+        function cmd(name) {
+          return {
+            name: name,
+            inMenu: true,
+            matchCmd: "copyq tab )" + tab + R"( eval 'add(\"" + name + "\"); sleep(15000)'",
+            cmd: 'copyq add ' + name
+          }
+        }
+        setCommands([ cmd('test1'), cmd('test2') ])
+        )";
+    RUN(script, "");
+
+    RUN("add" << "A", "");
+
+    // Second filter starts before the first one finishes.
+    WAIT_ON_OUTPUT(args << "size", "2\n");
+}
+
 void Tests::shortcutCommandSelectedItemData()
 {
     const auto tab1 = testTab(1);
@@ -2696,6 +3123,29 @@ void Tests::shortcutCommandSetSelectedItemsData()
     WAIT_ON_OUTPUT("read" << "0" << "1" << "2", "A\nX\nY");
 }
 
+void Tests::shortcutCommandPatchSelectedItemsData()
+{
+    const auto script = R"(
+        setCommands([{
+            name: 'Patch Selected Items',
+            inMenu: true,
+            shortcuts: ['Ctrl+F1'],
+            cmd: 'copyq: patchSelectedItemsData([{"DATA": "X", "text/plain": null}, {"DATA": "Y"}]);'
+               + 'addSelectedItemsListValue("LIST", "b");'
+               + 'addSelectedItemsListValue("LIST", "a");'
+               + 'removeSelectedItemsListValue("LIST", "b");'
+        }])
+        )";
+    RUN(script, "");
+
+    RUN("add" << "C" << "B" << "A", "");
+    RUN("selectItems" << "1" << "2", "true\n");
+    RUN("keys" << "CTRL+F1", "");
+    WAIT_ON_OUTPUT("read" << "DATA" << "1" << "2", "X\nY");
+    RUN("read" << "LIST" << "1" << "2", "a\na");
+    RUN("read" << "0" << "1" << "2", "A\n\nC");
+}
+
 void Tests::shortcutCommandSelectedAndCurrent()
 {
     const auto script = R"(
@@ -2863,6 +3313,24 @@ void Tests::automaticCommandStoreSpecialFormat()
     WAIT_ON_OUTPUT("separator" << "," << "read" << "test-format" << "0" << "1", "DATA,");
 }
 
+void Tests::automaticCommandSlowDoesNotBlock()
+{
+    const auto script = R"(
+        setCommands([
+            { automatic: true, input: 'test-format', cmd: 'copyq: sleep(15000)' },
+        ])
+        )";
+    RUN(script, "");
+    RUN("config" << "max_running_commands" << "1", "1\n");
+
+    TEST( m_test->setClipboard("SLOW", "test-format") );
+    waitFor(waitMsSetClipboard);
+
+    // Next clipboard change is stored while the previous handler still runs.
+    TEST( m_test->setClipboard("FAST") );
+    WAIT_ON_OUTPUT("read" << "0", "FAST");
+}
+
 void Tests::automaticCommandIgnoreSpecialFormat()
 {
     const auto script = R"(
@@ -3319,3 +3787,29 @@ int runTests(int argc, char *argv[])
 
     return exitCode;
 }
+
+int runBenchmarks(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    Q_UNUSED(app);
+
+    const QString session = "copyq.test";
+    QCoreApplication::setOrganizationName(session);
+    QCoreApplication::setApplicationName(session);
+    Settings::canModifySettings = true;
+    createPlatformNativeInterface()->loadSettings();
+
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i)
+        arguments.append( QString::fromUtf8(argv[i]) );
+
+    // Print machine-readable results unless other output is requested.
+    const QRegExp outputArgument("-(o|txt|csv|xml|lightxml|xunitxml|teamcity|tap)");
+    if ( arguments.indexOf(outputArgument) == -1 )
+        arguments.append("-csv");
+
+    std::shared_ptr<TestInterfaceImpl> test(new TestInterfaceImpl);
+    test->setupTest("CORE", QVariant());
+    Benchmarks bc(test);
+    return QTest::qExec(&bc, arguments);
+}
@@ -46,6 +46,11 @@ private slots:
 
     void commandHelp();
     void commandVersion();
+    void commandTrace();
+    void commandMetrics();
+    void memoryBudget();
+    void memoryBudgetExcludesMappedData();
+    void memoryBudgetKeepsClipboardTab();
     void badCommand();
     void badSessionName();
 
@@ -81,6 +86,12 @@ private slots:
     void commandDialogCloseOnDisconnect();
 
     void commandsPackUnpack();
+    void serializeDataVersions();
+    void mimeAtomLimit();
+    void textDataPreview();
+    void textDataChunks();
+    void cachedLabelSameHash();
+    void clipboardSnapshotDropsStaleData();
     void commandsBase64();
     void commandsGetSetItem();
 
@@ -168,10 +179,14 @@ private slots:
 
     void clipboardToItem();
     void itemToClipboard();
+    void pasteAfterClipboardProviderIdle();
     void tabAdd();
+    void tabMappedSaveAndReload();
+    void tabMappedCopyToClipboard();
     void tabRemove();
     void tabIcon();
     void action();
+    void actionQueue();
     void insertRemoveItems();
     void renameTab();
     void importExportTab();
@@ -207,11 +222,14 @@ private slots:
     void shortcutCommandOverrideEnter();
     void shortcutCommandMatchInput();
     void shortcutCommandMatchCmd();
+    void shortcutCommandMatchCmdCached();
+    void shortcutCommandMatchCmdConcurrent();
 
     void shortcutCommandSelectedItemData();
     void shortcutCommandSetSelectedItemData();
     void shortcutCommandSelectedItemsData();
     void shortcutCommandSetSelectedItemsData();
+    void shortcutCommandPatchSelectedItemsData();
     void shortcutCommandSelectedAndCurrent();
 
     void automaticCommandIgnore();
@@ -225,6 +243,7 @@ private slots:
     void automaticCommandCopyToTab();
     void automaticCommandStoreSpecialFormat();
     void automaticCommandIgnoreSpecialFormat();
+    void automaticCommandSlowDoesNotBlock();
 
     void scriptCommandLoaded();
     void scriptCommandAddFunction();
@@ -269,4 +288,6 @@ private:
 
 int runTests(int argc, char *argv[]);
 
+int runBenchmarks(int argc, char *argv[]);
+
 #endif // TESTS_H